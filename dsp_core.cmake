@@ -0,0 +1,96 @@
+# Hardware-independent DSP core.
+#
+# Shared by the firmware (CMakeLists.txt) and the native host build
+# (host/CMakeLists.txt). Nothing in here may include Pico SDK headers.
+
+# --- Analysis size ---
+set(PICO_SPECTRUM_FFT_SIZE 256 CACHE STRING
+    "Analysis FFT size in samples (128, 256, 512, 1024 or 2048)")
+set_property(CACHE PICO_SPECTRUM_FFT_SIZE PROPERTY STRINGS 128 256 512 1024 2048)
+
+if(NOT PICO_SPECTRUM_FFT_SIZE MATCHES "^(128|256|512|1024|2048)$")
+    message(FATAL_ERROR
+        "PICO_SPECTRUM_FFT_SIZE must be 128, 256, 512, 1024 or 2048 "
+        "(got ${PICO_SPECTRUM_FFT_SIZE})")
+endif()
+message(STATUS "Analysis FFT size: ${PICO_SPECTRUM_FFT_SIZE}")
+
+# --- Sample rate ---
+set(PICO_SPECTRUM_SAMPLE_RATE 44100 CACHE STRING "ADC sample rate in Hz")
+if(NOT PICO_SPECTRUM_SAMPLE_RATE MATCHES "^[0-9]+$")
+    message(FATAL_ERROR "PICO_SPECTRUM_SAMPLE_RATE must be an integer in Hz")
+endif()
+
+# --- Audio block size (monitoring latency) ---
+set(PICO_SPECTRUM_AUDIO_BLOCK 32 CACHE STRING
+    "ADC/effect/PWM block size in samples (power of two, 8..FFT size)")
+if(NOT PICO_SPECTRUM_AUDIO_BLOCK MATCHES "^(8|16|32|64|128|256|512|1024|2048)$"
+   OR PICO_SPECTRUM_AUDIO_BLOCK GREATER PICO_SPECTRUM_FFT_SIZE)
+    message(FATAL_ERROR
+        "PICO_SPECTRUM_AUDIO_BLOCK must be a power of two from 8 to the FFT size "
+        "(got ${PICO_SPECTRUM_AUDIO_BLOCK})")
+endif()
+
+# --- Input channels ---
+option(PICO_SPECTRUM_STEREO "Sample both MCP3202 inputs (CH0 left, CH1 right)" ON)
+
+# --- Stage profiling hooks (prof.h) ---
+option(PICO_SPECTRUM_PROFILE "Compile in per-stage profiling" ON)
+
+# --- Build-time generated twiddle / bit-reversal / window / band tables ---
+find_package(Python3 REQUIRED COMPONENTS Interpreter)
+
+set(DSP_TABLES_DIR ${CMAKE_CURRENT_BINARY_DIR}/dsp_tables)
+set(DSP_TABLES_GEN ${CMAKE_CURRENT_LIST_DIR}/tools/gen_dsp_tables.py)
+
+add_custom_command(
+    OUTPUT ${DSP_TABLES_DIR}/dsp_tables.c ${DSP_TABLES_DIR}/dsp_tables.h
+    COMMAND ${Python3_EXECUTABLE} ${DSP_TABLES_GEN}
+            --fft-size ${PICO_SPECTRUM_FFT_SIZE}
+            --out-dir ${DSP_TABLES_DIR}
+    DEPENDS ${DSP_TABLES_GEN}
+    COMMENT "Generating DSP tables for FFT_SIZE=${PICO_SPECTRUM_FFT_SIZE}"
+)
+
+add_library(dsp_core STATIC
+    ${CMAKE_CURRENT_LIST_DIR}/src/adc_acq.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/audio_out.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/audio_path.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/audio_quant.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/capture.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/display_dyn.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/display_map.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/dsp.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/dsp_fb.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/dsp_fft.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/dsp_hop.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/dsp_log.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/dsp_time.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/dsp_fx.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/params.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/prof.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/sched.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/spsc.c
+    ${CMAKE_CURRENT_LIST_DIR}/src/telemetry.c
+    ${DSP_TABLES_DIR}/dsp_tables.c
+)
+
+target_include_directories(dsp_core PUBLIC
+    ${CMAKE_CURRENT_LIST_DIR}/src
+    ${DSP_TABLES_DIR}
+)
+
+# PUBLIC so the ADC and PWM blocks in the firmware use the same values
+target_compile_definitions(dsp_core PUBLIC
+    FFT_SIZE=${PICO_SPECTRUM_FFT_SIZE}
+    SAMPLE_RATE_HZ=${PICO_SPECTRUM_SAMPLE_RATE}
+    AUDIO_BLOCK_SIZE=${PICO_SPECTRUM_AUDIO_BLOCK}
+    ADC_CHANNELS=$<IF:$<BOOL:${PICO_SPECTRUM_STEREO}>,2,1>
+    PROF_ENABLE=$<BOOL:${PICO_SPECTRUM_PROFILE}>
+)
+
+target_compile_options(dsp_core PRIVATE
+    -Wall
+    -Wextra
+    -Werror=implicit-function-declaration
+)
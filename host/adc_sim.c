@@ -0,0 +1,188 @@
+/*
+ * adc_sim - host stand-in for the DMA/SPI side of the ADC acquisition.
+ *
+ * Produces raw blocks the way the rx DMA channel does (two 9-bit SPI
+ * frames per conversion, ADC_CHANNELS conversions per sample) from a
+ * 12-bit ramp per channel, calls adc_acq_raw_block_done() at each
+ * block boundary and runs a simulated core 1 that takes a configurable
+ * share of the block period per block, with an occasional overrun.
+ *
+ * Checks that every acquired block holds the samples of its sequence
+ * number in order in each channel's plane, that a block is not touched
+ * while core 1 holds it, and that sequence gaps match the dropped
+ * count. Also prints the DMA pacing-timer fraction for the chosen rate
+ * and clock.
+ *
+ *   adc_sim [-b blocks] [-r sample_rate_hz] [-m clk_mhz]
+ *           [-c cost_pct] [-s spike_every] [-p spike_pct]
+ */
+#include "adc_acq.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define RAMP_STEP 7   // co-prime with 4096, so blocks never repeat early
+#define RAMP_SKEW 1365  // offset of each channel's ramp from the last
+
+static uint32_t lcg_state = 0x2468ace1u;
+
+static uint16_t junk(void) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return (uint16_t)(lcg_state >> 16);
+}
+
+static int16_t ramp(uint64_t n, int chan) {
+    return (int16_t)((n * RAMP_STEP + (uint64_t)chan * RAMP_SKEW) & 0x0FFF) - 2048;
+}
+
+// Fill raw block k as the SPI FIFO would: frame 1 is whatever the
+// MCP3202 drives while the command goes in, then the null bit and
+// B11..B8; frame 2 is B7..B0 and one trailing bit
+static void fill_raw_block(uint64_t k) {
+    uint16_t *raw = adc_raw_ring[k & (ADC_RAW_BLOCKS - 1)];
+
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+        for (int c = 0; c < ADC_CHANNELS; c++) {
+            uint16_t code = (uint16_t)(ramp(k * AUDIO_BLOCK_SIZE + i, c) + 2048);
+            uint16_t *f = &raw[i * ADC_FRAMES_PER_PERIOD + c * ADC_FRAMES_PER_SAMPLE];
+            f[0] = (uint16_t)((junk() & 0x1E0) | (code >> 8));
+            f[1] = (uint16_t)(((code & 0xFF) << 1) | (junk() & 1));
+        }
+}
+
+static int check_block(const int16_t *b, uint32_t seq) {
+    int errors = 0;
+    for (int c = 0; c < ADC_CHANNELS; c++)
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+            if (b[c * AUDIO_BLOCK_SIZE + i] != ramp((uint64_t)seq * AUDIO_BLOCK_SIZE + i, c))
+                errors++;
+    return errors;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+        "usage: %s [-b blocks] [-r sample_rate_hz] [-m clk_mhz]\n"
+        "          [-c cost_pct] [-s spike_every] [-p spike_pct]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    long nblocks = 10000;
+    long rate_hz = SAMPLE_RATE_HZ;
+    long clk_mhz = 125;
+    long cost_pct = 60;         // core-1 time per block, % of block period
+    long spike_every = 97;      // every Nth block overruns...
+    long spike_pct = 350;       // ...by this much
+
+    int opt;
+    while ((opt = getopt(argc, argv, "b:r:m:c:s:p:")) != -1) {
+        switch (opt) {
+            case 'b': nblocks = atol(optarg); break;
+            case 'r': rate_hz = atol(optarg); break;
+            case 'm': clk_mhz = atol(optarg); break;
+            case 'c': cost_pct = atol(optarg); break;
+            case 's': spike_every = atol(optarg); break;
+            case 'p': spike_pct = atol(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (nblocks < 1 || rate_hz < 1 || clk_mhz < 1 || cost_pct < 0 ||
+        spike_every < 0 || spike_pct < 0)
+        usage(argv[0]);
+
+    /* ---------- Pacing timer ---------- */
+
+    uint16_t x, y;
+    uint32_t clk_hz = (uint32_t)clk_mhz * 1000000u;
+    uint32_t got = adc_acq_timer_fraction(clk_hz, (uint32_t)rate_hz, &x, &y);
+    double exact = (double)clk_hz * x / y;
+
+    printf("AUDIO_BLOCK_SIZE=%d  channels=%d  raw blocks=%d  sample blocks=%d\n",
+           AUDIO_BLOCK_SIZE, ADC_CHANNELS, ADC_RAW_BLOCKS, ADC_NUM_BLOCKS);
+    printf("pacing timer: %u MHz * %u / %u = %.3f Hz (%+.1f ppm re %ld Hz)\n",
+           (unsigned)clk_mhz, x, y, exact,
+           (exact - rate_hz) * 1e6 / rate_hz, rate_hz);
+    if (ADC_CHANNELS > 1)
+        printf("ADC pacing: %u / %u, %d conversions per sample\n",
+               (unsigned)(x * ADC_CHANNELS), y, ADC_CHANNELS);
+    printf("SPI clock needed: %.3f MHz\n",
+           (double)got * ADC_CLOCKS_PER_SAMPLE * ADC_CHANNELS / 1e6);
+
+    /* ---------- Acquisition ---------- */
+
+    // time in samples; block k completes at (k + 1) * AUDIO_BLOCK_SIZE
+    double period = AUDIO_BLOCK_SIZE;
+    bool busy = false;
+    double free_at = 0.0, busy_end = 0.0;
+    const int16_t *held = NULL;
+    uint32_t held_seq = 0;
+    int64_t last_seq = -1;
+    uint64_t gaps = 0, acquired = 0, errors = 0, clobbered = 0;
+    double max_latency = 0.0;
+
+    adc_acq_init();
+
+    for (long k = 0; k < nblocks; k++) {
+        fill_raw_block((uint64_t)k);
+        adc_acq_raw_block_done();
+
+        double t = (k + 1) * period;
+        double t_next = t + period;
+
+        // run core 1 up to the next block boundary
+        for (;;) {
+            if (busy) {
+                if (busy_end > t_next) break;
+                if (check_block(held, held_seq)) clobbered++;
+                adc_release_block();
+                busy = false;
+                free_at = busy_end;
+            }
+
+            held = adc_acquire_block();
+            if (!held) break;
+            held_seq = adc_block_seq();
+            acquired++;
+
+            if (held_seq <= last_seq) errors++;
+            else gaps += held_seq - last_seq - 1;
+            last_seq = held_seq;
+            errors += check_block(held, held_seq) ? 1 : 0;
+
+            double start = free_at > t ? free_at : t;
+            double ready = (held_seq + 1.0) * period;
+            if (start - ready > max_latency) max_latency = start - ready;
+
+            long pct = cost_pct;
+            if (spike_every && held_seq % spike_every == spike_every - 1)
+                pct = spike_pct;
+            busy = true;
+            busy_end = start + period * pct / 100.0;
+        }
+    }
+
+    uint32_t dropped = adc_dropped_blocks();
+    uint64_t produced = (uint64_t)nblocks;
+    uint64_t pending = produced - acquired - dropped;
+    // blocks after the last one acquired are either pending or dropped
+    uint64_t tail_drops = (uint64_t)((int64_t)produced - 1 - last_seq) - pending;
+
+    printf("\nblocks: %llu produced, %llu acquired, %u dropped, %u late, %llu pending\n",
+           (unsigned long long)produced, (unsigned long long)acquired,
+           dropped, adc_late_blocks(), (unsigned long long)pending);
+    printf("sequence gaps: %llu (+%llu after the last block)  bad blocks: %llu  "
+           "overwritten while held: %llu\n",
+           (unsigned long long)gaps, (unsigned long long)tail_drops,
+           (unsigned long long)errors,
+           (unsigned long long)clobbered);
+    printf("worst block latency: %.2f ms\n", max_latency * 1000.0 / rate_hz);
+
+    bool ok = errors == 0 && clobbered == 0 && gaps + tail_drops == dropped &&
+              pending < ADC_NUM_BLOCKS;
+    printf("%s\n", ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,476 @@
+/*
+ * dsp_batch - offline analyzer: runs WAV files through the core-1 path.
+ *
+ * Each file is mixed down to mono, scaled to the 12-bit signed samples
+ * the ADC ring delivers and run through dsp_time_process as a stream,
+ * while FFT_SIZE analysis windows, -h samples apart (default half a
+ * window), go through dsp_process with the -w window, as the firmware
+ * does. The band levels then go through the display dynamics with
+ * their default settings (display_dyn.c), one display frame per window,
+ * to the 16x16 frame the matrix would show.
+ *
+ * With -o, per input file <name>:
+ *   <name>.bands.csv   window, start time and the NUM_BANDS levels in dBFS
+ *   <name>.out.wav     effect output, 16-bit mono
+ *   <name>.frames      per window LED_HEIGHT rows of uint16 LE, bit x of
+ *                      row y is pixel (x, y)
+ *
+ * Every window is also checked against a double-precision FFT of the
+ * same 12-bit input and window, with the same bin -> band mapping: the
+ * report has mean/max error per band (bands more than 60 dB below the
+ * loudest are in the fixed-point noise floor and are not compared) and
+ * how many display columns came out a different height in the fixed dB
+ * window (display_map_db()).
+ *
+ * dsp.c and dsp_time.c keep their state in statics, as on the device,
+ * so files run in forked worker processes (-j, default one per CPU)
+ * rather than threads. Workers send their results back over a pipe.
+ *
+ *   dsp_batch [-j jobs] [-o outdir] [-m mix] [-B] [-w rect|hann|blackman]
+ *             [-h hop] [-e max_band_err_db] file.wav...
+ *
+ * Exit status 1 if a file could not be read or written, 2 if a band
+ * error went over -e.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "dsp.h"
+#include "dsp_log.h"
+#include "dsp_tables.h"
+#include "dsp_time.h"
+#include "display_dyn.h"
+#include "display_map.h"
+#include "params.h"
+#include "wav.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BLOCK_SIZE FFT_SIZE
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Same reference conventions as dsp_bench
+#define FULL_SCALE_BIN (32768.0 * BLOCK_SIZE / 2)
+#define BAND_FLOOR_DB  60.0
+
+typedef struct {
+    uint32_t n;
+    double   sum;
+    double   max;
+} band_err_t;
+
+// One worker's result; well under PIPE_BUF so pipe writes are atomic
+typedef struct {
+    int        index;           // into the file list
+    int        status;          // 0 ok, else errno-style failure
+    char       what[64];        // what failed
+    uint32_t   rate;
+    uint32_t   blocks;          // analysis windows
+    uint64_t   samples;
+    uint32_t   col_mismatch;    // display columns differing from the reference
+    double     seconds;         // wall time of the worker
+    band_err_t err[NUM_BANDS];
+} result_t;
+
+typedef struct {
+    const char *outdir;
+    int16_t     mix_q15;
+    bool        bypass;
+    dsp_window_t window;
+    int         hop;
+} options_t;
+
+static const char *const window_names[DSP_WINDOW_COUNT] = {
+    [DSP_WINDOW_RECT]     = "rect",
+    [DSP_WINDOW_HANN]     = "hann",
+    [DSP_WINDOW_BLACKMAN] = "blackman",
+};
+
+/* ---------- Double-precision reference ---------- */
+
+static double ref_re[BLOCK_SIZE];
+static double ref_im[BLOCK_SIZE];
+static double ref_window[BLOCK_SIZE];
+static double ref_loss_db;         // power the window takes off a sine
+
+static void ref_init(dsp_window_t window) {
+    double energy = 0.0;
+    for (int n = 0; n < BLOCK_SIZE; n++) {
+        double a = 2.0 * M_PI * n / BLOCK_SIZE;
+        double w = 1.0;
+        if (window == DSP_WINDOW_HANN) w = 0.5 - 0.5 * cos(a);
+        if (window == DSP_WINDOW_BLACKMAN) w = 0.42 - 0.5 * cos(a) + 0.08 * cos(2.0 * a);
+        ref_window[n] = w;
+        energy += w * w;
+    }
+    ref_loss_db = 10.0 * log10(BLOCK_SIZE / energy);
+}
+
+// In-place radix-2 FFT of ref_re/ref_im (BLOCK_SIZE is a power of two)
+static void ref_fft(void) {
+    for (int i = 1, j = 0; i < BLOCK_SIZE; i++) {
+        int bit = BLOCK_SIZE >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            double t = ref_re[i]; ref_re[i] = ref_re[j]; ref_re[j] = t;
+            t = ref_im[i]; ref_im[i] = ref_im[j]; ref_im[j] = t;
+        }
+    }
+    for (int len = 2; len <= BLOCK_SIZE; len <<= 1) {
+        double a = -2.0 * M_PI / len;
+        for (int i = 0; i < BLOCK_SIZE; i += len) {
+            for (int k = 0; k < len / 2; k++) {
+                double wr = cos(a * k), wi = sin(a * k);
+                int p = i + k, q = p + len / 2;
+                double xr = ref_re[q] * wr - ref_im[q] * wi;
+                double xi = ref_re[q] * wi + ref_im[q] * wr;
+                ref_re[q] = ref_re[p] - xr;
+                ref_im[q] = ref_im[p] - xi;
+                ref_re[p] += xr;
+                ref_im[p] += xi;
+            }
+        }
+    }
+}
+
+// Bands in dBFS for one 12-bit window, mapped as dsp_process does
+static void ref_bands(const int16_t *in, double *out) {
+    for (int n = 0; n < BLOCK_SIZE; n++) {
+        ref_re[n] = (double)(in[n] << 4) * ref_window[n];
+        ref_im[n] = 0.0;
+    }
+    ref_fft();
+
+    double acc[NUM_BANDS] = { 0 };
+    for (int i = 1; i < BLOCK_SIZE / 2; i++)
+        acc[dsp_band_map[i]] += ref_re[i] * ref_re[i] + ref_im[i] * ref_im[i];
+    for (int b = 0; b < NUM_BANDS; b++)
+        out[b] = acc[b] > 0.0 ? 10.0 * log10(acc[b]) - 20.0 * log10(FULL_SCALE_BIN)
+                                + ref_loss_db
+                              : -1000.0;
+}
+
+/* ---------- One file (runs in a worker) ---------- */
+
+// outdir/<input name without .wav><ext>
+static void out_path(const options_t *opt, const char *path, const char *ext,
+                     char *name, size_t size) {
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    size_t len = strlen(base);
+    if (len > 4 && !strcmp(base + len - 4, ".wav")) len -= 4;
+    snprintf(name, size, "%s/%.*s%s", opt->outdir, (int)len, base, ext);
+}
+
+static void fail(result_t *res, int err, const char *what) {
+    if (res->status) return;
+    res->status = err ? err : EIO;
+    snprintf(res->what, sizeof(res->what), "%.*s", (int)sizeof(res->what) - 1, what);
+}
+
+static void analyze(const options_t *opt, const char *path, result_t *res) {
+    static int16_t pcm[BLOCK_SIZE];
+    static int16_t in[BLOCK_SIZE];
+    static int16_t out[BLOCK_SIZE];
+    static int16_t wav_out[BLOCK_SIZE];
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    wav_reader_t r;
+    errno = 0;
+    if (wav_open_read(&r, path) != 0) {
+        fail(res, errno, errno == ENOTSUP ? "unsupported format" : "read");
+        return;
+    }
+    res->rate = r.rate;
+
+    FILE *csv = NULL, *frames = NULL;
+    wav_writer_t w = { 0 };
+    if (opt->outdir) {
+        char name[4096];
+        out_path(opt, path, ".bands.csv", name, sizeof(name));
+        if (!(csv = fopen(name, "w"))) fail(res, errno, name);
+        out_path(opt, path, ".frames", name, sizeof(name));
+        if (!(frames = fopen(name, "wb"))) fail(res, errno, name);
+        out_path(opt, path, ".out.wav", name, sizeof(name));
+        if (wav_open_write(&w, name, r.rate, 1) != 0) fail(res, errno, name);
+    }
+    if (csv) {
+        fprintf(csv, "window,time_s");
+        for (int b = 0; b < NUM_BANDS; b++) fprintf(csv, ",band%d", b);
+        fprintf(csv, "\n");
+    }
+
+    display_dyn_config_t dyn_cfg;
+    display_dyn_t dyn;
+    params_init();
+    display_dyn_config_params(&dyn_cfg);
+    display_dyn_init(&dyn, &dyn_cfg);
+
+    dsp_init();
+    dsp_time_init();
+    dsp_set_window(opt->window);
+    ref_init(opt->window);
+
+    // The first window takes a whole FFT_SIZE, each later one the hop
+    // newest samples, with the rest moved up from the last window
+    long n = 0;
+    int want = BLOCK_SIZE;
+    while (!res->status && (n = wav_read_mono(&r, pcm, want)) > 0) {
+        // 16-bit PCM → 12-bit signed, as the ADC ring delivers it;
+        // a short last read is padded with silence
+        int16_t *fresh = in + BLOCK_SIZE - want;
+        memmove(in, in + want, (size_t)(BLOCK_SIZE - want) * sizeof(*in));
+        for (int i = 0; i < want; i++)
+            fresh[i] = i < n ? (int16_t)(pcm[i] >> 4) : 0;
+
+        dsp_process(in);
+        dsp_time_process(fresh, out, want, opt->mix_q15, opt->bypass);
+
+        // Display: fixed-point bands and the reference through the same map
+        double ref[NUM_BANDS], ref_max = -1000.0;
+        int16_t ref_q8[NUM_BANDS];
+        ref_bands(in, ref);
+        for (int b = 0; b < NUM_BANDS; b++) {
+            if (ref[b] > ref_max) ref_max = ref[b];
+            double q8 = floor(ref[b] * 256.0 + 0.5);
+            ref_q8[b] = (int16_t)(q8 < DB_FLOOR_Q8 ? DB_FLOOR_Q8 : q8);
+        }
+
+        uint8_t heights[LED_COLUMNS], ref_heights[LED_COLUMNS];
+        display_map_db(band_levels, NUM_BANDS, heights);
+        display_map_db(ref_q8, NUM_BANDS, ref_heights);
+        for (int c = 0; c < LED_COLUMNS; c++)
+            if (heights[c] != ref_heights[c]) res->col_mismatch++;
+
+        for (int b = 0; b < NUM_BANDS; b++) {
+            if (ref[b] < ref_max - BAND_FLOOR_DB || ref[b] * 256.0 < DB_FLOOR_Q8)
+                continue;
+            double e = fabs(band_levels[b] / 256.0 - ref[b]);
+            res->err[b].n++;
+            res->err[b].sum += e;
+            if (e > res->err[b].max) res->err[b].max = e;
+        }
+
+        if (csv) {
+            fprintf(csv, "%u,%.6f", res->blocks,
+                    (double)(res->samples + (uint64_t)want - BLOCK_SIZE) / r.rate);
+            for (int b = 0; b < NUM_BANDS; b++)
+                fprintf(csv, ",%.2f", band_levels[b] / 256.0);
+            fprintf(csv, "\n");
+        }
+        if (frames) {
+            uint16_t fb[LED_HEIGHT] = { 0 };
+            uint8_t bars[LED_COLUMNS], peaks[LED_COLUMNS], row[2];
+            uint32_t t_us = (uint32_t)(res->samples * 1000000u / r.rate);
+            display_dyn_step(&dyn, band_levels, NUM_BANDS, t_us, bars, peaks);
+            display_raster_bars(bars, fb);
+            display_raster_peaks(peaks, fb);
+            for (int y = 0; y < LED_HEIGHT; y++) {
+                row[0] = (uint8_t)fb[y];
+                row[1] = (uint8_t)(fb[y] >> 8);
+                if (fwrite(row, sizeof(row), 1, frames) != 1) fail(res, errno, "frames");
+            }
+        }
+        if (w.f) {
+            // 12-bit effect output back to 16-bit, without the padding
+            for (int i = 0; i < n; i++) wav_out[i] = (int16_t)(out[i] * 16);
+            if (wav_write(&w, wav_out, (size_t)n) != 0) fail(res, errno, "out.wav");
+        }
+        res->blocks++;
+        res->samples += (uint64_t)n;
+        want = opt->hop;
+    }
+    if (n < 0) fail(res, EIO, "read");
+
+    wav_close_read(&r);
+    if (csv && fclose(csv) != 0) fail(res, errno, "bands.csv");
+    if (frames && fclose(frames) != 0) fail(res, errno, "frames");
+    if (w.f && wav_close(&w) != 0) fail(res, errno, "out.wav");
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    res->seconds = (double)(t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+}
+
+/* ---------- Worker pool ---------- */
+
+static pid_t spawn(const options_t *opt, char **files, int index, int fd) {
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid == 0) {
+        result_t res;
+        memset(&res, 0, sizeof(res));
+        res.index = index;
+        analyze(opt, files[index], &res);
+        _exit(write(fd, &res, sizeof(res)) == (ssize_t)sizeof(res) ? 0 : 1);
+    }
+    return pid;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [-j jobs] [-o outdir] [-m mix] [-B] [-w rect|hann|blackman]\n"
+            "          [-h hop] [-e max_band_err_db] file.wav...\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
+    options_t opt = { NULL, Q15(0.7), false, DSP_WINDOW_HANN, BLOCK_SIZE / 2 };
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    double max_err = 0.0;   // 0 = report only
+    int i;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (!strcmp(argv[i], "-j") && i + 1 < argc)      jobs = atol(argv[++i]);
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) opt.outdir = argv[++i];
+        else if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+            double m = atof(argv[++i]);
+            if (m < 0.0 || m > 1.0) { usage(argv[0]); return 1; }
+            opt.mix_q15 = Q15(m);
+        }
+        else if (!strcmp(argv[i], "-B"))                 opt.bypass = true;
+        else if (!strcmp(argv[i], "-w") && i + 1 < argc) {
+            const char *name = argv[++i];
+            int w = 0;
+            while (w < DSP_WINDOW_COUNT && strcmp(window_names[w], name)) w++;
+            if (w == DSP_WINDOW_COUNT) { usage(argv[0]); return 1; }
+            opt.window = (dsp_window_t)w;
+        }
+        else if (!strcmp(argv[i], "-h") && i + 1 < argc) opt.hop = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-e") && i + 1 < argc) max_err = atof(argv[++i]);
+        else { usage(argv[0]); return 1; }
+    }
+    char **files = argv + i;
+    int nfiles = argc - i;
+    if (nfiles == 0 || max_err < 0.0 || opt.hop < 1 || opt.hop > BLOCK_SIZE) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (jobs < 1) jobs = 1;
+    if (jobs > nfiles) jobs = nfiles;
+
+    int fds[2];
+    if (pipe(fds) != 0) { perror("pipe"); return 1; }
+
+    result_t *results = calloc((size_t)nfiles, sizeof(*results));
+    pid_t *pids = calloc((size_t)nfiles, sizeof(*pids));
+    if (!results || !pids) { perror("calloc"); return 1; }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    // Keep up to jobs workers running. A worker writes its result
+    // before it exits cleanly, so every clean exit has one result
+    // waiting in the pipe (not necessarily its own).
+    int next = 0, running = 0;
+    while (running > 0 || next < nfiles) {
+        while (running < jobs && next < nfiles) {
+            pids[next] = spawn(&opt, files, next, fds[1]);
+            if (pids[next] < 0) { perror("fork"); return 1; }
+            next++;
+            running++;
+        }
+
+        int ws;
+        pid_t pid = wait(&ws);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            perror("wait");
+            return 1;
+        }
+        running--;
+
+        if (!WIFEXITED(ws) || WEXITSTATUS(ws) != 0) {
+            for (int f = 0; f < next; f++)
+                if (pids[f] == pid) fprintf(stderr, "%s: worker died\n", files[f]);
+            return 1;
+        }
+
+        result_t res;
+        if (read(fds[0], &res, sizeof(res)) != (ssize_t)sizeof(res) ||
+            res.index < 0 || res.index >= nfiles) {
+            fprintf(stderr, "short result from worker\n");
+            return 1;
+        }
+        results[res.index] = res;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    /* ---------- Report ---------- */
+
+    int status = 0;
+    uint32_t total_blocks = 0, total_mismatch = 0;
+    double cpu_seconds = 0.0, audio_seconds = 0.0;
+    band_err_t total[NUM_BANDS] = { 0 };
+
+    printf("window %s, hop %d of %d\n\n", window_names[opt.window], opt.hop, BLOCK_SIZE);
+    printf("%-32s %8s %8s %10s %10s %8s\n",
+           "file", "rate", "windows", "mean err", "max err", "columns");
+    printf("%-32s %8s %8s %10s %10s %8s\n",
+           "", "(Hz)", "", "(dB)", "(dB)", "off");
+
+    for (int f = 0; f < nfiles; f++) {
+        const result_t *res = &results[f];
+        if (res->status) {
+            fprintf(stderr, "%s: %s: %s\n", files[f], res->what, strerror(res->status));
+            status = 1;
+            continue;
+        }
+
+        uint32_t n = 0;
+        double sum = 0.0, max = 0.0;
+        for (int b = 0; b < NUM_BANDS; b++) {
+            n += res->err[b].n;
+            sum += res->err[b].sum;
+            if (res->err[b].max > max) max = res->err[b].max;
+            total[b].n += res->err[b].n;
+            total[b].sum += res->err[b].sum;
+            if (res->err[b].max > total[b].max) total[b].max = res->err[b].max;
+        }
+        printf("%-32s %8u %8u %10.4f %10.4f %7.2f%%%s\n",
+               files[f], res->rate, res->blocks, n ? sum / n : 0.0, max,
+               res->blocks ? 100.0 * res->col_mismatch / (res->blocks * LED_COLUMNS) : 0.0,
+               res->rate != SAMPLE_RATE_HZ ? "  (rate differs from build)" : "");
+
+        total_blocks += res->blocks;
+        total_mismatch += res->col_mismatch;
+        cpu_seconds += res->seconds;
+        audio_seconds += res->rate ? (double)res->samples / res->rate : 0.0;
+    }
+
+    printf("\nper band vs double FFT (bands within %.0f dB of the loudest)\n", BAND_FLOOR_DB);
+    printf("%-6s %10s %10s %10s\n", "band", "windows", "mean (dB)", "max (dB)");
+    double worst = 0.0;
+    for (int b = 0; b < NUM_BANDS; b++) {
+        printf("%-6d %10u %10.4f %10.4f\n", b, total[b].n,
+               total[b].n ? total[b].sum / total[b].n : 0.0, total[b].max);
+        if (total[b].max > worst) worst = total[b].max;
+    }
+
+    double wall = (double)(t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    printf("\n%d files, %u windows (%.1f s of audio), display columns off %.2f%%\n",
+           nfiles, total_blocks, audio_seconds,
+           total_blocks ? 100.0 * total_mismatch / ((double)total_blocks * LED_COLUMNS) : 0.0);
+    printf("%ld jobs, %.2f s wall, %.2f s worker time\n", jobs, wall, cpu_seconds);
+
+    if (max_err > 0.0 && worst > max_err) {
+        printf("\nFAIL: band error %.4f dB over %g dB\n", worst, max_err);
+        if (!status) status = 2;
+    }
+    free(pids);
+    free(results);
+    return status;
+}
@@ -0,0 +1,1303 @@
+/*
+ * dsp_bench - host throughput benchmark for the core-1 DSP kernels.
+ *
+ * Runs fft_real, dsp_process, dsp_process_stereo (L/R view), the
+ * dsp_fb_process filterbank and dsp_time_process over synthetic 12-bit
+ * blocks and reports ns/block, blocks/sec, cycles-equivalent at the
+ * target clock and the share of one block period that each kernel uses.
+ *
+ * It then runs the core-1 work through the prof.h hooks, as the
+ * firmware does (audio blocks from the output ISR, then the analysis
+ * window), and reports per-stage min/mean/max, percentiles and deadline
+ * misses. With -b, windows or audio blocks slower than that share of
+ * their period count as misses, and more than 1% misses fails the run
+ * (exit status 2), so scripts can hold the kernels to a budget.
+ *
+ * Finally it checks fft_real and the dsp_process band output against a
+ * double-precision DFT of the same input, and the Q15 effect path
+ * against its float reference, compares the leakage of the analysis
+ * windows, compares the two analysis engines (cost per second of audio,
+ * level and rise time per band), checks the stereo views against the
+ * reference and their cost against two mono windows, checks each effect
+ * chain module against its float reference and reports its host time,
+ * measures the output step that live parameter changes leave,
+ * measures the PWM requantization noise with and without noise shaping
+ * at several PWM ranges, and compares the display dynamics (core 0)
+ * with the plain dB window: rows lit, frame-to-frame flicker, peak
+ * hold and cost per frame. Each of these checks holds its results to
+ * tolerances (costs are only reported): one out of tolerance prints
+ * FAIL, and the run exits with status 3. With -t only the named check
+ * runs, without the throughput table or the profile, so each can be
+ * run and fail on its own; host/CMakeLists.txt registers each with
+ * ctest.
+ *
+ * Host numbers are not RP2040 numbers: they are for comparing one build
+ * of the kernels against another on the same machine.
+ *
+ *   dsp_bench [-n iterations] [-r sample_rate_hz] [-m target_mhz] [-b budget_pct]
+ *             [-t accuracy|time|windows|engines|stereo|fx|changes|pwm|display]
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include "display_dyn.h"
+#include "dsp.h"
+#include "dsp_fb.h"
+#include "dsp_fft.h"
+#include "dsp_fx.h"
+#include "dsp_fx_ref.h"
+#include "dsp_log.h"
+#include "prof.h"
+#include "dsp_tables.h"
+#include "dsp_time.h"
+#include "dsp_time_ref.h"
+#include "audio_quant.h"
+#include "params.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BLOCK_SIZE   FFT_SIZE
+#define NUM_BLOCKS   64    // distinct input blocks cycled per signal
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* ---------- Synthetic inputs (12-bit signed, like the ADC) ---------- */
+
+typedef enum {
+    SIG_SWEEP,
+    SIG_NOISE,
+    SIG_DC,
+    SIG_SQUARE,
+    SIG_COUNT
+} signal_t;
+
+static const char *signal_names[SIG_COUNT] = {
+    "sine sweep", "white noise", "dc", "square fs",
+};
+
+// One spare at the end, so a stereo kernel can take the block after
+// its own as the right channel
+static int16_t blocks[NUM_BLOCKS + 1][BLOCK_SIZE];
+
+static uint32_t lcg_state = 0x12345678u;
+
+static int16_t noise12(void) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return (int16_t)((int32_t)(lcg_state >> 20) - 2048);
+}
+
+static void fill_blocks(signal_t sig) {
+    double phase = 0.0;
+
+    for (int b = 0; b < NUM_BLOCKS; b++) {
+        // sweep one bin per block, from bin 1 up towards Nyquist
+        double freq = (double)(1 + b * (BLOCK_SIZE / 2 - 2) / NUM_BLOCKS) / BLOCK_SIZE;
+
+        for (int i = 0; i < BLOCK_SIZE; i++) {
+            int v = 0;
+            switch (sig) {
+                case SIG_SWEEP:
+                    v = (int)lrint(2047.0 * sin(phase));
+                    phase += 2.0 * M_PI * freq;
+                    break;
+                case SIG_NOISE:  v = noise12();                       break;
+                case SIG_DC:     v = 1024;                            break;
+                case SIG_SQUARE: v = ((i / 16) & 1) ? -2048 : 2047;   break;
+                default: break;
+            }
+            blocks[b][i] = (int16_t)v;
+        }
+    }
+    memcpy(blocks[NUM_BLOCKS], blocks[0], sizeof(blocks[0]));
+}
+
+/* ---------- Kernels under test ---------- */
+
+static cpx16_t fft_in[FFT_CPX_SIZE];
+static int16_t time_out[BLOCK_SIZE];
+
+// Same packing and scaling as dsp_process
+static void load_fft(const int16_t *in) {
+    for (int i = 0; i < FFT_CPX_SIZE; i++) {
+        fft_in[i].re = in[2 * i] << 4;
+        fft_in[i].im = in[2 * i + 1] << 4;
+    }
+}
+
+static void run_fft_real(int16_t *in) {
+    load_fft(in);
+    fft_real(fft_in);
+}
+
+static void run_dsp_process(int16_t *in) {
+    dsp_process(in);
+}
+
+// in is left, the next block right
+static void run_dsp_process_stereo(int16_t *in) {
+    dsp_process_stereo(in, DSP_VIEW_LR);
+}
+
+static void run_dsp_fb_process(int16_t *in) {
+    dsp_fb_process(in, BLOCK_SIZE);
+}
+
+#define BENCH_MIX 0.7f
+
+static void run_dsp_time_process(int16_t *in) {
+    dsp_time_process(in, time_out, BLOCK_SIZE, Q15(BENCH_MIX), false);
+}
+
+static void run_dsp_time_ref(int16_t *in) {
+    dsp_time_ref_process(in, time_out, BLOCK_SIZE, BENCH_MIX, false);
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(int16_t *in);
+} kernel_t;
+
+static const kernel_t kernels[] = {
+    { "fft_real",         run_fft_real         },
+    { "dsp_process",      run_dsp_process      },
+    { "dsp_process_stereo", run_dsp_process_stereo },
+    { "dsp_fb_process",   run_dsp_fb_process   },
+    { "dsp_time_process", run_dsp_time_process },
+    { "dsp_time_ref",     run_dsp_time_ref     },
+};
+
+/* ---------- Timing ---------- */
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Keep the optimizer from discarding kernel results
+static volatile int32_t sink;
+
+static double time_kernel(const kernel_t *k, int iterations) {
+    // warm caches and filter state
+    for (int b = 0; b < NUM_BLOCKS; b++) k->run(blocks[b]);
+
+    uint64_t t0 = now_ns();
+    for (int n = 0; n < iterations; n++)
+        k->run(blocks[n % NUM_BLOCKS]);
+    uint64_t t1 = now_ns();
+
+    sink = time_out[0] + fft_in[1].re + (int32_t)band_levels[1];
+    return (double)(t1 - t0) / iterations;
+}
+
+/* ---------- Tolerances ---------- */
+
+static void fail(const char *what, va_list ap, double v, const char *bound, double limit) {
+    printf("FAIL: ");
+    vprintf(what, ap);
+    printf(" %.4g, %s %.4g\n", v, bound, limit);
+}
+
+// Print a FAIL line naming what (printf format) if err is over tol, or
+// v under min; return whether it is in bounds
+static bool within(double err, double tol, const char *what, ...) {
+    if (err <= tol) return true;
+    va_list ap;
+    va_start(ap, what);
+    fail(what, ap, err, "tolerance", tol);
+    va_end(ap);
+    return false;
+}
+
+static bool at_least(double v, double min, const char *what, ...) {
+    if (v >= min) return true;
+    va_list ap;
+    va_start(ap, what);
+    fail(what, ap, v, "at least", min);
+    va_end(ap);
+    return false;
+}
+
+/* ---------- Per-block profile through the prof.h hooks ---------- */
+
+#define BUDGET_MISS_PCT 1.0
+
+static const prof_stage_t block_stages[] = {
+    PROF_DSP_PROCESS, PROF_CORE1_BLOCK,
+    PROF_DSP_TIME, PROF_FX0, PROF_AUDIO_PLAY, PROF_AUDIO_BLOCK,
+};
+
+// Returns false if the window or audio block budget was missed too often
+static bool profile_blocks(int iterations, double period_ns, double budget_pct) {
+    static uint16_t levels[AUDIO_BLOCK_SIZE];
+    audio_quant_t quant;
+
+    prof_clock_init();
+    double tick_ns = 1e9 / prof_tick_hz();
+    prof_set_deadline(PROF_CORE1_BLOCK,
+        (uint32_t)(period_ns * budget_pct / 100.0 / tick_ns));
+    prof_set_deadline(PROF_AUDIO_BLOCK,
+        (uint32_t)(period_ns * AUDIO_BLOCK_SIZE / BLOCK_SIZE * budget_pct / 100.0 / tick_ns));
+    prof_reset();
+
+    fill_blocks(SIG_SWEEP);
+    dsp_time_init();
+    audio_quant_init(&quant, 1023, true);
+    for (int n = 0; n < iterations; n++) {
+        int16_t *in = blocks[n % NUM_BLOCKS];
+
+        // the audio blocks of this window, as the output ISR runs them
+        for (int a = 0; a < BLOCK_SIZE; a += AUDIO_BLOCK_SIZE) {
+            PROF_START(t_audio);
+            PROF_START(t_fx);
+            dsp_time_process(in + a, time_out + a, AUDIO_BLOCK_SIZE, Q15(BENCH_MIX), false);
+            PROF_END(PROF_DSP_TIME, t_fx);
+
+            PROF_START(t_play);
+            audio_quant_block(&quant, time_out + a, levels, AUDIO_BLOCK_SIZE);
+            PROF_END(PROF_AUDIO_PLAY, t_play);
+            PROF_END(PROF_AUDIO_BLOCK, t_audio);
+        }
+
+        PROF_START(t_block);
+        PROF_START(t_dsp);
+        dsp_process(in);
+        PROF_END(PROF_DSP_PROCESS, t_dsp);
+        PROF_END(PROF_CORE1_BLOCK, t_block);
+    }
+
+    printf("\nper-block profile (prof.h, sine sweep, %d-sample audio blocks), "
+           "deadline %g%% of period\n", AUDIO_BLOCK_SIZE, budget_pct);
+    printf("%-14s %9s %9s %9s %9s %9s %8s\n",
+           "stage", "min ns", "mean ns", "max ns", "p50 >=", "p99 >=", "misses");
+
+    prof_stat_t s, a;
+    for (size_t i = 0; i < sizeof(block_stages) / sizeof(block_stages[0]); i++) {
+        prof_snapshot(block_stages[i], &s);
+        printf("%-14s %9.0f %9.0f %9.0f %9.0f %9.0f %8lu\n",
+               prof_stage_names[block_stages[i]],
+               s.min * tick_ns, s.count ? (double)s.sum / s.count * tick_ns : 0.0,
+               s.max * tick_ns, prof_percentile(&s, 50) * tick_ns,
+               prof_percentile(&s, 99) * tick_ns, (unsigned long)s.misses);
+    }
+
+    prof_snapshot(PROF_CORE1_BLOCK, &s);
+    prof_snapshot(PROF_AUDIO_BLOCK, &a);
+    if (!PROF_ENABLE) {
+        printf("(profiling compiled out: PICO_SPECTRUM_PROFILE=OFF)\n");
+        return true;
+    }
+    return s.misses * 100.0 <= BUDGET_MISS_PCT * s.count &&
+           a.misses * 100.0 <= BUDGET_MISS_PCT * a.count;
+}
+
+/* ---------- Accuracy against a double-precision DFT ---------- */
+
+// Bin error is reported relative to the bin of a full-scale Q15 sine
+#define FULL_SCALE_BIN (32768.0 * BLOCK_SIZE / 2)
+
+static double ref_re[BLOCK_SIZE / 2 + 1];
+static double ref_im[BLOCK_SIZE / 2 + 1];
+
+static void ref_dft(const int16_t *in) {
+    for (int k = 0; k <= BLOCK_SIZE / 2; k++) {
+        double sr = 0.0, si = 0.0;
+        for (int n = 0; n < BLOCK_SIZE; n++) {
+            double a = -2.0 * M_PI * (double)((k * n) % BLOCK_SIZE) / BLOCK_SIZE;
+            double x = (double)(in[n] << 4);
+            sr += x * cos(a);
+            si += x * sin(a);
+        }
+        ref_re[k] = sr;
+        ref_im[k] = si;
+    }
+}
+
+// Bands more than this far below the loudest band sit in the
+// fixed-point noise floor and are not compared
+#define BAND_FLOOR_DB  60.0
+
+// Largest band level error (dB) over the bands that are compared, and
+// of power_db_q8 on its own
+#define BAND_ERR_DB    0.25
+#define POWER_DB_ERR   0.01
+
+// Same bin → band mapping as dsp_process, in dBFS
+static void ref_bands(double *out) {
+    double acc[NUM_BANDS] = { 0 };
+    for (int i = 1; i < BLOCK_SIZE / 2; i++)
+        acc[dsp_band_map[i]] +=
+            ref_re[i] * ref_re[i] + ref_im[i] * ref_im[i];
+    for (int b = 0; b < NUM_BANDS; b++)
+        out[b] = acc[b] > 0.0 ? 10.0 * log10(acc[b]) - 20.0 * log10(FULL_SCALE_BIN)
+                              : -1000.0;
+}
+
+// Fails if fft_real is past FFT_REAL_ERR_DB, or a band or
+// power_db_q8 past its tolerance
+static bool check_accuracy(void) {
+    static int16_t in[BLOCK_SIZE];
+    bool ok = true;
+
+    dsp_set_window(DSP_WINDOW_RECT);    // the reference is unwindowed
+    printf("\naccuracy vs double DFT\n");
+    printf("%-12s %16s %16s\n", "signal", "max bin err", "max band err");
+    printf("%-12s %16s %16s\n", "", "(dB re FS bin)", "(dB, top 60 dB)");
+
+    for (int s = 0; s < SIG_COUNT; s++) {
+        fill_blocks((signal_t)s);
+        double bin_err = 0.0, band_err = 0.0;
+
+        for (int b = 0; b < NUM_BLOCKS; b++) {
+            memcpy(in, blocks[b], sizeof(in));
+
+            ref_dft(in);
+            load_fft(in);
+            double scale = ldexp(1.0, fft_real(fft_in));
+
+            for (int k = 0; k <= BLOCK_SIZE / 2; k++) {
+                double re, im;
+                if (k == 0)                   { re = fft_in[0].re; im = 0; }
+                else if (k == BLOCK_SIZE / 2) { re = fft_in[0].im; im = 0; }
+                else                          { re = fft_in[k].re; im = fft_in[k].im; }
+                double e = hypot(re * scale - ref_re[k], im * scale - ref_im[k]);
+                if (e > bin_err) bin_err = e;
+            }
+
+            double ref[NUM_BANDS], ref_max = -1000.0;
+            ref_bands(ref);
+            for (int i = 0; i < NUM_BANDS; i++)
+                if (ref[i] > ref_max) ref_max = ref[i];
+
+            dsp_process(in);
+            for (int i = 0; i < NUM_BANDS; i++) {
+                if (ref[i] < ref_max - BAND_FLOOR_DB || ref[i] * 256.0 < DB_FLOOR_Q8)
+                    continue;
+                double e = fabs(band_levels[i] / 256.0 - ref[i]);
+                if (e > band_err) band_err = e;
+            }
+        }
+        double bin_db = 20.0 * log10(bin_err / FULL_SCALE_BIN + 1e-12);
+        printf("%-12s %13.1f dB %16.4f\n", signal_names[s], bin_db, band_err);
+        ok &= within(bin_db, FFT_REAL_ERR_DB, "%s: fft_real bin error (dB)", signal_names[s]);
+        ok &= within(band_err, BAND_ERR_DB, "%s: band error (dB)", signal_names[s]);
+    }
+
+    /* Fixed-point dB conversion over the whole power range */
+    double db_err = 0.0;
+    for (double x = 1.0; x < 1.8e19; x *= 1.0137) {
+        uint64_t p = (uint64_t)x;
+        double e = fabs(power_db_q8(p, 0) / 256.0 - 10.0 * log10((double)p));
+        if (e > db_err) db_err = e;
+    }
+    printf("power_db_q8  max err %.4f dB\n", db_err);
+    ok &= within(db_err, POWER_DB_ERR, "power_db_q8 error (dB)");
+
+    dsp_set_window(DSP_WINDOW_HANN);
+    return ok;
+}
+
+/* ---------- Q15 effect path against its float reference ---------- */
+
+// Largest difference from dsp_time_ref, 12-bit LSB: the rounding of
+// the Q15 gain, filter and soft-clip table
+#define TIME_ERR_LSB  2
+
+static bool check_time(void) {
+    static int16_t ref_out[BLOCK_SIZE];
+    bool ok = true;
+
+    printf("\ndsp_time_process vs float reference (12-bit LSB)\n");
+    for (int s = 0; s < SIG_COUNT; s++) {
+        fill_blocks((signal_t)s);
+        dsp_time_init();
+        dsp_time_ref_init();
+        int max_err = 0;
+        for (int b = 0; b < NUM_BLOCKS; b++) {
+            dsp_time_process(blocks[b], time_out, BLOCK_SIZE, Q15(BENCH_MIX), false);
+            dsp_time_ref_process(blocks[b], ref_out, BLOCK_SIZE, BENCH_MIX, false);
+            for (int i = 0; i < BLOCK_SIZE; i++) {
+                int e = abs(time_out[i] - ref_out[i]);
+                if (e > max_err) max_err = e;
+            }
+        }
+        printf("%-12s max err %d LSB\n", signal_names[s], max_err);
+        ok &= within(max_err, TIME_ERR_LSB, "%s: dsp_time_process error (LSB)", signal_names[s]);
+    }
+    return ok;
+}
+
+/* ---------- Analysis windows ---------- */
+
+// Least a tapered window must cut the leakage by, against rect, dB
+#define WINDOW_LEAK_CUT_DB  15.0
+
+// A -6 dBFS tone halfway between two bins of the middle band: how far
+// its band reads from -6 dB, and how far below that the loudest band
+// two or more away sits (what leaks onto the display). Fails if Hann
+// or Blackman leaks less than WINDOW_LEAK_CUT_DB below rect.
+static bool check_windows(void) {
+    static const char *const names[DSP_WINDOW_COUNT] = { "rect", "hann", "blackman" };
+    static int16_t in[BLOCK_SIZE];
+    double rect_leak = 0.0;
+    bool ok = true;
+
+    const int band = NUM_BANDS / 2;
+    int first = 1;
+    while (dsp_band_map[first] != band) first++;
+    double bin = first + 0.5;
+    for (int n = 0; n < BLOCK_SIZE; n++)
+        in[n] = (int16_t)lrint(1024.0 * sin(2.0 * M_PI * bin * n / BLOCK_SIZE));
+
+    printf("\nanalysis windows, -6 dBFS tone at bin %.1f (band %d)\n", bin, band);
+    printf("%-12s %14s %14s\n", "window", "level err", "leakage");
+    printf("%-12s %14s %14s\n", "", "(dB)", "(dB, 2+ bands)");
+    for (int w = 0; w < DSP_WINDOW_COUNT; w++) {
+        dsp_set_window((dsp_window_t)w);
+        dsp_process(in);
+        double level = band_levels[band] / 256.0;
+        double leak = -1000.0;
+        for (int b = 0; b < NUM_BANDS; b++)
+            if (abs(b - band) >= 2 && band_levels[b] / 256.0 > leak)
+                leak = band_levels[b] / 256.0;
+        printf("%-12s %14.2f %14.1f\n", names[w],
+               level - 20.0 * log10(1024.0 / 2048.0), leak - level);
+        if (w == DSP_WINDOW_RECT) rect_leak = leak - level;
+        else ok &= within(leak - level, rect_leak - WINDOW_LEAK_CUT_DB,
+                          "%s: leakage (dB)", names[w]);
+    }
+    dsp_set_window(DSP_WINDOW_HANN);
+    return ok;
+}
+
+/* ---------- FFT vs filterbank ---------- */
+
+#define ENGINE_TONE   512.0     // 12-bit amplitude, -12 dBFS
+#define ENGINE_STEP   8         // filterbank samples between level checks
+
+static int16_t tone(double rel, long n) {
+    return n < 0 ? 0 : (int16_t)lrint(ENGINE_TONE * sin(2.0 * M_PI * rel * n));
+}
+
+// Samples from tone onset until the filterbank band is within 3 dB of
+// its settled level; *level gets the settled level
+static long fb_rise(int band, double rel, double *level) {
+    static int16_t in[ENGINE_STEP];
+    const long settle = SAMPLE_RATE_HZ;
+
+    dsp_fb_init();
+    for (long n = 0; n < settle; n += ENGINE_STEP) {
+        for (int i = 0; i < ENGINE_STEP; i++) in[i] = tone(rel, n + i);
+        dsp_fb_process(in, ENGINE_STEP);
+    }
+    *level = band_levels[band] / 256.0;
+
+    dsp_fb_init();
+    for (long n = 0; n < settle; n += ENGINE_STEP) {
+        for (int i = 0; i < ENGINE_STEP; i++) in[i] = tone(rel, n + i);
+        dsp_fb_process(in, ENGINE_STEP);
+        if (band_levels[band] / 256.0 >= *level - 3.0) return n + ENGINE_STEP;
+    }
+    return -1;
+}
+
+// The same for the FFT band holding the tone, Hann windows a quarter
+// window apart with the tone starting at a window boundary; -1 if the
+// tone is below the first bin
+static long fft_rise(double rel) {
+    static int16_t in[BLOCK_SIZE];
+    const int hop = BLOCK_SIZE / 4;
+    long bin = lrint(rel * BLOCK_SIZE);
+    if (bin < 1 || bin >= BLOCK_SIZE / 2) return -1;
+    int band = dsp_band_map[bin];
+
+    for (int i = 0; i < BLOCK_SIZE; i++) in[i] = tone(rel, i);
+    dsp_process(in);
+    double level = band_levels[band] / 256.0;
+
+    for (long end = hop; end <= BLOCK_SIZE; end += hop) {
+        for (int i = 0; i < BLOCK_SIZE; i++) in[i] = tone(rel, end - BLOCK_SIZE + i);
+        dsp_process(in);
+        if (band_levels[band] / 256.0 >= level - 3.0) return end;
+    }
+    return BLOCK_SIZE;
+}
+
+// Filterbank level error per band, dB, and rise time of the top band, ms
+#define FB_LEVEL_ERR_DB  1.0
+#define FB_TOP_RISE_MS   1.0
+
+// Fails if a filterbank band reads a settled tone more than
+// FB_LEVEL_ERR_DB off, never gets within 3 dB of it, or the top band
+// takes longer than FB_TOP_RISE_MS to get there
+static bool check_engines(int iterations) {
+    bool ok = true;
+
+    fill_blocks(SIG_NOISE);
+    double fft_ns = time_kernel(&kernels[1], iterations);
+    double fb_ns = time_kernel(&kernels[3], iterations);
+    double per_s = (double)SAMPLE_RATE_HZ / BLOCK_SIZE;
+
+    printf("\nanalysis engines at %d Hz, host ms per second of audio\n", SAMPLE_RATE_HZ);
+    for (int d = 1; d <= 4; d *= 2)
+        printf("  FFT %d, hop %-4d %8.3f\n", BLOCK_SIZE, BLOCK_SIZE / d,
+               fft_ns * per_s * d / 1e6);
+    printf("  filterbank       %8.3f\n", fb_ns * per_s / 1e6);
+
+    printf("%-5s %9s %12s %12s %12s\n", "band", "centre", "fb level", "fb rise", "FFT rise");
+    printf("%-5s %9s %12s %12s %12s\n", "", "(Hz)", "(dB err)", "(ms)", "(ms, hop/4)");
+    const double ms = 1000.0 / SAMPLE_RATE_HZ;
+    for (int b = 0; b < NUM_BANDS; b++) {
+        double rel = (double)dsp_fb_band_hz(b) / SAMPLE_RATE_HZ, level;
+        long fb = fb_rise(b, rel, &level);
+        long fft = fft_rise(rel);
+        double err = level - 20.0 * log10(ENGINE_TONE / 2048.0);
+        printf("%-5d %9u %12.2f %12.2f ", b, dsp_fb_band_hz(b), err, fb * ms);
+        if (fft < 0) printf("%12s\n", "below bin 1");
+        else printf("%12.2f\n", fft * ms);
+
+        ok &= within(fabs(err), FB_LEVEL_ERR_DB, "band %d: filterbank level error (dB)", b);
+        if (fb < 0) {
+            printf("FAIL: band %d: filterbank never within 3 dB of its settled level\n", b);
+            ok = false;
+        } else if (b == NUM_BANDS - 1) {
+            ok &= within(fb * ms, FB_TOP_RISE_MS, "band %d: filterbank rise (ms)", b);
+        }
+    }
+    dsp_fb_init();
+    return ok;
+}
+
+/* ---------- Stereo ---------- */
+
+static void run_two_mono(int16_t *in) {
+    dsp_process(in);
+    dsp_process(in + BLOCK_SIZE);
+}
+
+static void run_stereo_mid(int16_t *in) {
+    dsp_process_stereo(in, DSP_VIEW_MID);
+}
+
+// A reference spectrum merged into half bands the way the split views
+// do it, in dBFS, into out[0..NUM_BANDS/2-1]
+static void ref_half_bands(const double *re, const double *im, double *out) {
+    double acc[NUM_BANDS / 2] = { 0 };
+    for (int i = 1; i < BLOCK_SIZE / 2; i++)
+        acc[dsp_band_map[i] >> 1] += re[i] * re[i] + im[i] * im[i];
+    for (int b = 0; b < NUM_BANDS / 2; b++)
+        out[b] = acc[b] > 0.0 ? 10.0 * log10(acc[b]) - 20.0 * log10(FULL_SCALE_BIN)
+                              : -1000.0;
+}
+
+// Largest band error of the last dsp_process_stereo against ref, over
+// the bands within BAND_FLOOR_DB of the loudest
+static double band_err(const double *ref) {
+    double ref_max = -1000.0, err = 0.0;
+    for (int i = 0; i < NUM_BANDS; i++)
+        if (ref[i] > ref_max) ref_max = ref[i];
+    for (int i = 0; i < NUM_BANDS; i++) {
+        if (ref[i] < ref_max - BAND_FLOOR_DB || ref[i] * 256.0 < DB_FLOOR_Q8)
+            continue;
+        double e = fabs(band_levels[i] / 256.0 - ref[i]);
+        if (e > err) err = e;
+    }
+    return err;
+}
+
+// Least separation of a left-only tone from the right half, dB
+#define STEREO_CROSSTALK_DB  60.0
+
+// Fails if a split view band is more than BAND_ERR_DB off its
+// reference, or a left-only tone shows less than STEREO_CROSSTALK_DB
+// below it on the right
+static bool check_stereo(int iterations) {
+    static int16_t in[2 * BLOCK_SIZE];
+    static double l_re[BLOCK_SIZE / 2 + 1], l_im[BLOCK_SIZE / 2 + 1];
+    static double m_re[BLOCK_SIZE / 2 + 1], m_im[BLOCK_SIZE / 2 + 1];
+    static double s_re[BLOCK_SIZE / 2 + 1], s_im[BLOCK_SIZE / 2 + 1];
+    const kernel_t two = { "2 x dsp_process", run_two_mono };
+    const kernel_t mid = { "stereo mid", run_stereo_mid };
+    bool ok = true;
+
+    fill_blocks(SIG_NOISE);
+    double two_ns = time_kernel(&two, iterations);
+    double lr_ns = time_kernel(&kernels[2], iterations);
+    double mid_ns = time_kernel(&mid, iterations);
+
+    printf("\nstereo analysis, host ns per window\n");
+    printf("  2 x dsp_process  %10.1f\n", two_ns);
+    printf("  L/R or M/S view  %10.1f  (%.0f%% of two mono windows)\n",
+           lr_ns, 100.0 * lr_ns / two_ns);
+    printf("  mid view         %10.1f\n", mid_ns);
+
+    /* Split views against the double DFT of each channel; right is the next block */
+    dsp_set_window(DSP_WINDOW_RECT);    // the reference is unwindowed
+    printf("%-12s %16s %16s\n", "signal", "L/R band err", "M/S band err");
+    printf("%-12s %16s %16s\n", "", "(dB, top 60 dB)", "(dB, top 60 dB)");
+    for (int s = 0; s < SIG_COUNT; s++) {
+        fill_blocks((signal_t)s);
+        double lr_err = 0.0, ms_err = 0.0;
+
+        for (int b = 0; b < NUM_BLOCKS; b++) {
+            memcpy(in, blocks[b], sizeof(blocks[0]));
+            memcpy(in + BLOCK_SIZE, blocks[b + 1], sizeof(blocks[0]));
+
+            ref_dft(in);
+            memcpy(l_re, ref_re, sizeof(l_re));
+            memcpy(l_im, ref_im, sizeof(l_im));
+            ref_dft(in + BLOCK_SIZE);
+            for (int k = 0; k <= BLOCK_SIZE / 2; k++) {
+                m_re[k] = (l_re[k] + ref_re[k]) / 2;
+                m_im[k] = (l_im[k] + ref_im[k]) / 2;
+                s_re[k] = (l_re[k] - ref_re[k]) / 2;
+                s_im[k] = (l_im[k] - ref_im[k]) / 2;
+            }
+
+            double ref[NUM_BANDS], e;
+            ref_half_bands(l_re, l_im, ref);
+            ref_half_bands(ref_re, ref_im, ref + NUM_BANDS / 2);
+            dsp_process_stereo(in, DSP_VIEW_LR);
+            if ((e = band_err(ref)) > lr_err) lr_err = e;
+
+            ref_half_bands(m_re, m_im, ref);
+            ref_half_bands(s_re, s_im, ref + NUM_BANDS / 2);
+            dsp_process_stereo(in, DSP_VIEW_MS);
+            if ((e = band_err(ref)) > ms_err) ms_err = e;
+        }
+        printf("%-12s %16.4f %16.4f\n", signal_names[s], lr_err, ms_err);
+        ok &= within(lr_err, BAND_ERR_DB, "%s: L/R band error (dB)", signal_names[s]);
+        ok &= within(ms_err, BAND_ERR_DB, "%s: M/S band error (dB)", signal_names[s]);
+    }
+    dsp_set_window(DSP_WINDOW_HANN);
+
+    /* Crosstalk: a tone on the left only, in the middle half-band */
+    const int band = NUM_BANDS / 4;
+    int first = 1;
+    while (dsp_band_map[first] >> 1 != band) first++;
+    for (int n = 0; n < BLOCK_SIZE; n++) {
+        in[n] = (int16_t)lrint(1024.0 * sin(2.0 * M_PI * (first + 0.5) * n / BLOCK_SIZE));
+        in[BLOCK_SIZE + n] = 0;
+    }
+    dsp_process_stereo(in, DSP_VIEW_LR);
+    double right = -1000.0;
+    for (int b = NUM_BANDS / 2; b < NUM_BANDS; b++)
+        if (band_levels[b] / 256.0 > right) right = band_levels[b] / 256.0;
+    double sep = band_levels[band] / 256.0 - right;
+    printf("crosstalk, -6 dBFS tone on the left only (Hann): right half %.1f dB below it\n",
+           sep);
+    ok &= at_least(sep, STEREO_CROSSTALK_DB, "crosstalk (dB below the tone)");
+    return ok;
+}
+
+/* ---------- Effect chain modules ---------- */
+
+#define FX_LEN  (1 << 15)   // samples per check signal, about 0.75 s
+
+typedef struct {
+    const char *name;
+    fx_config_t cfg;
+    int tol;            // largest error against the reference, Q15 LSB
+} fx_case_t;
+
+// Tolerances are about twice the worst error at 44.1 and 48 kHz: the
+// Q27 coefficient rounding for the biquads (most at high gain), the
+// gain steps every 8 samples for the compressor and gate
+static const fx_case_t fx_cases[] = {
+    { "lowpass 1k",       { FX_BIQUAD, false, { FX_EQ_LOWPASS, 1000, 71 } },            4 },
+    { "highpass 40",      { FX_BIQUAD, false, { FX_EQ_HIGHPASS, 40, 71 } },             6 },
+    { "peak 2k +9",       { FX_BIQUAD, false, { FX_EQ_PEAK, 2000, 100, 90 } },         24 },
+    { "low shelf 200 -6", { FX_BIQUAD, false, { FX_EQ_LOW_SHELF, 200, 71, -60 } },      4 },
+    { "high shelf 6k +6", { FX_BIQUAD, false, { FX_EQ_HIGH_SHELF, 6000, 71, 60 } },    16 },
+    { "compressor 4:1",   { FX_COMPRESSOR, false, { -300, 40, 5, 100, 60 } },          32 },
+    { "limiter -18",      { FX_COMPRESSOR, false, { -180, 0, 0, 50, 0 } },              8 },
+    { "gate -40",         { FX_GATE, false, { -400, 600, 1, 50, 20 } },                 8 },
+    { "delay 100 ms",     { FX_DELAY, false, { 100, Q15(0.5), Q15(0.7) } },             2 },
+    { "drive",            { FX_DRIVE, false, { 0 } },                                   0 },
+};
+
+#define NUM_FX_CASES  (int)(sizeof(fx_cases) / sizeof(fx_cases[0]))
+
+static int16_t fx_in[FX_LEN], fx_out[FX_LEN], fx_ref[FX_LEN];
+static fx_ref_t fx_ref_state;
+
+// Q15 check signals at -12 dBFS peak, so the EQ boosts do not clip: a
+// sweep, noise, and a 997 Hz burst stepping down to -52 dBFS and back
+// every 4096 samples for the dynamics
+static void fx_signal(int sig) {
+    double ph = 0.0;
+    for (int n = 0; n < FX_LEN; n++) {
+        double f = 20.0 * pow(1000.0, (double)n / FX_LEN);
+        double a = 0.25 * (sig != 2 || (n >> 12) % 2 == 0 ? 1.0 : 0.01);
+        ph += 2.0 * M_PI * (sig == 0 ? f : 997.0) / SAMPLE_RATE_HZ;
+        fx_in[n] = sig == 1 ? (int16_t)(noise12() << 2) : (int16_t)lrint(32767.0 * a * sin(ph));
+    }
+}
+
+// Slot 0 alone over the whole signal, in audio blocks
+static void fx_run_fixed(const fx_config_t *cfg) {
+    static const fx_config_t none = { .type = FX_NONE };
+    dsp_fx_init();
+    dsp_fx_configure(0, &none);
+    dsp_fx_configure(0, cfg);
+    memcpy(fx_out, fx_in, sizeof(fx_out));
+    for (int a = 0; a < FX_LEN; a += AUDIO_BLOCK_SIZE)
+        dsp_fx_process(fx_out + a, AUDIO_BLOCK_SIZE);
+}
+
+static double fx_ns_per_sample(int iterations) {
+    int blocks = iterations < 2000 ? iterations : 2000;
+    uint64_t t0 = now_ns();
+    for (int n = 0; n < blocks; n++)
+        dsp_fx_process(fx_out + (n * AUDIO_BLOCK_SIZE) % FX_LEN, AUDIO_BLOCK_SIZE);
+    uint64_t t1 = now_ns();
+    sink = fx_out[0];
+    return (double)(t1 - t0) / ((double)blocks * AUDIO_BLOCK_SIZE);
+}
+
+// Fails if a module is further from its float reference than its
+// tolerance on any of the signals
+// Only host time is shown: the biquads are built around 32-bit
+// products for the M0+, so host ns say nothing about its cycles. The
+// device cost of each slot is its PROF_FX* stage (tlm_cli monitor).
+static bool check_fx(int iterations) {
+    static const char *fx_signal_names[] = { "sweep", "noise", "burst" };
+    bool ok = true;
+
+    printf("\neffect chain modules vs float reference (Q15 LSB), host time per sample\n");
+    printf("%-18s %7s %7s %7s %7s %10s\n", "module",
+           fx_signal_names[0], fx_signal_names[1], fx_signal_names[2], "tol",
+           "host ns");
+
+    for (int c = 0; c < NUM_FX_CASES; c++) {
+        long err[3];
+        for (int sig = 0; sig < 3; sig++) {
+            fx_signal(sig);
+            fx_run_fixed(&fx_cases[c].cfg);
+
+            // the drive is held to dsp_time_ref through dsp_time_process
+            err[sig] = -1;
+            if (fx_cases[c].cfg.type == FX_DRIVE) continue;
+
+            dsp_fx_ref_init(&fx_ref_state, dsp_fx_config(0));
+            dsp_fx_ref_process(&fx_ref_state, fx_in, fx_ref, FX_LEN);
+            err[sig] = 0;
+            for (int n = 0; n < FX_LEN; n++) {
+                long e = labs((long)fx_out[n] - fx_ref[n]);
+                if (e > err[sig]) err[sig] = e;
+            }
+        }
+
+        double ns = fx_ns_per_sample(iterations);
+        printf("%-18s", fx_cases[c].name);
+        for (int sig = 0; sig < 3; sig++)
+            if (err[sig] < 0) printf(" %7s", "-");
+            else printf(" %7ld", err[sig]);
+        if (err[0] < 0) printf(" %7s", "-");
+        else printf(" %7d", fx_cases[c].tol);
+        printf(" %10.2f\n", ns);
+
+        for (int sig = 0; sig < 3; sig++)
+            if (err[sig] >= 0)
+                ok &= within(err[sig], fx_cases[c].tol, "%s, %s: error (Q15 LSB)",
+                             fx_cases[c].name, fx_signal_names[sig]);
+    }
+
+    /* A full chain: EQ, compressor, echo, drive */
+    static const int chain[FX_SLOTS] = { 2, 5, 8, 9 };
+    dsp_fx_init();
+    for (int s = 0; s < FX_SLOTS; s++)
+        dsp_fx_configure(s, &fx_cases[chain[s]].cfg);
+    fx_signal(1);
+    memcpy(fx_out, fx_in, sizeof(fx_out));
+    double ns = fx_ns_per_sample(iterations);
+    printf("%-18s %31s %10.2f\n", "chain of 4", "", ns);
+    dsp_fx_init();
+    return ok;
+}
+
+/* ---------- Live parameter changes ---------- */
+
+#define CHG_LEN  (1 << 15)
+#define CHG_AT   (CHG_LEN / 2)     // on an audio block boundary
+
+typedef enum {
+    CHG_BYPASS,
+    CHG_MIX,
+    CHG_EQ_GAIN,
+    CHG_EQ_IN,
+    CHG_ECHO_TIME,
+    CHG_COUNT
+} change_t;
+
+static const char *change_names[CHG_COUNT] = {
+    "bypass on", "mix 0.7 -> 0", "peak +12 -> -12 dB", "peak slot in", "echo 100 -> 30 ms",
+};
+
+static int16_t chg_in[CHG_LEN], chg_out[CHG_LEN];
+
+// Largest second difference of chg_out over [from, to), relative to
+// the peak level within a period of each sample: a steady tone gives
+// the same at any level, a step in the output shows up far above it
+static double max_d2(int from, int to) {
+    const int half = SAMPLE_RATE_HZ / 997 / 2 + 1;
+    double m = 0.0;
+    for (int n = from; n < to; n++) {
+        int32_t d2 = abs(chg_out[n] - 2 * chg_out[n - 1] + chg_out[n - 2]);
+        int32_t peak = 1;
+        for (int k = n - half; k <= n + half; k++)
+            if (k >= 0 && k < CHG_LEN && abs(chg_out[k]) > peak) peak = abs(chg_out[k]);
+        if ((double)d2 / peak > m) m = (double)d2 / peak;
+    }
+    return m;
+}
+
+// dB of the largest relative second difference in the 20 ms after the
+// change over that of the steady output before and after it. Hard changes go
+// through dsp_fx_configure(), ramped ones through dsp_fx_update() as
+// the audio path does.
+static double change_step_db(change_t c, bool hard) {
+    fx_config_t eq = { FX_BIQUAD, false, { FX_EQ_PEAK, 2000, 100, 120 } };
+    fx_config_t echo = { FX_DELAY, false, { 100, Q15(0.4), Q15(0.5) } };
+    void (*set)(int, const fx_config_t *) = hard ? dsp_fx_configure : dsp_fx_update;
+    int16_t mix = Q15(BENCH_MIX);
+    bool bypass = false;
+
+    dsp_time_init();
+    if (c == CHG_EQ_GAIN) dsp_fx_configure(1, &eq);
+    if (c == CHG_ECHO_TIME) dsp_fx_configure(1, &echo);
+
+    for (int a = 0; a < CHG_LEN; a += AUDIO_BLOCK_SIZE) {
+        if (a == CHG_AT) {
+            switch (c) {
+                case CHG_BYPASS:    bypass = true;          break;
+                case CHG_MIX:       mix = 0;                break;
+                case CHG_EQ_GAIN:   eq.f[3] = -120;         set(1, &eq);   break;
+                case CHG_EQ_IN:                             set(1, &eq);   break;
+                case CHG_ECHO_TIME: echo.f[0] = 30;         set(1, &echo); break;
+                default: break;
+            }
+        }
+        dsp_time_process(chg_in + a, chg_out + a, AUDIO_BLOCK_SIZE, mix, bypass);
+    }
+
+    double before = max_d2(CHG_AT - CHG_LEN / 4, CHG_AT);
+    double after = max_d2(CHG_LEN - CHG_LEN / 4, CHG_LEN);
+    double at = max_d2(CHG_AT, CHG_AT + SAMPLE_RATE_HZ / 50);
+    return 20.0 * log10(at / (before > after ? before : after));
+}
+
+// Largest step a ramped change may leave, dB over the steady tone
+#define CHANGE_STEP_DB  3.0
+
+// Fails if a ramped change steps the output by more than
+// CHANGE_STEP_DB, or a latch takes part of a write of several
+// parameters
+static bool check_changes(void) {
+    bool ok = true;
+
+    for (int n = 0; n < CHG_LEN; n++)
+        chg_in[n] = (int16_t)lrint(1024.0 * sin(2.0 * M_PI * 997.0 * n / SAMPLE_RATE_HZ));
+
+    printf("\nlive changes, 997 Hz at -6 dBFS: largest output step (second difference over\n"
+           "the local level) in the 20 ms after the change, dB over the steady tone\n");
+    printf("%-20s %10s %10s\n", "change", "hard", "ramped");
+    for (int c = 0; c < CHG_COUNT; c++) {
+        bool fx = c == CHG_EQ_GAIN || c == CHG_EQ_IN || c == CHG_ECHO_TIME;
+        if (fx) printf("%-20s %10.1f", change_names[c], change_step_db((change_t)c, true));
+        else printf("%-20s %10s", change_names[c], "-");
+        double step = change_step_db((change_t)c, false);
+        printf(" %10.1f\n", step);
+        ok &= within(step, CHANGE_STEP_DB, "%s: ramped step (dB)", change_names[c]);
+    }
+
+    /* A slot set in one write: the latch takes none of it, then all */
+    param_snapshot_t snap;
+    const param_id_t hz = PARAM_FX(1, PARAM_FX_A + 1), q = PARAM_FX(1, PARAM_FX_A + 2);
+    params_latch_init(&snap);
+    bool latched = params_latch(&snap);
+    params_write_begin();
+    param_set(hz, 3000, NULL);
+    bool during = params_latch(&snap) || snap.v[hz] == 3000;
+    param_set(q, 200, NULL);
+    params_write_end();
+    latched &= params_latch(&snap) && snap.v[hz] == 3000 && snap.v[q] == 200;
+    printf("one write of two parameters: %s\n",
+           latched && !during ? "latched together" : "split");
+    if (!latched || during) {
+        printf("FAIL: a latch took part of a write\n");
+        ok = false;
+    }
+    params_init();
+
+    /* Cost of the ramps: the mix target moving every block */
+    const int blocks = CHG_LEN / AUDIO_BLOCK_SIZE;
+    double ns[2];
+    for (int moving = 0; moving < 2; moving++) {
+        dsp_time_init();
+        uint64_t t0 = now_ns();
+        for (int b = 0; b < blocks; b++) {
+            int16_t mix = moving && (b & 1) ? Q15(0.2) : Q15(BENCH_MIX);
+            dsp_time_process(chg_in + b * AUDIO_BLOCK_SIZE, chg_out + b * AUDIO_BLOCK_SIZE,
+                             AUDIO_BLOCK_SIZE, mix, false);
+        }
+        ns[moving] = (double)(now_ns() - t0) / CHG_LEN;
+    }
+    sink = chg_out[0];
+    printf("dsp_time_process ns/sample: %.2f steady, %.2f with the mix gliding every block\n",
+           ns[0], ns[1]);
+    dsp_time_init();
+    return ok;
+}
+
+/* ---------- PWM requantization noise ---------- */
+
+#define QUANT_N 4096
+
+// Least the shaping must take off the noise below fs/8, dB
+#define QUANT_SHAPE_GAIN_DB  5.0
+
+// Requantization error of a -1 dBFS 12-bit sine at each PWM wrap,
+// relative to a full-scale sine: over the whole band, and below fs/8
+// where first-order shaping moves the noise away from. The carrier is
+// clk_sys / (wrap + 1) at the target clock.
+//
+// Fails if plain rounding is ever more than half a level out, shaping
+// more than one level or off on average, shaping takes less than
+// QUANT_SHAPE_GAIN_DB off below fs/8, or the 4096-level range is not
+// exact.
+static bool check_pwm_quant(double sample_rate, double target_mhz) {
+    static const uint16_t wraps[] = { 255, 499, 1023, 2047, 4095 };
+    static int16_t in[QUANT_N];
+    static uint16_t out[QUANT_N];
+    static double err[QUANT_N], win[QUANT_N];
+    bool ok = true;
+
+    for (int n = 0; n < QUANT_N; n++) {
+        in[n] = (int16_t)lrint(2047.0 * 0.891 * sin(2.0 * M_PI * 997.0 * n / sample_rate));
+        win[n] = 0.5 - 0.5 * cos(2.0 * M_PI * n / QUANT_N);
+    }
+    double win_pow = 0.0;
+    for (int n = 0; n < QUANT_N; n++) win_pow += win[n] * win[n];
+
+    printf("\nPWM requantization noise, 997 Hz at -1 dBFS (dB re full-scale sine)\n");
+    printf("%-6s %10s %14s %14s %14s %14s\n", "wrap", "carrier",
+           "plain full", "shaped full", "plain <fs/8", "shaped <fs/8");
+
+    for (size_t w = 0; w < sizeof(wraps) / sizeof(wraps[0]); w++) {
+        double full[2], low[2];
+
+        for (int shape = 0; shape < 2; shape++) {
+            audio_quant_t q;
+            audio_quant_init(&q, wraps[w], shape);
+            audio_quant_block(&q, in, out, QUANT_N);
+
+            // Error in units of the PWM range, against exact scaling
+            double range = wraps[w] + 1.0, sum = 0.0, mean = 0.0, peak = 0.0;
+            for (int n = 0; n < QUANT_N; n++) {
+                err[n] = (out[n] - (in[n] + 2048) * range / 4096.0) / range;
+                sum += err[n] * err[n];
+                mean += err[n];
+                if (fabs(err[n]) > peak) peak = fabs(err[n]);
+            }
+            full[shape] = sum / QUANT_N;
+
+            // in PWM levels
+            peak *= range;
+            mean = fabs(mean) * range / QUANT_N;
+            if (shape) {
+                ok &= within(peak, 1.0 + 1e-9, "wrap %u: shaped error (levels)", wraps[w]);
+                ok &= within(mean, 1.0 / QUANT_N + 1e-9,
+                             "wrap %u: shaped mean error (levels)", wraps[w]);
+            } else {
+                ok &= within(peak, 0.5 + 1e-9, "wrap %u: rounding error (levels)", wraps[w]);
+            }
+
+            // Bins 1 .. N/8 of the windowed error
+            double band = 0.0;
+            for (int k = 1; k <= QUANT_N / 8; k++) {
+                double re = 0.0, im = 0.0;
+                for (int n = 0; n < QUANT_N; n++) {
+                    double a = 2.0 * M_PI * (double)((k * n) % QUANT_N) / QUANT_N;
+                    re += err[n] * win[n] * cos(a);
+                    im -= err[n] * win[n] * sin(a);
+                }
+                band += 2.0 * (re * re + im * im);
+            }
+            low[shape] = band / (QUANT_N * win_pow);
+        }
+
+        // Full-scale sine over the range: amplitude 1/2, power 1/8
+        printf("%-6u %8.0f k %14.1f %14.1f %14.1f %14.1f\n", wraps[w],
+               target_mhz * 1000.0 / (wraps[w] + 1.0),
+               10.0 * log10(full[0] * 8.0), 10.0 * log10(full[1] * 8.0),
+               10.0 * log10(low[0] * 8.0), 10.0 * log10(low[1] * 8.0));
+
+        if (wraps[w] == AUDIO_QUANT_MAX_WRAP)
+            ok &= within(full[0] + full[1], 0.0, "wrap %u: requantization noise", wraps[w]);
+        else
+            ok &= within(10.0 * log10(low[1] / low[0]), -QUANT_SHAPE_GAIN_DB,
+                         "wrap %u: shaped noise below fs/8 re plain (dB)", wraps[w]);
+    }
+    return ok;
+}
+
+/* ---------- Display dynamics ---------- */
+
+#define DISP_FRAME_US  16667        // 60 fps
+#define DISP_FRAMES    600
+
+typedef enum { DISP_NOISE, DISP_QUIET_TONE, DISP_MUSIC, DISP_SIG_COUNT } disp_signal_t;
+
+static const char *disp_signal_names[DISP_SIG_COUNT] = {
+    "noise -75 dBFS", "tone -50 on noise", "music -30 +-12 dB",
+};
+
+// dB plus or minus spread, uniform, Q8
+static int16_t disp_level(double db, double spread) {
+    return (int16_t)lrint((db + spread * noise12() / 2048.0) * 256.0);
+}
+
+static void disp_frame(disp_signal_t sig, int16_t *levels) {
+    for (int b = 0; b < NUM_BANDS; b++) {
+        switch (sig) {
+            case DISP_NOISE:      levels[b] = disp_level(-75.0, 3.0); break;
+            case DISP_QUIET_TONE: levels[b] = b == 5 ? disp_level(-50.0, 1.0)
+                                                     : disp_level(-75.0, 3.0); break;
+            default:              levels[b] = disp_level(-30.0, 12.0); break;
+        }
+    }
+}
+
+// Over the last half of DISP_FRAMES: mean rows lit per column, in the
+// tone column (5) and the rest, and the mean height change per column
+// per frame
+static void disp_run(disp_signal_t sig, bool dynamics, double *lit_tone,
+                     double *lit_rest, double *flicker) {
+    display_dyn_config_t cfg;
+    display_dyn_t dyn;
+    int16_t levels[NUM_BANDS];
+    uint8_t h[LED_COLUMNS], prev[LED_COLUMNS] = { 0 };
+    double tone = 0.0, rest = 0.0, moved = 0.0;
+    const int tone_col = 5 * LED_COLUMNS / NUM_BANDS;
+
+    display_dyn_config_params(&cfg);
+    display_dyn_init(&dyn, &cfg);
+    lcg_state = 0x2468aceu;
+    for (int f = 0; f < DISP_FRAMES; f++) {
+        disp_frame(sig, levels);
+        if (dynamics)
+            display_dyn_step(&dyn, levels, NUM_BANDS, (uint32_t)f * DISP_FRAME_US, h, NULL);
+        else
+            display_map_db(levels, NUM_BANDS, h);
+        if (f >= DISP_FRAMES / 2) {
+            for (int c = 0; c < LED_COLUMNS; c++) {
+                if (c == tone_col) tone += h[c];
+                else rest += h[c];
+                moved += abs(h[c] - prev[c]);
+            }
+        }
+        memcpy(prev, h, sizeof(prev));
+    }
+    const double frames = DISP_FRAMES / 2;
+    *lit_tone = tone / frames;
+    *lit_rest = rest / (frames * (LED_COLUMNS - 1));
+    *flicker = moved / (frames * LED_COLUMNS);
+}
+
+// Most rows noise may light, least the dynamics must add to the quiet
+// tone, and most flicker on music against the fixed window
+#define DISP_DARK_ROWS      0.5
+#define DISP_QUIET_ROWS     4.0
+#define DISP_FLICKER_SHARE  0.75
+
+// Fails if the dynamics light noise, show the quiet tone no higher than
+// the fixed window does (by DISP_QUIET_ROWS), flicker more than
+// DISP_FLICKER_SHARE of it on music, or hold the peak dot for other
+// than disp_hold (to a frame) or not let it fall after
+static bool check_display(int iterations, double target_mhz) {
+    display_dyn_config_t cfg;
+    display_dyn_config_params(&cfg);
+    bool ok = true;
+
+    printf("\ndisplay dynamics (AGC %s, %d dB, rise %d ms, fall %d dB/s, hold %d ms) vs the\n"
+           "fixed %d..%d dBFS window, 60 fps: rows lit (column 5 / the rest), mean change per frame\n",
+           cfg.agc ? "on" : "off", (int)cfg.range_db, (int)cfg.attack_ms, (int)cfg.decay_db_s,
+           (int)cfg.hold_ms, DISPLAY_DB_MIN, DISPLAY_DB_MAX);
+    printf("%-20s %16s %8s %16s %8s\n", "signal", "fixed lit", "change", "dynamic lit", "change");
+    for (int s = 0; s < DISP_SIG_COUNT; s++) {
+        double tone[2], rest[2], flicker[2];
+        for (int d = 0; d < 2; d++)
+            disp_run((disp_signal_t)s, d, &tone[d], &rest[d], &flicker[d]);
+        printf("%-20s %7.1f / %6.1f %8.2f %7.1f / %6.1f %8.2f\n", disp_signal_names[s],
+               tone[0], rest[0], flicker[0], tone[1], rest[1], flicker[1]);
+
+        const char *name = disp_signal_names[s];
+        switch ((disp_signal_t)s) {
+            case DISP_NOISE:
+                ok &= within(tone[1], DISP_DARK_ROWS, "%s: column 5 rows lit", name);
+                ok &= within(rest[1], DISP_DARK_ROWS, "%s: other rows lit", name);
+                break;
+            case DISP_QUIET_TONE:
+                ok &= at_least(tone[1], tone[0] + DISP_QUIET_ROWS, "%s: tone rows lit", name);
+                ok &= within(rest[1], DISP_DARK_ROWS, "%s: noise rows lit", name);
+                break;
+            default:
+                ok &= within(flicker[1], flicker[0] * DISP_FLICKER_SHARE,
+                             "%s: change per frame (rows)", name);
+                break;
+        }
+    }
+
+    /* Peak hold: one -6 dBFS frame in every band, then noise */
+    display_dyn_t dyn;
+    int16_t levels[NUM_BANDS];
+    uint8_t h[LED_COLUMNS], peaks[LED_COLUMNS];
+    int held_ms = -1, gone_ms = -1;
+    int16_t top = 0;
+    display_dyn_init(&dyn, &cfg);
+    lcg_state = 0x13579bdu;
+    for (int f = 0; f < DISP_FRAMES && gone_ms < 0; f++) {
+        disp_frame(DISP_MUSIC, levels);
+        if (f == 60)
+            for (int b = 0; b < NUM_BANDS; b++) levels[b] = (int16_t)DB_Q8(-6);
+        display_dyn_step(&dyn, levels, NUM_BANDS, (uint32_t)f * DISP_FRAME_US, h, peaks);
+        if (f == 60) top = dyn.peak[0];
+        if (f > 60 && held_ms < 0 && dyn.peak[0] < top)
+            held_ms = (f - 60) * DISP_FRAME_US / 1000;
+        if (f > 60 && gone_ms < 0 && dyn.peak[0] <= dyn.bar[0])
+            gone_ms = (f - 60) * DISP_FRAME_US / 1000;
+    }
+    printf("peak dot after a -6 dBFS frame: held %d ms, back down to the bar after %d ms\n",
+           held_ms, gone_ms);
+    ok &= within(abs(held_ms - (int)cfg.hold_ms), DISP_FRAME_US / 1000 + 1,
+                 "peak hold off disp_hold (ms)");
+    if (gone_ms <= held_ms) {
+        printf("FAIL: peak dot never fell back to the bar\n");
+        ok = false;
+    }
+
+    /* Cost per frame */
+    int frames = iterations < 20000 ? iterations : 20000;
+    display_dyn_init(&dyn, &cfg);
+    uint64_t t0 = now_ns();
+    for (int f = 0; f < frames; f++) {
+        levels[f % NUM_BANDS] = disp_level(-30.0, 12.0);
+        display_dyn_step(&dyn, levels, NUM_BANDS, (uint32_t)f * DISP_FRAME_US, h, peaks);
+    }
+    double ns = (double)(now_ns() - t0) / frames;
+    sink = h[0];
+    printf("display_dyn_step: %.1f ns/frame (%.0f cycles-equivalent), "
+           "display_map_db alone: ", ns, ns * target_mhz / 1000.0);
+    t0 = now_ns();
+    for (int f = 0; f < frames; f++) {
+        levels[f % NUM_BANDS] = disp_level(-30.0, 12.0);
+        display_map_db(levels, NUM_BANDS, h);
+    }
+    ns = (double)(now_ns() - t0) / frames;
+    sink = h[0];
+    printf("%.1f ns/frame\n", ns);
+    return ok;
+}
+
+static const char *const check_names[] = {
+    "accuracy", "time", "windows", "engines", "stereo",
+    "fx", "changes", "pwm", "display",
+};
+#define NUM_CHECKS (sizeof(check_names) / sizeof(check_names[0]))
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [-n iterations] [-r sample_rate_hz] [-m target_mhz] [-b budget_pct]\n"
+            "       [-t check]   checks:",
+            prog);
+    for (size_t c = 0; c < NUM_CHECKS; c++) fprintf(stderr, " %s", check_names[c]);
+    fprintf(stderr, "\n");
+}
+
+// All checks run without -t; with it, only the named one.
+static bool wants(const char *only, const char *name) {
+    return !only || !strcmp(only, name);
+}
+
+int main(int argc, char **argv) {
+    int iterations = 20000;
+    double sample_rate = 44100.0;
+    double target_mhz = 125.0;   // RP2040 default clk_sys
+    double budget_pct = 100.0;   // of the block period
+    const char *only = NULL;     // -t: run just this check
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc)      iterations = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc) sample_rate = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-m") && i + 1 < argc) target_mhz = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc) budget_pct = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) only = argv[++i];
+        else { usage(argv[0]); return 1; }
+    }
+    bool known = !only;
+    for (size_t c = 0; c < NUM_CHECKS && !known; c++) known = !strcmp(only, check_names[c]);
+    if (!known || iterations <= 0 || sample_rate <= 0 || target_mhz <= 0 || budget_pct <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    double period_ns = 1e9 * BLOCK_SIZE / sample_rate;
+
+    params_init();
+    dsp_init();
+    dsp_time_init();
+    dsp_time_ref_init();
+
+    printf("block %d samples, %.0f Hz -> period %.1f us, %d iterations\n",
+           BLOCK_SIZE, sample_rate, period_ns / 1000.0, iterations);
+    printf("cycles-equivalent at %.1f MHz\n", target_mhz);
+
+    bool in_budget = true;
+    if (!only) {
+        printf("\n%-18s %-12s %12s %14s %12s %9s\n",
+               "kernel", "signal", "ns/block", "blocks/sec", "cycles", "%period");
+
+        for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+            for (int s = 0; s < SIG_COUNT; s++) {
+                fill_blocks((signal_t)s);
+                double ns = time_kernel(&kernels[k], iterations);
+                printf("%-18s %-12s %12.1f %14.0f %12.0f %8.2f%%\n",
+                       kernels[k].name, signal_names[s],
+                       ns, 1e9 / ns, ns * target_mhz / 1000.0,
+                       100.0 * ns / period_ns);
+            }
+        }
+
+        in_budget = profile_blocks(iterations, period_ns, budget_pct);
+    }
+
+    bool ok = true;
+    if (wants(only, "accuracy")) ok &= check_accuracy();
+    if (wants(only, "time"))     ok &= check_time();
+    if (wants(only, "windows"))  ok &= check_windows();
+    if (wants(only, "engines"))  ok &= check_engines(iterations);
+    if (wants(only, "stereo"))   ok &= check_stereo(iterations);
+    if (wants(only, "fx"))       ok &= check_fx(iterations);
+    if (wants(only, "changes"))  ok &= check_changes();
+    if (wants(only, "pwm"))      ok &= check_pwm_quant(sample_rate, target_mhz);
+    if (wants(only, "display"))  ok &= check_display(iterations, target_mhz);
+
+    if (!in_budget) {
+        printf("\nFAIL: core1_block or audio_block over %g%% of its period in more than %.0f%% of runs\n",
+               budget_pct, BUDGET_MISS_PCT);
+        return 2;
+    }
+    if (!ok) {
+        printf("\nFAIL: a check is out of tolerance (see above)\n");
+        return 3;
+    }
+    return 0;
+}
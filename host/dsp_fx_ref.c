@@ -0,0 +1,137 @@
+#include "dsp_fx_ref.h"
+#include "dsp_config.h"
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/*
+ * Float versions of the effect modules, kept on the host as the
+ * reference for the integer ones in src/dsp_fx.c: RBJ cookbook biquads
+ * in double, and the same control-rate structure for the compressor
+ * and gate (peak over FX_CTRL samples, one-pole smoothing in dB, a
+ * linear gain ramp) with exact logs and exponentials. Works on samples
+ * normalized to +-1.0 (Q15 full scale).
+ */
+
+static double smoothing(int ms) {
+    if (ms <= 0) return 1.0;
+    return 1.0 - exp(-(double)FX_CTRL / (SAMPLE_RATE_HZ * ms / 1000.0));
+}
+
+static double sat(double v) {
+    v = round(v * 32768.0);
+    if (v > 32767) v = 32767;
+    if (v < -32768) v = -32768;
+    return v / 32768.0;
+}
+
+void dsp_fx_ref_init(fx_ref_t *r, const fx_config_t *cfg) {
+    memset(r, 0, sizeof(*r));
+    r->cfg = *cfg;
+    r->gain = 1.0;
+    r->ctr = FX_CTRL;
+    if (cfg->type != FX_BIQUAD) return;
+
+    const int32_t *p = cfg->f;
+    double w0 = 2.0 * M_PI * p[1] / SAMPLE_RATE_HZ;
+    double cs = cos(w0), alpha = sin(w0) / (2.0 * p[2] / 100.0);
+    double A = pow(10.0, p[3] / 10.0 / 40.0), sA2 = 2.0 * sqrt(A) * alpha;
+    double b0, b1, b2, a0, a1, a2;
+
+    switch ((fx_eq_t)p[0]) {
+        case FX_EQ_HIGHPASS:
+            b0 = (1 + cs) / 2;  b1 = -(1 + cs);  b2 = b0;
+            a0 = 1 + alpha;  a1 = -2 * cs;  a2 = 1 - alpha;
+            break;
+        case FX_EQ_PEAK:
+            b0 = 1 + alpha * A;  b1 = -2 * cs;  b2 = 1 - alpha * A;
+            a0 = 1 + alpha / A;  a1 = -2 * cs;  a2 = 1 - alpha / A;
+            break;
+        case FX_EQ_LOW_SHELF:
+            b0 = A * ((A + 1) - (A - 1) * cs + sA2);
+            b1 = 2 * A * ((A - 1) - (A + 1) * cs);
+            b2 = A * ((A + 1) - (A - 1) * cs - sA2);
+            a0 = (A + 1) + (A - 1) * cs + sA2;
+            a1 = -2 * ((A - 1) + (A + 1) * cs);
+            a2 = (A + 1) + (A - 1) * cs - sA2;
+            break;
+        case FX_EQ_HIGH_SHELF:
+            b0 = A * ((A + 1) + (A - 1) * cs + sA2);
+            b1 = -2 * A * ((A - 1) + (A + 1) * cs);
+            b2 = A * ((A + 1) + (A - 1) * cs - sA2);
+            a0 = (A + 1) - (A - 1) * cs + sA2;
+            a1 = 2 * ((A - 1) - (A + 1) * cs);
+            a2 = (A + 1) - (A - 1) * cs - sA2;
+            break;
+        default:
+            b0 = (1 - cs) / 2;  b1 = 1 - cs;  b2 = b0;
+            a0 = 1 + alpha;  a1 = -2 * cs;  a2 = 1 - alpha;
+            break;
+    }
+    r->b0 = b0 / a0;  r->b1 = b1 / a0;  r->b2 = b2 / a0;
+    r->a1 = a1 / a0;  r->a2 = a2 / a0;
+}
+
+static void dyn_update(fx_ref_t *r) {
+    const int32_t *p = r->cfg.f;
+    double level = r->peak > 0 ? 20.0 * log10(r->peak) : -1000.0;
+    double thr = p[0] / 10.0, target, coef;
+    r->peak = 0;
+
+    if (r->cfg.type == FX_COMPRESSOR) {
+        double slope = p[1] ? 1.0 - 10.0 / p[1] : 1.0;
+        target = level > thr ? (level - thr) * slope : 0.0;
+        coef = smoothing(target > r->red ? p[2] : p[3]);
+    } else {
+        long hold = (long)((long long)p[4] * SAMPLE_RATE_HZ / (1000 * FX_CTRL));
+        target = 0.0;
+        if (level >= thr) r->held = hold;
+        else if (r->held) r->held--;
+        else target = p[1] / 10.0;
+        coef = smoothing(target < r->red ? p[2] : p[3]);
+    }
+    r->red += (target - r->red) * coef;
+
+    double db = r->cfg.type == FX_COMPRESSOR ? p[4] / 10.0 - r->red : -r->red;
+    r->step = (pow(10.0, db / 20.0) - r->gain) / FX_CTRL;
+    r->ctr = FX_CTRL;
+}
+
+void dsp_fx_ref_process(fx_ref_t *r, const int16_t *in, int16_t *out, int n) {
+    const int32_t *p = r->cfg.f;
+
+    for (int i = 0; i < n; i++) {
+        double x = in[i] / 32768.0, y = x;
+
+        switch (r->cfg.type) {
+            case FX_BIQUAD:
+                // unrounded state: the reference for the error feedback
+                y = r->b0 * x + r->b1 * r->x1 + r->b2 * r->x2 - r->a1 * r->y1 - r->a2 * r->y2;
+                r->x2 = r->x1;  r->x1 = x;
+                r->y2 = r->y1;  r->y1 = y;
+                y = sat(y);
+                break;
+            case FX_COMPRESSOR:
+            case FX_GATE:
+                if (fabs(x) > r->peak) r->peak = fabs(x);
+                r->gain += r->step;
+                y = sat(x * r->gain);
+                if (--r->ctr == 0) dyn_update(r);
+                break;
+            case FX_DELAY: {
+                long len = (long)((long long)p[0] * SAMPLE_RATE_HZ / 1000);
+                double e = r->line[(r->pos - len) & (FX_DELAY_MAX - 1)];
+                y = sat(x + e * p[2] / 32768.0);
+                r->line[r->pos] = sat(x + e * p[1] / 32768.0);
+                r->pos = (r->pos + 1) & (FX_DELAY_MAX - 1);
+                break;
+            }
+            default:
+                break;
+        }
+        out[i] = (int16_t)lrint(y * 32768.0);
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "dsp_fx.h"
+
+// Float reference for one dsp_fx module (host only)
+typedef struct {
+    fx_config_t cfg;
+    double b0, b1, b2, a1, a2;          // biquad
+    double x1, x2, y1, y2;
+    double peak, red, gain, step;       // compressor / gate
+    long   held, ctr;
+    double line[FX_DELAY_MAX];          // delay
+    long   pos;
+} fx_ref_t;
+
+// cfg as the fixed-point slot holds it (dsp_fx_config())
+void dsp_fx_ref_init(fx_ref_t *r, const fx_config_t *cfg);
+
+// n Q15 samples, like dsp_fx_process on a single slot
+void dsp_fx_ref_process(fx_ref_t *r, const int16_t *in, int16_t *out, int n);
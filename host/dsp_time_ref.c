@@ -0,0 +1,33 @@
+#include "dsp_time_ref.h"
+#include "dsp_config.h"
+#include <math.h>
+
+/*
+ * Float version of the effect path, kept on the host as the reference
+ * for the Q15 implementation in src/dsp_time.c. Works on samples
+ * normalized to +-1.0 (12-bit full scale).
+ */
+
+static float lp = 0;
+static float gain = 1.2f;
+
+void dsp_time_ref_init(void) { lp = 0; }
+
+static inline float soft_clip(float x) {
+    return x / (1.0f + fabsf(x));
+}
+
+void dsp_time_ref_process(const int16_t *in, int16_t *out, int n, float mix, bool bypass) {
+    for (int i = 0; i < n; i++) {
+        if (bypass) { out[i] = in[i]; continue; }
+
+        float dry = in[i] / 2048.0f;
+        float wet = soft_clip((lp += 0.15f * (dry * gain - lp)));
+        float v = (dry * (1 - mix) + wet * mix) * 2048.0f;
+
+        v = roundf(v);
+        if (v > 2047) v = 2047;
+        if (v < -2048) v = -2048;
+        out[i] = (int16_t)v;
+    }
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Float reference for dsp_time_process (host only)
+void dsp_time_ref_init(void);
+void dsp_time_ref_process(const int16_t *in, int16_t *out, int n, float mix, bool bypass);
@@ -0,0 +1,302 @@
+/*
+ * latency_sim - end-to-end monitoring latency through the audio path.
+ *
+ * Steps a sample clock through the firmware's audio plumbing with the
+ * real hardware-independent code: raw SPI frames into the ADC ring
+ * (adc_acq_raw_block_done() at each block boundary, as the core-0 DMA
+ * ISR does), two chained output channels that each run
+ * audio_path_step() and load audio_out_next_block() when they finish
+ * a block (as the core-1 DMA ISR does), and a core-1 main loop that
+ * takes overlapping analysis windows with audio_path_window(), spends a
+ * configurable share of the FFT_SIZE period on each and picks the next
+ * hop with dsp_hop_next() (or -h), plus back-to-back capture blocks
+ * from a second reader. Unless -W fixes the analysis window, the run
+ * is Hann for its first half and Blackman for the second, so the
+ * adaptive hop steps down to 50% and then 75% overlap.
+ *
+ * The input is low-level noise with an impulse every IMPULSE_EVERY
+ * samples (the same in both channels, the noise not), passed through
+ * with the effect bypassed; the latency of each impulse is measured at
+ * the PWM levels the output DMA would write. Every analysis window and
+ * capture block is checked against the input it should hold.
+ *
+ * Fails if the latency goes over three audio blocks (plus the ISR
+ * delay), if the output underruns once running, if a window is wrong
+ * or (with the main loop keeping up) lost, or if the adaptive hop does
+ * not end each half at the overlap the window and cost allow.
+ *
+ *   latency_sim [-s seconds] [-p out_phase] [-i isr_delay] [-c cost_pct]
+ *               [-h hop] [-W window] [-w pwm_wrap]
+ */
+#include "adc_acq.h"
+#include "audio_out.h"
+#include "audio_path.h"
+#include "dsp.h"
+#include "dsp_hop.h"
+#include "dsp_time.h"
+#include "params.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define B              AUDIO_BLOCK_SIZE
+#define IMPULSE_EVERY  1000     // samples; longer than any latency
+#define IMPULSE        1500     // 12-bit
+#define NOISE          3        // +- 12-bit LSB
+#define DETECT         200      // 12-bit units above the midpoint
+
+static const char *const window_names[DSP_WINDOW_COUNT] = { "rect", "hann", "blackman" };
+
+static int16_t *signal_in[ADC_CHANNELS];
+
+static uint32_t lcg_state = 0x13579bdfu;
+
+static uint32_t lcg(void) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return lcg_state >> 16;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+        "usage: %s [-s seconds] [-p out_phase] [-i isr_delay] [-c cost_pct]\n"
+        "          [-h hop] [-W window] [-w pwm_wrap]\n",
+        argv0);
+    exit(2);
+}
+
+// Hop the adaptive controller should settle at for a window costing
+// cost samples: the overlap the window asks for (or one window per
+// display frame), as far as each step down leaves the window at most
+// half of the smaller hop (dsp_hop.h)
+static uint32_t expected_hop(dsp_window_t window, uint32_t cost) {
+    uint32_t target = window == DSP_WINDOW_RECT ? 0
+                    : window == DSP_WINDOW_BLACKMAN ? 2 : 1;
+    while (target < 2 && (uint32_t)(FFT_SIZE >> target) > SAMPLE_RATE_HZ / ANALYSIS_FRAME_HZ)
+        target++;
+    uint32_t shift = 0;
+    while (shift < target && ((uint64_t)cost * 100u << (shift + 1)) / FFT_SIZE <= 50)
+        shift++;
+    return FFT_SIZE >> shift;
+}
+
+int main(int argc, char **argv) {
+    long seconds = 5;
+    long phase = B / 3;         // output timer start, samples after the ADC
+    long isr_delay = 2;         // samples from block end to the ISR loading
+    long cost_pct = 10;         // main loop time per window, % of FFT_SIZE samples
+    long fixed_hop = 0;         // 0 = adaptive
+    long window_opt = -1;       // -1 = Hann, then Blackman
+    long wrap = 1023;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:p:i:c:h:W:w:")) != -1) {
+        switch (opt) {
+            case 's': seconds = atol(optarg); break;
+            case 'p': phase = atol(optarg); break;
+            case 'i': isr_delay = atol(optarg); break;
+            case 'c': cost_pct = atol(optarg); break;
+            case 'h': fixed_hop = atol(optarg); break;
+            case 'W': window_opt = atol(optarg); break;
+            case 'w': wrap = atol(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (seconds < 1 || phase < 0 || isr_delay < 0 || isr_delay >= B ||
+        cost_pct < 0 || fixed_hop < 0 || fixed_hop > FFT_SIZE || window_opt < -1 ||
+        window_opt >= DSP_WINDOW_COUNT || wrap < 1 || wrap > 4095)
+        usage(argv[0]);
+
+    const uint64_t total = (uint64_t)seconds * SAMPLE_RATE_HZ;
+    for (int c = 0; c < ADC_CHANNELS; c++) {
+        signal_in[c] = malloc(total * sizeof(*signal_in[c]));
+        if (!signal_in[c]) { perror("malloc"); return 1; }
+
+        for (uint64_t t = 0; t < total; t++) {
+            int16_t s = (int16_t)((int)(lcg() % (2 * NOISE + 1)) - NOISE);
+            if (t % IMPULSE_EVERY == IMPULSE_EVERY / 2) s = IMPULSE;
+            signal_in[c][t] = s;
+        }
+    }
+
+    int32_t applied;
+    params_init();
+    param_set(PARAM_BYPASS, 1, &applied);
+    dsp_init();
+    dsp_time_init();
+    adc_acq_init();
+    audio_path_init((uint16_t)wrap);
+    audio_out_init((uint16_t)((wrap + 1) / 2));
+
+    const uint16_t *chan_buf[2] = { audio_out_silence(), audio_out_silence() };
+    int playing = 0;
+    int64_t isr_at = -1;        // when the finished channel gets its ISR
+    int isr_chan = 0;
+
+    const uint16_t mid = (uint16_t)((wrap + 1) / 2);
+    const uint16_t detect = (uint16_t)(DETECT * (wrap + 1) / 4096);
+    int64_t last_impulse = -1;
+    bool matched = true;
+    uint64_t impulses = 0, detected = 0, missed = 0;
+    int64_t lat_min = INT64_MAX, lat_max = 0;
+
+    // Costs in samples: the window period is FFT_SIZE of them
+    static int16_t win_in[ADC_CHANNELS * FFT_SIZE], cap_in[ADC_CHANNELS * FFT_SIZE];
+    static int16_t cap_mono[FFT_SIZE], cap_out[FFT_SIZE];
+    audio_reader_t analysis, capture;
+    audio_reader_init(&analysis);
+    audio_reader_init(&capture);
+    dsp_hop_t hop_ctl;
+    dsp_hop_init(&hop_ctl, FFT_SIZE);
+    const uint32_t cost = (uint32_t)((uint64_t)FFT_SIZE * cost_pct / 100);
+    uint32_t hop = FFT_SIZE, hop_min = FFT_SIZE, hop_max = 0;
+    uint64_t windows_at[3] = { 0 };     // by hop: FFT_SIZE, /2, /4
+    dsp_window_t window_of[2] = {
+        window_opt < 0 ? DSP_WINDOW_HANN : (dsp_window_t)window_opt,
+        window_opt < 0 ? DSP_WINDOW_BLACKMAN : (dsp_window_t)window_opt,
+    };
+    uint32_t hop_end[2];        // the hop at the end of each half
+    int half = 0;
+    dsp_set_window(window_of[0]);
+    uint64_t busy_until = 0, windows = 0, win_errors = 0;
+    uint64_t cap_blocks = 0, cap_errors = 0;
+    int64_t last_seq = -1;
+
+    for (uint64_t t = 0; t < total; t++) {
+        if (half == 0 && t == total / 2) {
+            hop_end[0] = hop;
+            half = 1;
+            dsp_set_window(window_of[1]);
+        }
+
+        /* ADC: sample t lands in the raw ring; a full block goes to the ISR */
+        uint16_t *raw = adc_raw_ring[(t / B) & (ADC_RAW_BLOCKS - 1)];
+        uint32_t i = (uint32_t)(t % B);
+        for (int c = 0; c < ADC_CHANNELS; c++) {
+            uint16_t code = (uint16_t)(signal_in[c][t] + 2048);
+            uint16_t *f = &raw[i * ADC_FRAMES_PER_PERIOD + c * ADC_FRAMES_PER_SAMPLE];
+            f[0] = (uint16_t)((lcg() & 0x1E0) | (code >> 8));
+            f[1] = (uint16_t)(((code & 0xFF) << 1) | (lcg() & 1));
+        }
+        if (i == B - 1) adc_acq_raw_block_done();
+
+        if (signal_in[0][t] == IMPULSE) {
+            if (!matched) missed++;     // the last one never came out
+            last_impulse = (int64_t)t;
+            matched = false;
+            impulses++;
+        }
+
+        /* Output: channels take turns; the finished one gets its ISR */
+        if ((int64_t)t < phase) continue;
+        uint64_t pos = (t - (uint64_t)phase) % B;
+        if (pos == 0 && t > (uint64_t)phase) {
+            isr_chan = playing;
+            playing ^= 1;
+            isr_at = (int64_t)t + isr_delay;
+        }
+        if ((int64_t)t == isr_at) {
+            audio_path_step();
+            chan_buf[isr_chan] = audio_out_next_block();
+        }
+
+        uint16_t level = chan_buf[playing][pos];
+        if (!matched && level > mid + detect) {
+            int64_t lat = (int64_t)t - last_impulse;
+            if (lat < lat_min) lat_min = lat;
+            if (lat > lat_max) lat_max = lat;
+            matched = true;
+            detected++;
+        }
+
+        /* Core 1 main loop: one window at a time, cost samples each */
+        if (t >= busy_until) {
+            uint32_t seq;
+            if (audio_path_window(&capture, FFT_SIZE, cap_in, cap_out, &seq)) {
+                uint64_t start = (uint64_t)seq * FFT_SIZE;
+                adc_mono(cap_in, cap_mono, FFT_SIZE);
+                for (int j = 0; j < ADC_CHANNELS * FFT_SIZE; j++)
+                    if (cap_in[j] != signal_in[j / FFT_SIZE][start + j % FFT_SIZE] ||
+                        (j < FFT_SIZE && cap_out[j] != cap_mono[j])) {
+                        cap_errors++;
+                        break;
+                    }
+                cap_blocks++;
+            }
+            if (audio_path_window(&analysis, hop, win_in, NULL, &seq)) {
+                // stream position of the window just taken
+                uint64_t start = (uint64_t)(analysis.next_end - hop - FFT_SIZE);
+                for (int j = 0; j < ADC_CHANNELS * FFT_SIZE; j++)
+                    if (win_in[j] != signal_in[j / FFT_SIZE][start + j % FFT_SIZE]) {
+                        win_errors++;
+                        break;
+                    }
+                if ((int64_t)seq <= last_seq) win_errors++;
+                last_seq = seq;
+#if ADC_CHANNELS == 2
+                dsp_process_stereo(win_in, DSP_VIEW_LR);
+#else
+                dsp_process(win_in);
+#endif
+                windows++;
+                for (int k = 0; k < 3; k++)
+                    if (hop == (uint32_t)(FFT_SIZE >> k)) windows_at[k]++;
+                busy_until = t + cost;
+
+                hop = dsp_hop_next(&hop_ctl, cost, window_of[half], (uint32_t)fixed_hop);
+                if (windows > 16) {     // settled
+                    if (hop < hop_min) hop_min = hop;
+                    if (hop > hop_max) hop_max = hop;
+                }
+            }
+        }
+    }
+
+    hop_end[1] = hop;
+
+    double ms = 1000.0 / SAMPLE_RATE_HZ;
+    printf("audio block %d, FFT %d, %d Hz; output phase %ld, ISR delay %ld, "
+           "analysis cost %ld%% of FFT_SIZE samples\n",
+           B, FFT_SIZE, SAMPLE_RATE_HZ, phase, isr_delay, cost_pct);
+    printf("impulses: %llu in, %llu out, %llu lost\n",
+           (unsigned long long)impulses, (unsigned long long)detected,
+           (unsigned long long)missed);
+    if (detected)
+        printf("latency: %lld..%lld samples (%.2f..%.2f ms); FFT_SIZE blocks would be >= %.2f ms\n",
+               (long long)lat_min, (long long)lat_max, lat_min * ms, lat_max * ms,
+               2.0 * FFT_SIZE * ms);
+    printf("output: %u underruns, %u overruns; ADC blocks skipped %u, dropped %u\n",
+           audio_out_underruns(), audio_out_overruns(), audio_path_skipped(),
+           adc_dropped_blocks());
+    printf("analysis: %llu windows, hop %u..%u, %u dropped, %llu bad\n",
+           (unsigned long long)windows, hop_min, hop_max, analysis.dropped,
+           (unsigned long long)win_errors);
+    printf("hop: %llu windows at %d, %llu at %d, %llu at %d\n",
+           (unsigned long long)windows_at[0], FFT_SIZE,
+           (unsigned long long)windows_at[1], FFT_SIZE / 2,
+           (unsigned long long)windows_at[2], FFT_SIZE / 4);
+    bool hop_ok = true;
+    for (int h = 0; h < 2; h++) {
+        uint32_t want = fixed_hop ? hop_end[h] : expected_hop(window_of[h], cost);
+        printf("  %s half, %s: hop %u at the end", h ? "second" : "first",
+               window_names[window_of[h]], hop_end[h]);
+        if (fixed_hop) printf(" (fixed)\n");
+        else printf(", expected %u\n", want);
+        if (hop_end[h] != want) hop_ok = false;
+    }
+    printf("capture: %llu blocks, %u dropped, %llu bad\n",
+           (unsigned long long)cap_blocks, capture.dropped,
+           (unsigned long long)cap_errors);
+
+    bool ok = detected > 0 && missed == 0 && detected + 1 >= impulses &&
+              lat_max <= 3 * B + isr_delay &&
+              audio_out_underruns() == 0 && audio_out_overruns() == 0 &&
+              win_errors == 0 && cap_errors == 0 && hop_ok &&
+              (cost_pct * hop_max > 100 * FFT_SIZE ||
+               (analysis.dropped == 0 && capture.dropped == 0));
+    printf("%s\n", ok ? "OK" : "FAIL");
+    for (int c = 0; c < ADC_CHANNELS; c++) free(signal_in[c]);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,24 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "prof.h"
+
+#include <time.h>
+
+// CLOCK_MONOTONIC in nanoseconds, truncated to 32 bits (wraps every ~4 s)
+
+void prof_clock_init(void) {
+}
+
+uint32_t prof_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+uint32_t prof_clock_mask(void) {
+    return UINT32_MAX;
+}
+
+uint32_t prof_tick_hz(void) {
+    return 1000000000u;
+}
@@ -0,0 +1,232 @@
+/*
+ * sched_sim - the event-driven main loops against simulated events.
+ *
+ * Steps a microsecond clock through the wake-ups the firmware sees:
+ * the output DMA interrupt on core 1 after each audio block (which
+ * SEVs both cores), the ADC DMA interrupt on core 0 half a block later,
+ * the USB stack's 1 ms tick, and the I2C interrupt at the end of each
+ * display frame on the bus. Core 1 takes a window every hop samples
+ * once the audio path has written it, spends cost_pct of the hop on it
+ * and publishes a band frame (SEV). Core 0 runs the main.c loop with
+ * the real display pacer (sched.h) and sleeps in between, with the
+ * pacer's timer for a held frame.
+ *
+ * The same input also goes through the old core-0 loop, which looked
+ * for a new frame every millisecond and drew every one it found, for
+ * comparison. Latency is from publishing a frame to drawing it. The
+ * interrupts wake core 0 either way; the event-driven loop runs a
+ * (short) pass on each of them.
+ *
+ * Fails if two renders are closer than the cap allows, a frame is
+ * drawn twice or late (past 1.25 cap periods or the bus time, whichever
+ * is longer), a frame is neither drawn nor superseded, or core 0
+ * sleeps through a frame it should draw.
+ *
+ *   sched_sim [-s seconds] [-f max_fps] [-h hop] [-c cost_pct] [-b bus_us]
+ */
+#include "dsp_config.h"
+#include "sched.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define B         AUDIO_BLOCK_SIZE
+#define USB_TICK  1000      // us
+#define OLD_POLL  1000      // us, the old sleep_ms(1)
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+        "usage: %s [-s seconds] [-f max_fps] [-h hop] [-c cost_pct] [-b bus_us]\n",
+        argv0);
+    exit(2);
+}
+
+// Sample clock: samples complete by time t (us)
+static uint64_t samples_at(uint64_t t) {
+    return t * SAMPLE_RATE_HZ / 1000000u;
+}
+
+typedef struct {
+    uint64_t renders, twice;
+    uint64_t lat_sum, lat_max;
+    uint64_t gap_min;
+    uint64_t last_render;
+    uint32_t shown;
+} render_stats_t;
+
+static void render_note(render_stats_t *r, uint32_t frame, uint64_t t,
+                        const uint64_t *published_at) {
+    if (frame == r->shown) r->twice++;
+    if (r->renders && t - r->last_render < r->gap_min) r->gap_min = t - r->last_render;
+    uint64_t lat = t - published_at[frame];
+    r->lat_sum += lat;
+    if (lat > r->lat_max) r->lat_max = lat;
+    r->last_render = t;
+    r->shown = frame;
+    r->renders++;
+}
+
+int main(int argc, char **argv) {
+    long seconds = 10;
+    long max_fps = ANALYSIS_FRAME_HZ;
+    long hop = FFT_SIZE / 4;
+    long cost_pct = 40;         // core 1 time per window, % of the hop
+    long bus_us = 1600;         // one frame on the I2C bus (400 kHz)
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:f:h:c:b:")) != -1) {
+        switch (opt) {
+            case 's': seconds = atol(optarg); break;
+            case 'f': max_fps = atol(optarg); break;
+            case 'h': hop = atol(optarg); break;
+            case 'c': cost_pct = atol(optarg); break;
+            case 'b': bus_us = atol(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (seconds < 1 || max_fps < 0 || max_fps > 1000 || hop < 1 || hop > FFT_SIZE ||
+        cost_pct < 0 || cost_pct >= 100 || bus_us < 0)
+        usage(argv[0]);
+
+    const uint64_t total = (uint64_t)seconds * 1000000u;
+    const uint64_t hop_us = (uint64_t)hop * 1000000u / SAMPLE_RATE_HZ;
+    const uint64_t cost_us = hop_us * (uint64_t)cost_pct / 100;
+    uint64_t *published_at = calloc(total / (hop_us ? hop_us : 1) + 2, sizeof(*published_at));
+    if (!published_at) { perror("calloc"); return 1; }
+
+    /* Core 1 */
+    uint64_t written = 0;           // samples in the history (at the last ISR)
+    uint64_t next_window = 0;       // index of the next window to take
+    uint64_t c1_busy_until = 0, c1_busy = 0, c1_wakes = 0;
+    bool c1_working = false, c1_sev = false;
+    uint32_t published = 0;
+
+    /* Core 0, event driven */
+    sched_pacer_t pacer;
+    sched_pacer_init(&pacer, (uint32_t)max_fps);
+    uint32_t last_frame = 0;
+    uint64_t bus_free = 0, timer_at = UINT64_MAX;
+    uint64_t c0_wakes = 0, c0_draw_wakes = 0, missed = 0;
+    render_stats_t ev = { .gap_min = UINT64_MAX };
+
+    /* Core 0, the old 1 ms poll */
+    uint64_t old_bus_free = 0, old_wakes = 0;
+    uint32_t old_last = 0;
+    render_stats_t old = { .gap_min = UINT64_MAX };
+
+    uint64_t prev_block = 0, prev_adc = 0;
+    for (uint64_t t = 0; t < total; t++) {
+        uint64_t s = samples_at(t);
+        bool wake0 = false, wake1 = false;
+
+        /* Output DMA interrupt on core 1: a block into the history, SEV */
+        if (s / B != prev_block) {
+            prev_block = s / B;
+            written = prev_block * B;
+            wake1 = wake0 = true;
+        }
+        /* ADC DMA interrupt on core 0, half a block out of phase */
+        if ((s + B / 2) / B != prev_adc) {
+            prev_adc = (s + B / 2) / B;
+            wake0 = true;
+        }
+        if (t % USB_TICK == 0) wake0 = true;
+        if (bus_us && t == bus_free) wake0 = true;     // I2C done
+        if (t == timer_at) wake0 = true;
+
+        /* Core 1: finish the window in hand, then take the next one */
+        if (c1_working && t >= c1_busy_until) {
+            c1_working = false;
+            published_at[++published] = t;
+            wake0 = true;       // SEV
+            c1_sev = true;      // and its own event register
+        }
+        if (wake1 || c1_sev) {
+            c1_sev = false;
+            if (!c1_working) {
+                c1_wakes++;
+                if (written >= FFT_SIZE + next_window * (uint64_t)hop) {
+                    next_window++;
+                    c1_working = true;
+                    c1_busy_until = t + (cost_us ? cost_us : 1);
+                    c1_busy += cost_us;
+                }
+            }
+        }
+
+        /* Core 0: the main.c loop on each wake */
+        if (wake0) {
+            c0_wakes++;
+            bool drew = false;
+            last_frame = published;
+
+            uint32_t wake = 0;
+            sched_action_t act = sched_pacer_poll(&pacer, last_frame, (uint32_t)t, &wake);
+            if (act == SCHED_RENDER && t >= bus_free) {
+                render_note(&ev, last_frame, t, published_at);
+                sched_pacer_done(&pacer, last_frame, (uint32_t)t);
+                bus_free = t + (uint64_t)bus_us;
+                act = SCHED_IDLE;
+                drew = true;
+            }
+            timer_at = act == SCHED_HOLD ? t + (uint32_t)(wake - (uint32_t)t) : UINT64_MAX;
+            if (drew) c0_draw_wakes++;
+        }
+
+        /* Core 0 asleep (or back to sleep) with a frame it could draw */
+        sched_pacer_t probe = pacer;
+        uint32_t w;
+        if (published != pacer.shown && t >= bus_free &&
+            sched_pacer_poll(&probe, published, (uint32_t)t, &w) == SCHED_RENDER)
+            missed++;
+
+        /* The old loop */
+        if (t % OLD_POLL == 0) {
+            old_wakes++;
+            if (published != old_last) {
+                old_last = published;
+                if (t >= old_bus_free) {
+                    render_note(&old, published, t, published_at);
+                    old_bus_free = t + (uint64_t)bus_us;
+                }
+            }
+        }
+    }
+
+    uint64_t bound = pacer.period_us + pacer.period_us / 4;
+    if ((uint64_t)bus_us > bound) bound = (uint64_t)bus_us;
+    bound += 1;
+
+    uint64_t accounted = pacer.renders + pacer.superseded;
+    double sec = (double)seconds;
+    printf("audio block %d, FFT %d, %d Hz; hop %ld (%.2f ms), core-1 cost %ld%%, "
+           "cap %ld fps, bus %ld us\n",
+           B, FFT_SIZE, SAMPLE_RATE_HZ, hop, hop_us / 1000.0, cost_pct, max_fps, bus_us);
+    printf("core 1: %.0f wakes/s, awake %.1f%% (the spin loop: 100%%)\n",
+           c1_wakes / sec, 100.0 * c1_busy / total);
+    printf("band frames: %.0f/s published\n", published / sec);
+    printf("event driven: %.0f renders/s, %.0f loop passes/s (%.0f drawing), "
+           "latency mean %.0f us, max %llu us, gap min %llu us\n",
+           ev.renders / sec, c0_wakes / sec, c0_draw_wakes / sec,
+           ev.renders ? (double)ev.lat_sum / ev.renders : 0.0,
+           (unsigned long long)ev.lat_max,
+           (unsigned long long)(ev.renders > 1 ? ev.gap_min : 0));
+    printf("1 ms poll:    %.0f renders/s, %.0f loop passes/s, latency mean %.0f us, max %llu us\n",
+           old.renders / sec, old_wakes / sec,
+           old.renders ? (double)old.lat_sum / old.renders : 0.0,
+           (unsigned long long)old.lat_max);
+    printf("frames: %u published, %llu drawn, %u superseded, %llu drawn twice, "
+           "%llu slept through\n",
+           published, (unsigned long long)pacer.renders, pacer.superseded,
+           (unsigned long long)ev.twice, (unsigned long long)missed);
+
+    bool ok = ev.renders > 0 && ev.twice == 0 && missed == 0 &&
+              ev.lat_max <= bound && accounted == pacer.shown &&
+              (ev.renders < 2 || ev.gap_min >= pacer.period_us);
+    printf("%s\n", ok ? "OK" : "FAIL");
+    free(published_at);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,703 @@
+/*
+ * tlm_cli - host side of the USB telemetry protocol (src/telemetry.h).
+ *
+ *   tlm_cli [-d tty] monitor [frames]   print band frames, stats, profiles
+ *   tlm_cli [-d tty] list               list device parameters
+ *   tlm_cli [-d tty] get NAME
+ *   tlm_cli [-d tty] set NAME VALUE...  Q15 parameters take 0.0..1.0;
+ *                                       several NAME VALUE pairs are
+ *                                       one write (TLM_SET_MANY)
+ *   tlm_cli [-d tty] capture adc|audio SECONDS FILE.wav
+ *   tlm_cli [-d tty] prof [reset]       per-stage timing, optionally reset
+ *   tlm_cli -L                          self-check against a pty stand-in
+ *
+ * The default tty is /dev/ttyACM0. capture streams 12-bit blocks from
+ * the device and writes them as 16-bit mono WAV at the device's sample
+ * rate; blocks missing from the sequence (dropped on the device or
+ * damaged on the link) are written as silence so the timing holds.
+ *
+ * -L forks tlm_dev_sim on the master side of a pty (with a damaged frame
+ * now and then) and runs list, get/set, monitor and capture against the
+ * slave side, exactly as against a unit.
+ */
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+
+#include "capture.h"
+#include "dsp_config.h"
+#include "params.h"
+#include "prof.h"
+#include "telemetry.h"
+#include "tlm_dev_sim.h"
+#include "wav.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define REPLY_TIMEOUT_MS 1000
+#define REQUEST_TRIES    3
+#define MAX_PARAMS       64
+#define NAME_MAX_LEN     16
+
+static int link_fd = -1;
+static tlm_decoder_t dec;
+static uint8_t req_seq;
+
+typedef struct {
+    uint8_t id;
+    uint8_t type;
+    int32_t min, max, def;
+    char    name[NAME_MAX_LEN + 1];
+} param_info_t;
+
+static param_info_t params[MAX_PARAMS];
+static int num_params;
+
+/* ---------- Link ---------- */
+
+static int set_raw(int fd) {
+    struct termios t;
+    if (tcgetattr(fd, &t) < 0) return -1;
+    cfmakeraw(&t);
+    return tcsetattr(fd, TCSANOW, &t);
+}
+
+static int open_link(const char *path) {
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0 || set_raw(fd) < 0) {
+        perror(path);
+        return -1;
+    }
+    return fd;
+}
+
+static int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static bool send_msg(const tlm_msg_t *msg) {
+    uint8_t wire[TLM_MAX_WIRE];
+    size_t n = tlm_encode(msg, wire);
+    return write(link_fd, wire, n) == (ssize_t)n;
+}
+
+// Next valid message, or false on timeout / link closed
+static bool recv_msg(tlm_msg_t *msg, int timeout_ms) {
+    static uint8_t buf[512];
+    static size_t len, pos;
+    int64_t deadline = now_ms() + timeout_ms;
+
+    for (;;) {
+        while (pos < len)
+            if (tlm_decode_byte(&dec, buf[pos++], msg)) return true;
+
+        int left = (int)(deadline - now_ms());
+        if (left <= 0) return false;
+
+        struct pollfd p = { .fd = link_fd, .events = POLLIN };
+        if (poll(&p, 1, left) <= 0) return false;
+
+        ssize_t n = read(link_fd, buf, sizeof(buf));
+        if (n <= 0) return false;
+        len = (size_t)n;
+        pos = 0;
+    }
+}
+
+// Send a request and wait for its reply (of type want), skipping
+// streamed messages. A corrupted frame either way is dropped by the
+// CRC check, so the request goes again (they are all idempotent).
+static bool exchange(tlm_msg_t *req, uint8_t want, tlm_msg_t *reply) {
+    for (int tries = 0; tries < REQUEST_TRIES; tries++) {
+        req->seq = ++req_seq;
+        if (!send_msg(req)) return false;
+
+        int64_t deadline = now_ms() + REPLY_TIMEOUT_MS / REQUEST_TRIES;
+        int left;
+        while ((left = (int)(deadline - now_ms())) > 0) {
+            if (!recv_msg(reply, left)) break;
+            if (reply->type == want && reply->seq == req->seq) return true;
+        }
+    }
+    fprintf(stderr, "no reply to request 0x%02x\n", req->type);
+    return false;
+}
+
+static bool transact(uint8_t type, uint8_t id, const int32_t *value, tlm_msg_t *reply) {
+    uint8_t want = type == TLM_INFO ? TLM_PARAM_INFO :
+                   type == TLM_PROF_GET || type == TLM_PROF_RESET ? TLM_PROFILE : TLM_PARAM;
+    tlm_msg_t req;
+    tlm_msg_init(&req, type, 0);
+    tlm_put_u8(&req, id);
+    if (value) tlm_put_u32(&req, (uint32_t)*value);
+    return exchange(&req, want, reply);
+}
+
+/* ---------- Parameters ---------- */
+
+static const char *status_names[] = { "ok", "clamped", "bad id", "bad request" };
+
+static const char *status_name(uint8_t s) {
+    return s < sizeof(status_names) / sizeof(status_names[0]) ? status_names[s] : "?";
+}
+
+static void format_value(const param_info_t *p, int32_t v, char *out, size_t size) {
+    if (p->type == PARAM_Q15)
+        snprintf(out, size, "%.4f", v / 32768.0);
+    else
+        snprintf(out, size, "%ld", (long)v);
+}
+
+static bool parse_value(const param_info_t *p, const char *s, int32_t *v) {
+    char *end;
+    if (p->type == PARAM_Q15) {
+        double d = strtod(s, &end);
+        if (end == s || *end) return false;
+        *v = (int32_t)lrint(d * 32768.0);
+    } else {
+        long l = strtol(s, &end, 0);
+        if (end == s || *end) return false;
+        *v = (int32_t)l;
+    }
+    return true;
+}
+
+static bool fetch_params(void) {
+    tlm_msg_t r;
+    num_params = 0;
+
+    for (int id = 0; id < MAX_PARAMS; id++) {
+        if (!transact(TLM_INFO, (uint8_t)id, NULL, &r)) return false;
+
+        size_t pos = 1;
+        uint8_t status = tlm_get_u8(&r, &pos);
+        if (status == PARAM_BAD_ID) break;
+
+        param_info_t *p = &params[num_params++];
+        p->id = (uint8_t)id;
+        p->type = tlm_get_u8(&r, &pos);
+        p->min = (int32_t)tlm_get_u32(&r, &pos);
+        p->max = (int32_t)tlm_get_u32(&r, &pos);
+        p->def = (int32_t)tlm_get_u32(&r, &pos);
+        size_t n = 0;
+        while (pos < r.len && n < NAME_MAX_LEN) p->name[n++] = (char)r.payload[pos++];
+        p->name[n] = '\0';
+    }
+    return true;
+}
+
+static const param_info_t *find_param(const char *name) {
+    for (int i = 0; i < num_params; i++)
+        if (strcmp(params[i].name, name) == 0) return &params[i];
+    fprintf(stderr, "unknown parameter '%s'\n", name);
+    return NULL;
+}
+
+static int cmd_list(void) {
+    static const char *type_names[] = { "q15", "bool", "int" };
+    tlm_msg_t r;
+
+    for (int i = 0; i < num_params; i++) {
+        const param_info_t *p = &params[i];
+        char val[24] = "?", lo[24], hi[24];
+
+        if (transact(TLM_GET, p->id, NULL, &r)) {
+            size_t pos = 3;
+            format_value(p, (int32_t)tlm_get_u32(&r, &pos), val, sizeof(val));
+        }
+        format_value(p, p->min, lo, sizeof(lo));
+        format_value(p, p->max, hi, sizeof(hi));
+        printf("%-12s %-4s %10s  [%s .. %s]\n", p->name,
+               p->type < 3 ? type_names[p->type] : "?", val, lo, hi);
+    }
+    return 0;
+}
+
+// GET (value NULL) or SET; prints and returns the device's value
+static bool param_request(const param_info_t *p, const int32_t *value, int32_t *got, uint8_t *status) {
+    tlm_msg_t r;
+    if (!transact(value ? TLM_SET : TLM_GET, p->id, value, &r)) return false;
+
+    size_t pos = 1;
+    *status = tlm_get_u8(&r, &pos);
+    pos++;
+    *got = (int32_t)tlm_get_u32(&r, &pos);
+
+    char val[24];
+    format_value(p, *got, val, sizeof(val));
+    printf("%s = %s (%s)\n", p->name, val, status_name(*status));
+    return true;
+}
+
+// n parameters in one SET_MANY (one write on the device); prints each
+// and returns the device's values and statuses
+static bool param_set_many(const param_info_t *const *p, const int32_t *value, int n,
+                           int32_t *got, uint8_t *status) {
+    tlm_msg_t req, r;
+    tlm_msg_init(&req, TLM_SET_MANY, 0);
+    tlm_put_u8(&req, (uint8_t)n);
+    for (int i = 0; i < n; i++) {
+        tlm_put_u8(&req, p[i]->id);
+        tlm_put_u32(&req, (uint32_t)value[i]);
+    }
+    if (!exchange(&req, TLM_PARAMS, &r)) return false;
+
+    size_t pos = 0;
+    if (tlm_get_u8(&r, &pos) != n) {
+        fprintf(stderr, "device refused the request\n");
+        return false;
+    }
+    for (int i = 0; i < n; i++) {
+        uint8_t id = tlm_get_u8(&r, &pos);
+        status[i] = tlm_get_u8(&r, &pos);
+        pos++;
+        got[i] = (int32_t)tlm_get_u32(&r, &pos);
+        if (id != p[i]->id) return false;
+
+        char val[24];
+        format_value(p[i], got[i], val, sizeof(val));
+        printf("%s = %s (%s)\n", p[i]->name, val, status_name(status[i]));
+    }
+    return true;
+}
+
+/* ---------- Profiles ---------- */
+
+static double ticks_us(uint32_t ticks, uint32_t tick_hz) {
+    return tick_hz ? ticks * 1e6 / tick_hz : 0.0;
+}
+
+static void print_profile(int stage, const prof_stat_t *s, uint32_t tick_hz) {
+    const char *name = stage < PROF_STAGE_COUNT ? prof_stage_names[stage] : "?";
+
+    printf("%-15s %8lu  %9.1f %9.1f %9.1f  %9.1f %9.1f",
+           name, (unsigned long)s->count,
+           ticks_us(s->min, tick_hz), ticks_us((uint32_t)s->sum, tick_hz),
+           ticks_us(s->max, tick_hz),
+           ticks_us(prof_percentile(s, 50), tick_hz),
+           ticks_us(prof_percentile(s, 99), tick_hz));
+    if (s->deadline)
+        printf("  %lu > %.0f us", (unsigned long)s->misses, ticks_us(s->deadline, tick_hz));
+    printf("\n");
+}
+
+static void print_profile_header(void) {
+    printf("%-15s %8s  %9s %9s %9s  %9s %9s  %s\n", "stage", "count",
+           "min us", "mean us", "max us", "p50 >=", "p99 >=", "deadline misses");
+}
+
+static int cmd_prof(bool reset) {
+    tlm_msg_t r;
+    prof_stat_t s;
+    uint32_t tick_hz;
+
+    if (reset && !transact(TLM_PROF_RESET, 0, NULL, &r)) return 1;
+
+    print_profile_header();
+    for (int i = 0; i < PROF_STAGE_COUNT; i++) {
+        if (!transact(TLM_PROF_GET, (uint8_t)i, NULL, &r)) return 1;
+        int stage = tlm_unpack_profile(&r, &s, &tick_hz);
+        if (stage < 0) break;
+        print_profile(stage, &s, tick_hz);
+    }
+    return 0;
+}
+
+/* ---------- Monitor ---------- */
+
+typedef struct {
+    uint32_t frames, first_frame, last_frame, frame_gaps;
+    uint32_t stats, profiles;
+} monitor_result_t;
+
+static void monitor(long max_frames, bool quiet, monitor_result_t *res) {
+    tlm_msg_t m;
+    int16_t levels[NUM_BANDS];
+    memset(res, 0, sizeof(*res));
+
+    while ((max_frames <= 0 || res->frames < (uint32_t)max_frames) &&
+           recv_msg(&m, REPLY_TIMEOUT_MS)) {
+        if (m.type == TLM_BANDS) {
+            uint32_t frame;
+            int n = tlm_unpack_bands(&m, &frame, levels, NUM_BANDS);
+
+            if (res->frames && frame != res->last_frame + 1) res->frame_gaps++;
+            if (!res->frames) res->first_frame = frame;
+            res->last_frame = frame;
+            res->frames++;
+
+            if (!quiet) {
+                printf("B %6lu:", (unsigned long)frame);
+                for (int i = 0; i < n; i++) printf(" %4d", (levels[i] + 128) >> 8);
+                printf("\n");
+            }
+        } else if (m.type == TLM_STATS) {
+            tlm_stats_t s;
+            tlm_unpack_stats(&m, &s);
+            res->stats++;
+            if (!quiet)
+                printf("S frame=%lu adc_dropped=%lu adc_late=%lu disp=%lu disp_err=%lu "
+                       "tx_dropped=%lu rx_bad=%lu\n",
+                       (unsigned long)s.frame, (unsigned long)s.adc_dropped,
+                       (unsigned long)s.adc_late, (unsigned long)s.disp_frames,
+                       (unsigned long)s.disp_errors, (unsigned long)s.tx_dropped,
+                       (unsigned long)s.rx_bad);
+            if (!quiet && s.cap_dropped)
+                printf("S capture_dropped=%lu\n", (unsigned long)s.cap_dropped);
+            if (!quiet && (s.audio_underruns || s.audio_overruns ||
+                           s.audio_skipped || s.win_dropped))
+                printf("S audio_underruns=%lu audio_overruns=%lu audio_skipped=%lu "
+                       "win_dropped=%lu\n",
+                       (unsigned long)s.audio_underruns, (unsigned long)s.audio_overruns,
+                       (unsigned long)s.audio_skipped, (unsigned long)s.win_dropped);
+            if (!quiet && s.stft_hop)
+                printf("S stft_hop=%lu\n", (unsigned long)s.stft_hop);
+        } else if (m.type == TLM_PROFILE) {
+            prof_stat_t p;
+            uint32_t tick_hz;
+            int stage = tlm_unpack_profile(&m, &p, &tick_hz);
+            res->profiles++;
+            if (!quiet && stage >= 0) {
+                printf("P ");
+                print_profile(stage, &p, tick_hz);
+            }
+        }
+    }
+}
+
+/* ---------- Capture ---------- */
+
+#define MAX_CAPTURE_CHUNKS (2048 / CAPTURE_CHUNK_SAMPLES)
+
+typedef struct {
+    uint32_t blocks;        // complete blocks written
+    uint32_t missing;       // blocks written as silence
+    uint32_t samples;
+} capture_result_t;
+
+static bool set_param(const char *name, int32_t v) {
+    const param_info_t *p = find_param(name);
+    int32_t got;
+    uint8_t status;
+    return p && param_request(p, &v, &got, &status) && status == PARAM_OK;
+}
+
+static int write_block(wav_writer_t *w, const int16_t *s, int n, uint32_t want) {
+    int16_t out[2048];
+    if ((uint32_t)n > want) n = (int)want;
+    for (int i = 0; i < n; i++) out[i] = s ? (int16_t)(s[i] * 16) : 0;   // 12 → 16 bit
+    return wav_write(w, out, (size_t)n) == 0 ? n : -1;
+}
+
+static int capture(const char *source, double seconds, const char *path, capture_result_t *res) {
+    const param_info_t *rate_p = find_param("sample_rate");
+    int32_t rate;
+    uint8_t status;
+    memset(res, 0, sizeof(*res));
+
+    capture_source_t src = strcmp(source, "adc") == 0   ? CAPTURE_ADC :
+                           strcmp(source, "audio") == 0 ? CAPTURE_AUDIO : CAPTURE_OFF;
+    if (src == CAPTURE_OFF || seconds <= 0) return 2;
+    if (!rate_p || !param_request(rate_p, NULL, &rate, &status)) return 1;
+
+    wav_writer_t w;
+    if (wav_open_write(&w, path, (uint32_t)rate, 1) < 0) {
+        perror(path);
+        return 1;
+    }
+    if (!set_param("capture", src)) return 1;
+
+    uint32_t want = (uint32_t)(seconds * rate);
+    int16_t block[2048];
+    uint32_t cur_seq = 0, next_seq = 0, have = 0;
+    int chunks = 0;
+    bool started = false, in_block = false;
+
+    // assemble chunks into blocks; write a block once all its chunks are in
+    tlm_msg_t m;
+    while (res->samples < want && recv_msg(&m, REPLY_TIMEOUT_MS)) {
+        if (m.type != TLM_CAPTURE) continue;
+
+        size_t pos = 0;
+        uint32_t seq = tlm_get_u32(&m, &pos);
+        uint8_t msrc = tlm_get_u8(&m, &pos);
+        uint8_t chunk = tlm_get_u8(&m, &pos);
+        uint8_t nchunks = tlm_get_u8(&m, &pos);
+        if (msrc != src || !nchunks || nchunks > MAX_CAPTURE_CHUNKS || chunk >= nchunks ||
+            m.len - pos != CAPTURE_CHUNK_BYTES)
+            continue;
+
+        if (!in_block || seq != cur_seq) {
+            // a new block: anything unfinished before it is lost
+            if (!started) { next_seq = seq; started = true; }
+            cur_seq = seq;
+            have = 0;
+            chunks = nchunks;
+            in_block = true;
+        }
+        capture_unpack(&m.payload[pos], CAPTURE_CHUNK_SAMPLES,
+                       &block[chunk * CAPTURE_CHUNK_SAMPLES]);
+        have |= 1u << chunk;
+        if (have != (1u << chunks) - 1) continue;
+
+        // complete: fill any blocks missing before it with silence
+        int n = chunks * CAPTURE_CHUNK_SAMPLES;
+        if ((int32_t)(cur_seq - next_seq) < 0) next_seq = cur_seq;   // device restarted
+        for (; next_seq != cur_seq && res->samples < want; next_seq++) {
+            int k = write_block(&w, NULL, n, want - res->samples);
+            if (k < 0) break;
+            res->samples += (uint32_t)k;
+            res->missing++;
+        }
+        if (res->samples < want) {
+            int k = write_block(&w, block, n, want - res->samples);
+            if (k < 0) break;
+            res->samples += (uint32_t)k;
+            res->blocks++;
+        }
+        next_seq = cur_seq + 1;
+        in_block = false;
+    }
+
+    set_param("capture", CAPTURE_OFF);
+    if (wav_close(&w) < 0) {
+        perror(path);
+        return 1;
+    }
+
+    printf("%s: %lu samples at %ld Hz, %lu blocks, %lu missing\n", path,
+           (unsigned long)res->samples, (long)rate,
+           (unsigned long)res->blocks, (unsigned long)res->missing);
+    return res->samples == want ? 0 : 1;
+}
+
+/* ---------- Loopback self-check ---------- */
+
+#define CHECK(cond, what) do { \
+        bool ok_ = (cond); \
+        printf("%-40s %s\n", what, ok_ ? "ok" : "FAIL"); \
+        if (!ok_) failed++; \
+    } while (0)
+
+static int loopback(void) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+        perror("posix_openpt");
+        return 1;
+    }
+    link_fd = open_link(ptsname(master));
+    if (link_fd < 0) return 1;
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (pid == 0) {
+        close(link_fd);
+        tlm_dev_sim_run(master, 50);
+        _exit(0);
+    }
+    close(master);
+
+    int failed = 0;
+    int32_t v, got;
+    uint8_t status;
+    const param_info_t *p;
+
+    CHECK(fetch_params() && num_params == PARAM_COUNT, "list parameters");
+    cmd_list();
+
+    p = find_param("mix");
+    v = 8192;
+    CHECK(p && param_request(p, &v, &got, &status) && status == PARAM_OK && got == v,
+          "set mix 0.25");
+    CHECK(p && param_request(p, NULL, &got, &status) && got == v, "get mix");
+
+    p = find_param("bypass");
+    v = 5;
+    CHECK(p && param_request(p, &v, &got, &status) && status == PARAM_CLAMPED && got == 1,
+          "set bypass 5 (clamped)");
+
+    const param_info_t *slot[4] = {
+        find_param("fx1_type"), find_param("fx1_a"), find_param("fx1_b"), find_param("bypass"),
+    };
+    int32_t slot_v[4] = { 1, 2, 2000, 5 }, slot_got[4];
+    uint8_t slot_status[4];
+    CHECK(slot[0] && slot[1] && slot[2] && slot[3] &&
+          param_set_many(slot, slot_v, 4, slot_got, slot_status) &&
+          slot_status[0] == PARAM_OK && slot_status[2] == PARAM_OK && slot_got[2] == 2000 &&
+          slot_status[3] == PARAM_CLAMPED && slot_got[3] == 1 &&
+          param_request(slot[2], NULL, &got, &status) && got == 2000,
+          "set four at once (one clamped)");
+
+    param_info_t bad = { .id = 200, .type = PARAM_INT, .name = "id200" };
+    CHECK(param_request(&bad, NULL, &got, &status) && status == PARAM_BAD_ID, "get unknown id");
+
+    // a GET with a stray value: refused as malformed, not as an unknown id
+    tlm_msg_t req, r;
+    size_t pos = 1;
+    tlm_msg_init(&req, TLM_GET, 0);
+    tlm_put_u8(&req, 0);
+    tlm_put_u32(&req, 0);
+    CHECK(exchange(&req, TLM_PARAM, &r) && tlm_get_u8(&r, &pos) == PARAM_BAD_REQUEST,
+          "get with trailing bytes");
+
+    monitor_result_t res;
+    uint32_t bad_before = dec.bad;
+    monitor(400, true, &res);
+    printf("monitor: %lu frames (%lu..%lu), %lu gaps, %lu stats, %lu profiles, %lu damaged\n",
+           (unsigned long)res.frames, (unsigned long)res.first_frame,
+           (unsigned long)res.last_frame, (unsigned long)res.frame_gaps,
+           (unsigned long)res.stats, (unsigned long)res.profiles,
+           (unsigned long)(dec.bad - bad_before));
+    CHECK(res.frames == 400 && res.stats > 0 && res.profiles > 0,
+          "stream band frames, stats, profiles");
+    CHECK(dec.bad > bad_before && res.frame_gaps > 0 &&
+          res.frames + res.frame_gaps * 2 >= res.last_frame - res.first_frame,
+          "recover from damaged frames");
+
+    bool packed_ok = true;
+    for (int c = 0; c < 4096; c += 2) {
+        int16_t in[2] = { (int16_t)(c - 2048), (int16_t)(2047 - c) }, out[2];
+        uint8_t packed[3];
+        capture_pack(in, 2, packed);
+        capture_unpack(packed, 2, out);
+        packed_ok &= out[0] == in[0] && out[1] == in[1];
+    }
+    CHECK(packed_ok, "12-bit pack / unpack");
+
+    char path[] = "/tmp/tlm_cli_capture_XXXXXX";
+    int tmp = mkstemp(path);
+    capture_result_t cap;
+    if (tmp >= 0) close(tmp);
+    CHECK(tmp >= 0 && capture("adc", 0.5, path, &cap) == 0 &&
+          cap.blocks > 0 && cap.missing > 0, "capture adc with damaged chunks");
+    if (tmp >= 0) unlink(path);
+
+    prof_stat_t ps;
+    uint32_t tick_hz;
+    CHECK(transact(TLM_PROF_GET, PROF_DSP_PROCESS, NULL, &r) &&
+          tlm_unpack_profile(&r, &ps, &tick_hz) == PROF_DSP_PROCESS &&
+          (!PROF_ENABLE || (ps.count > 0 && ps.min <= ps.sum && ps.sum <= ps.max)),
+          "query dsp_process profile");
+    CHECK(transact(TLM_PROF_RESET, 0, NULL, &r) &&
+          transact(TLM_PROF_GET, PROF_CORE1_BLOCK, NULL, &r) &&
+          tlm_unpack_profile(&r, &ps, &tick_hz) == PROF_CORE1_BLOCK &&
+          ps.count < 10 && (!PROF_ENABLE || ps.deadline > 0),
+          "reset profiles");
+    cmd_prof(false);
+
+    close(link_fd);
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+
+    printf("%s\n", failed ? "FAIL" : "OK");
+    return failed ? 1 : 0;
+}
+
+/* ---------- Main ---------- */
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+        "usage: %s [-d tty] monitor [frames] | list | get NAME | set NAME VALUE...\n"
+        "       %s [-d tty] capture adc|audio SECONDS FILE.wav\n"
+        "       %s [-d tty] prof [reset]\n"
+        "       %s -L\n", argv0, argv0, argv0, argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    const char *dev = "/dev/ttyACM0";
+    bool self_check = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:L")) != -1) {
+        switch (opt) {
+            case 'd': dev = optarg; break;
+            case 'L': self_check = true; break;
+            default: usage(argv[0]);
+        }
+    }
+    tlm_decoder_init(&dec);
+
+    if (self_check) return loopback();
+    if (optind >= argc) usage(argv[0]);
+
+    const char *cmd = argv[optind];
+    link_fd = open_link(dev);
+    if (link_fd < 0) return 1;
+
+    if (strcmp(cmd, "monitor") == 0) {
+        monitor_result_t res;
+        monitor(optind + 1 < argc ? atol(argv[optind + 1]) : 0, false, &res);
+        fprintf(stderr, "%lu frames, %lu gaps, %lu damaged\n",
+                (unsigned long)res.frames, (unsigned long)res.frame_gaps,
+                (unsigned long)dec.bad);
+        return 0;
+    }
+
+    if (strcmp(cmd, "prof") == 0)
+        return cmd_prof(optind + 1 < argc && strcmp(argv[optind + 1], "reset") == 0);
+
+    if (!fetch_params()) return 1;
+
+    if (strcmp(cmd, "list") == 0) return cmd_list();
+
+    if (strcmp(cmd, "capture") == 0) {
+        if (optind + 3 >= argc) usage(argv[0]);
+        capture_result_t res;
+        int r = capture(argv[optind + 1], atof(argv[optind + 2]), argv[optind + 3], &res);
+        if (r == 2) usage(argv[0]);
+        return r;
+    }
+
+    if (optind + 1 >= argc) usage(argv[0]);
+    const param_info_t *p = find_param(argv[optind + 1]);
+    if (!p) return 1;
+
+    int32_t v, got;
+    uint8_t status;
+    if (strcmp(cmd, "get") == 0)
+        return param_request(p, NULL, &got, &status) ? 0 : 1;
+
+    if (strcmp(cmd, "set") == 0) {
+        int n = (argc - optind - 1) / 2;
+        if (optind + 2 >= argc || (argc - optind - 1) % 2 || n > TLM_SET_MANY_MAX)
+            usage(argv[0]);
+        if (n == 1) {
+            if (!parse_value(p, argv[optind + 2], &v)) usage(argv[0]);
+            return param_request(p, &v, &got, &status) && status <= PARAM_CLAMPED ? 0 : 1;
+        }
+
+        const param_info_t *ps[TLM_SET_MANY_MAX];
+        int32_t vs[TLM_SET_MANY_MAX], gots[TLM_SET_MANY_MAX];
+        uint8_t statuses[TLM_SET_MANY_MAX];
+        for (int i = 0; i < n; i++) {
+            ps[i] = find_param(argv[optind + 1 + 2 * i]);
+            if (!ps[i]) return 1;
+            if (!parse_value(ps[i], argv[optind + 2 + 2 * i], &vs[i])) usage(argv[0]);
+        }
+        if (!param_set_many(ps, vs, n, gots, statuses)) return 1;
+        for (int i = 0; i < n; i++)
+            if (statuses[i] > PARAM_CLAMPED) return 1;
+        return 0;
+    }
+
+    usage(argv[0]);
+    return 2;
+}
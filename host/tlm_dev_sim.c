@@ -0,0 +1,181 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "tlm_dev_sim.h"
+#include "adc_acq.h"
+#include "capture.h"
+#include "dsp.h"
+#include "dsp_fb.h"
+#include "dsp_fx.h"
+#include "dsp_time.h"
+#include "params.h"
+#include "prof.h"
+#include "spsc.h"
+#include "telemetry.h"
+
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#define FRAME_MS     5
+#define STATS_EVERY  64
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static int link_fd;
+static int corrupt_every;
+static uint32_t frames_written;
+static uint8_t tx_seq;
+static tlm_decoder_t rx;
+
+static int send_msg(const tlm_msg_t *msg) {
+    uint8_t wire[TLM_MAX_WIRE];
+    size_t n = tlm_encode(msg, wire);
+
+    if (corrupt_every && ++frames_written % corrupt_every == 0)
+        wire[n / 2] ^= 0x5A;
+
+    for (size_t off = 0; off < n; ) {
+        ssize_t w = write(link_fd, wire + off, n - off);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        off += (size_t)w;
+    }
+    return 0;
+}
+
+// Send every queued capture block, chunk by chunk
+static int send_capture(void) {
+    const capture_block_t *b;
+    while ((b = capture_acquire())) {
+        for (int c = 0; c < CAPTURE_CHUNKS; c++) {
+            tlm_msg_t m;
+            tlm_msg_init(&m, TLM_CAPTURE, tx_seq++);
+            tlm_put_u32(&m, b->seq);
+            tlm_put_u8(&m, b->source);
+            tlm_put_u8(&m, (uint8_t)c);
+            tlm_put_u8(&m, CAPTURE_CHUNKS);
+            tlm_put_bytes(&m, &b->data[c * CAPTURE_CHUNK_BYTES], CAPTURE_CHUNK_BYTES);
+            if (send_msg(&m) < 0) return -1;
+        }
+        capture_release();
+    }
+    return 0;
+}
+
+// Answer whatever requests have arrived; -1 once the host has gone
+static int handle_rx(int timeout_ms) {
+    struct pollfd p = { .fd = link_fd, .events = POLLIN };
+    if (poll(&p, 1, timeout_ms) <= 0) return 0;
+    if (p.revents & (POLLHUP | POLLERR)) return -1;
+
+    uint8_t buf[256];
+    ssize_t n = read(link_fd, buf, sizeof(buf));
+    if (n <= 0) return n < 0 && errno == EINTR ? 0 : -1;
+
+    tlm_msg_t req, reply;
+    for (ssize_t i = 0; i < n; i++)
+        if (tlm_decode_byte(&rx, buf[i], &req) &&
+            tlm_handle_request(&req, &reply) &&
+            send_msg(&reply) < 0)
+            return -1;
+    return 0;
+}
+
+void tlm_dev_sim_run(int fd, int corrupt) {
+    // planar like audio_path_window(); the right channel is 6 dB down
+    static int16_t block[ADC_CHANNELS * FFT_SIZE], mono[FFT_SIZE], audio_out[FFT_SIZE];
+    uint32_t block_seq = 0;
+    band_frame_t frame = { 0 };
+    uint32_t last_stats = 0;
+    param_snapshot_t params;
+    double phase = 0.0, freq = 0.001;
+
+    link_fd = fd;
+    corrupt_every = corrupt;
+    tlm_decoder_init(&rx);
+    params_init();
+    capture_init();
+    dsp_init();
+    dsp_fb_init();
+    dsp_time_init();
+    params_latch_init(&params);
+
+    prof_clock_init();
+    prof_set_deadline(PROF_CORE1_BLOCK,
+        prof_us_to_ticks((uint32_t)((uint64_t)FFT_SIZE * 1000000u / SAMPLE_RATE_HZ)));
+
+    for (;;) {
+        // a slowly sweeping tone, so the bands move
+        for (int i = 0; i < FFT_SIZE; i++) {
+            for (int c = 0; c < ADC_CHANNELS; c++)
+                block[c * FFT_SIZE + i] = (int16_t)lrint(1500.0 / (1 + c) * sin(phase));
+            phase += 2.0 * M_PI * freq;
+        }
+        adc_mono(block, mono, FFT_SIZE);
+        freq *= 1.01;
+        if (freq > 0.45) freq = 0.001;
+
+        PROF_START(t_block);
+
+        PROF_START(t_dsp);
+        if (param_get(PARAM_ENGINE) == DSP_ENGINE_FILTERBANK) {
+            dsp_fb_process(mono, FFT_SIZE);
+        } else {
+            dsp_set_window((dsp_window_t)param_get(PARAM_WINDOW));
+#if ADC_CHANNELS == 2
+            dsp_process_stereo(block, (dsp_view_t)param_get(PARAM_VIEW));
+#else
+            dsp_process(block);
+#endif
+        }
+        PROF_END(PROF_DSP_PROCESS, t_dsp);
+
+        PROF_START(t_fx);
+        params_latch(&params);
+        dsp_fx_sync_params(&params);
+        dsp_time_process(mono, audio_out, FFT_SIZE,
+                         (int16_t)params.v[PARAM_MIX], params.v[PARAM_BYPASS]);
+        PROF_END(PROF_DSP_TIME, t_fx);
+
+        int32_t cap = param_get(PARAM_CAPTURE);
+        if (cap == CAPTURE_ADC)
+            capture_push(mono, block_seq, CAPTURE_ADC);
+        else if (cap == CAPTURE_AUDIO)
+            capture_push(audio_out, block_seq, CAPTURE_AUDIO);
+        block_seq++;
+        PROF_END(PROF_CORE1_BLOCK, t_block);
+
+        band_exchange_read(&dsp_band_frames, &frame);
+
+        tlm_msg_t m;
+        tlm_msg_init(&m, TLM_BANDS, tx_seq++);
+        tlm_pack_bands(&m, frame.frame, frame.levels, NUM_BANDS);
+        if (send_msg(&m) < 0) return;
+
+        if (send_capture() < 0) return;
+
+        // the same cadence as src/main.c
+        if (frame.frame - last_stats >= STATS_EVERY) {
+            last_stats = frame.frame;
+            tlm_stats_t stats = { .frame = frame.frame, .rx_bad = rx.bad,
+                                  .stft_hop = FFT_SIZE };
+            tlm_msg_init(&m, TLM_STATS, tx_seq++);
+            tlm_pack_stats(&m, &stats);
+            if (send_msg(&m) < 0) return;
+
+            for (int i = 0; i < PROF_STAGE_COUNT; i++) {
+                tlm_msg_init(&m, TLM_PROFILE, tx_seq++);
+                tlm_pack_profile(&m, (uint8_t)i);
+                if (send_msg(&m) < 0) return;
+            }
+        }
+
+        if (handle_rx(FRAME_MS) < 0) return;
+    }
+}
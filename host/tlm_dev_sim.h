@@ -0,0 +1,7 @@
+#pragma once
+
+// Device stand-in for tlm_cli: speaks the telemetry protocol on fd
+// (one end of a pty) with the real params table and dsp_process()
+// output, until the other end closes. Every corrupt_every-th frame
+// written gets one byte flipped (0 = never).
+void tlm_dev_sim_run(int fd, int corrupt_every);
@@ -0,0 +1,177 @@
+#include "wav.h"
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static int write_header(wav_writer_t *w) {
+    uint8_t h[44] = "RIFF....WAVEfmt ";
+    uint32_t data_bytes = w->frames * w->channels * 2u;
+
+    put_u32(h + 4, 36 + data_bytes);
+    put_u32(h + 16, 16);                            // fmt chunk size
+    put_u16(h + 20, 1);                             // PCM
+    put_u16(h + 22, w->channels);
+    put_u32(h + 24, w->rate);
+    put_u32(h + 28, w->rate * w->channels * 2u);    // byte rate
+    put_u16(h + 32, (uint16_t)(w->channels * 2));   // block align
+    put_u16(h + 34, 16);                            // bits per sample
+    h[36] = 'd'; h[37] = 'a'; h[38] = 't'; h[39] = 'a';
+    put_u32(h + 40, data_bytes);
+
+    if (fseek(w->f, 0, SEEK_SET) != 0) return -1;
+    return fwrite(h, sizeof(h), 1, w->f) == 1 ? 0 : -1;
+}
+
+int wav_open_write(wav_writer_t *w, const char *path, uint32_t rate, uint16_t channels) {
+    w->f = fopen(path, "wb");
+    w->rate = rate;
+    w->channels = channels;
+    w->frames = 0;
+    if (!w->f) return -1;
+    return write_header(w);
+}
+
+int wav_write(wav_writer_t *w, const int16_t *samples, size_t frames) {
+    size_t n = frames * w->channels;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t b[2];
+        put_u16(b, (uint16_t)samples[i]);
+        if (fwrite(b, 2, 1, w->f) != 1) return -1;
+    }
+    w->frames += (uint32_t)frames;
+    return 0;
+}
+
+int wav_close(wav_writer_t *w) {
+    int r = write_header(w);
+    if (fclose(w->f) != 0) r = -1;
+    w->f = NULL;
+    return r;
+}
+
+/* ---------- Reader ---------- */
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return get_u16(p) | (uint32_t)get_u16(p + 2) << 16;
+}
+
+int wav_open_read(wav_reader_t *r, const char *path) {
+    uint8_t h[12];
+    bool have_fmt = false;
+
+    r->f = fopen(path, "rb");
+    if (!r->f) return -1;
+    if (fread(h, sizeof(h), 1, r->f) != 1 ||
+        memcmp(h, "RIFF", 4) != 0 || memcmp(h + 8, "WAVE", 4) != 0)
+        goto fail;
+
+    // Walk the chunks up to "data"; fmt must come before it
+    for (;;) {
+        uint8_t c[8];
+        if (fread(c, sizeof(c), 1, r->f) != 1) goto fail;
+        uint32_t size = get_u32(c + 4);
+
+        if (!memcmp(c, "fmt ", 4)) {
+            uint8_t fmt[40] = { 0 };
+            if (size < 16 || size > sizeof(fmt)) goto fail;
+            if (fread(fmt, size, 1, r->f) != 1) goto fail;
+            if (size & 1) fgetc(r->f);
+            r->format   = get_u16(fmt);
+            r->channels = get_u16(fmt + 2);
+            r->rate     = get_u32(fmt + 4);
+            r->bits     = get_u16(fmt + 14);
+            if (r->format == 0xFFFE && size >= 26)  // WAVE_FORMAT_EXTENSIBLE
+                r->format = get_u16(fmt + 24);
+
+            // Only integer PCM and 32-bit float: anything else (ADPCM
+            // has 4 bits per sample) would break the frame size below
+            bool pcm = r->format == 1 &&
+                       (r->bits == 8 || r->bits == 16 || r->bits == 24 || r->bits == 32);
+            bool flt = r->format == 3 && r->bits == 32;
+            if ((!pcm && !flt) || r->channels == 0) {
+                errno = ENOTSUP;
+                goto fail;
+            }
+            have_fmt = true;
+        } else if (!memcmp(c, "data", 4)) {
+            if (!have_fmt) goto fail;
+            r->frames = size / (r->channels * (r->bits / 8u));
+            break;
+        } else if (fseek(r->f, (long)size + (size & 1), SEEK_CUR) != 0) {
+            goto fail;
+        }
+    }
+
+    r->left = r->frames;
+    return 0;
+
+fail:
+    fclose(r->f);
+    r->f = NULL;
+    return -1;
+}
+
+// One sample as a full-scale 32-bit value
+static int32_t sample_s32(const wav_reader_t *r, const uint8_t *p) {
+    switch (r->bits) {
+    case 8:  return (int32_t)((uint32_t)(p[0] ^ 0x80) << 24);  // unsigned
+    case 16: return (int32_t)((uint32_t)get_u16(p) << 16);
+    case 24: return (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 |
+                              (uint32_t)p[2] << 24);
+    }
+    uint32_t u = get_u32(p);
+    if (r->format == 1) return (int32_t)u;
+
+    float x;
+    memcpy(&x, &u, sizeof(x));
+    if (!(x > -1.0f)) return INT32_MIN;             // also NaN
+    if (x >= 1.0f) return INT32_MAX;
+    return (int32_t)(x * 2147483648.0f);
+}
+
+long wav_read_mono(wav_reader_t *r, int16_t *out, size_t frames) {
+    size_t bytes = r->bits / 8u;
+    size_t stride = bytes * r->channels;
+    uint8_t buf[4096];
+    size_t per_read = sizeof(buf) / stride;
+    size_t done = 0;
+
+    if (per_read == 0) return -1;
+    if (frames > r->left) frames = r->left;
+
+    while (done < frames) {
+        size_t n = frames - done;
+        if (n > per_read) n = per_read;
+        if (fread(buf, stride, n, r->f) != n) return -1;
+
+        for (size_t i = 0; i < n; i++) {
+            int64_t acc = 0;
+            for (unsigned c = 0; c < r->channels; c++)
+                acc += sample_s32(r, buf + i * stride + c * bytes);
+            acc /= r->channels;
+            out[done + i] = (int16_t)(acc >> 16);
+        }
+        done += n;
+    }
+    r->left -= (uint32_t)done;
+    return (long)done;
+}
+
+void wav_close_read(wav_reader_t *r) {
+    if (r->f) fclose(r->f);
+    r->f = NULL;
+}
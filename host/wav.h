@@ -0,0 +1,43 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Minimal WAV reader (PCM 8/16/24/32-bit, float32) and 16-bit PCM writer
+
+typedef struct {
+    FILE    *f;
+    uint32_t rate;
+    uint16_t channels;
+    uint16_t format;        // 1 = PCM, 3 = IEEE float
+    uint16_t bits;
+    uint32_t frames;        // in the data chunk
+    uint32_t left;          // frames not read yet
+} wav_reader_t;
+
+// 0 on success, -1 on error or unsupported format (f is closed; errno
+// is ENOTSUP for a format other than 8..32-bit PCM or 32-bit float)
+int wav_open_read(wav_reader_t *r, const char *path);
+
+// Up to frames frames mixed down to mono 16-bit; frames read, 0 at end,
+// -1 on error
+long wav_read_mono(wav_reader_t *r, int16_t *out, size_t frames);
+
+void wav_close_read(wav_reader_t *r);
+
+
+typedef struct {
+    FILE    *f;
+    uint32_t rate;
+    uint16_t channels;
+    uint32_t frames;        // written so far
+} wav_writer_t;
+
+// 0 on success, -1 on error (errno set)
+int wav_open_write(wav_writer_t *w, const char *path, uint32_t rate, uint16_t channels);
+
+// Interleaved samples, frames * channels of them
+int wav_write(wav_writer_t *w, const int16_t *samples, size_t frames);
+
+// Patch the header sizes and close
+int wav_close(wav_writer_t *w);
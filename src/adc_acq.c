@@ -0,0 +1,84 @@
+#include "adc_acq.h"
+#include "spsc.h"
+
+#include <stddef.h>
+
+adc_raw_block_t adc_raw_ring[ADC_RAW_BLOCKS];
+
+static int16_t  blocks[ADC_NUM_BLOCKS][ADC_CHANNELS * AUDIO_BLOCK_SIZE];
+static uint32_t block_seq[ADC_NUM_BLOCKS];
+static block_ring_t ring;
+
+static uint32_t raw_done;          // raw blocks completed so far
+static uint32_t acquired_seq;
+
+void adc_acq_init(void) {
+    block_ring_init(&ring, ADC_NUM_BLOCKS);
+    raw_done = 0;
+    acquired_seq = 0;
+}
+
+void adc_acq_raw_block_done(void) {
+    const uint16_t *raw = adc_raw_ring[raw_done & (ADC_RAW_BLOCKS - 1)];
+    uint32_t slot = block_ring_write_slot(&ring);
+    int16_t *out = blocks[slot];
+
+    // conversions interleave the channels; deinterleave into planes
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+        for (int c = 0; c < ADC_CHANNELS; c++) {
+            const uint16_t *f = &raw[i * ADC_FRAMES_PER_PERIOD + c * ADC_FRAMES_PER_SAMPLE];
+            out[c * AUDIO_BLOCK_SIZE + i] = mcp3202_sample(f[0], f[1]);
+        }
+
+    block_seq[slot] = raw_done++;
+
+    // hand the block to core 1; if it is too far behind the slot is
+    // reused for the next block and the drop is counted
+    block_ring_push(&ring);
+}
+
+uint32_t adc_acq_timer_fraction(uint32_t clk_hz, uint32_t rate_hz,
+                                uint16_t *x, uint16_t *y) {
+    uint64_t best_err = UINT64_MAX;
+    uint32_t best_x = 1, best_y = 0xFFFF;
+
+    if (!rate_hz || rate_hz > clk_hz) rate_hz = clk_hz;
+
+    // rate <= clk means Y >= X, so walk X until Y no longer fits
+    for (uint32_t fx = 1; fx <= 0xFFFF / ADC_CHANNELS; fx++) {
+        uint64_t fy = ((uint64_t)clk_hz * fx + rate_hz / 2) / rate_hz;
+        if (fy > 0xFFFF) break;
+        if (!fy) continue;
+
+        // |clk * x / y - rate| * y, compared across candidates as a rate
+        uint64_t num = (uint64_t)clk_hz * fx;
+        uint64_t got = (num + fy / 2) / fy;
+        uint64_t err = got > rate_hz ? got - rate_hz : rate_hz - got;
+        if (err < best_err) {
+            best_err = err;
+            best_x = fx;
+            best_y = (uint32_t)fy;
+            if (!err) break;
+        }
+    }
+
+    *x = (uint16_t)best_x;
+    *y = (uint16_t)best_y;
+    return (uint32_t)(((uint64_t)clk_hz * best_x + best_y / 2) / best_y);
+}
+
+const int16_t *adc_acquire_block(void) {
+    int slot = block_ring_acquire(&ring);
+    if (slot < 0) return NULL;
+    acquired_seq = block_seq[slot];
+    return blocks[slot];
+}
+
+void adc_release_block(void) {
+    block_ring_release(&ring);
+}
+
+uint32_t adc_pending_blocks(void) { return block_ring_pending(&ring); }
+uint32_t adc_block_seq(void)      { return acquired_seq; }
+uint32_t adc_dropped_blocks(void) { return ring.dropped; }
+uint32_t adc_late_blocks(void)    { return ring.late; }
@@ -0,0 +1,96 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "dsp_config.h"
+
+/*
+ * Hardware-independent half of the ADC acquisition engine.
+ *
+ * The DMA engine streams MCP3202 response frames into a ring of raw
+ * blocks. Each finished raw block is unpacked into a pool of sample
+ * blocks that core 1 acquires and releases (see spsc.h). The SPI/DMA
+ * side lives in adc_mcp3202.c; host/adc_sim.c stands in for it off
+ * target.
+ *
+ * With ADC_CHANNELS 2 the conversions alternate CH0, CH1, so the right
+ * sample of each pair is taken half a sample period after the left.
+ * Sample blocks are planar: AUDIO_BLOCK_SIZE left samples, then
+ * AUDIO_BLOCK_SIZE right.
+ */
+
+// Sample blocks buffered between the DMA ISR and core 1 (power of two)
+#define ADC_NUM_BLOCKS 4
+
+// Raw DMA ring blocks (power of two). Blocks are only AUDIO_BLOCK_SIZE
+// samples, so keep a few for the ISR to fall behind by.
+#define ADC_RAW_BLOCKS 4
+
+/*
+ * One conversion is two back-to-back 9-bit SPI frames (18 clocks,
+ * chip select held low by the SPI block in mode 1,1 and released
+ * between conversions):
+ *   TX 0x1A0 / 0x1E0  start, SGL=1, ODD=0 (CH0) / 1 (CH1), MSBF=1, 0000
+ *   TX 0x000
+ *   RX frame 1 = xxxx0 B11..B8, frame 2 = B7..B0 x
+ */
+#define ADC_FRAMES_PER_SAMPLE  2
+#define ADC_CLOCKS_PER_SAMPLE  18
+#define MCP3202_CMD_CH0        0x1A0
+#define MCP3202_CMD_CH1        0x1E0
+
+// Frames of one sample period, all channels
+#define ADC_FRAMES_PER_PERIOD  (ADC_CHANNELS * ADC_FRAMES_PER_SAMPLE)
+
+typedef uint16_t adc_raw_block_t[AUDIO_BLOCK_SIZE * ADC_FRAMES_PER_PERIOD];
+
+// DMA target ring, filled in order
+extern adc_raw_block_t adc_raw_ring[ADC_RAW_BLOCKS];
+
+// 12-bit unsigned conversion → signed sample centred on 0
+static inline int16_t mcp3202_sample(uint16_t frame1, uint16_t frame2) {
+    return (int16_t)(((frame1 & 0x0F) << 8) | ((frame2 >> 1) & 0xFF)) - 2048;
+}
+
+// Mono of a planar block of n samples per channel: channel 0, or the
+// mid (L + R) / 2 in stereo. out may be planes.
+static inline void adc_mono(const int16_t *planes, int16_t *out, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++)
+#if ADC_CHANNELS == 2
+        out[i] = (int16_t)((planes[i] + planes[n + i]) >> 1);
+#else
+        out[i] = planes[i];
+#endif
+}
+
+void adc_acq_init(void);
+
+// ISR: the next raw block in ring order is complete
+void adc_acq_raw_block_done(void);
+
+/*
+ * Pick the DMA pacing-timer fraction X/Y (both 16-bit) so that
+ * clk_hz * X / Y is as close as possible to rate_hz. X is kept small
+ * enough to be multiplied by ADC_CHANNELS, which paces the ADC at one
+ * conversion per channel on the same clock as the PWM.
+ * Returns the rate actually achieved, in Hz.
+ */
+uint32_t adc_acq_timer_fraction(uint32_t clk_hz, uint32_t rate_hz,
+                                uint16_t *x, uint16_t *y);
+
+// Core 1: oldest complete block of AUDIO_BLOCK_SIZE samples per
+// channel (planar), or NULL if none is ready. The block stays valid
+// until adc_release_block().
+const int16_t *adc_acquire_block(void);
+void adc_release_block(void);
+
+// Complete blocks not yet released (including one being held)
+uint32_t adc_pending_blocks(void);
+
+// Raw block number of the block last returned by adc_acquire_block()
+// (consecutive unless blocks were dropped)
+uint32_t adc_block_seq(void);
+
+// Blocks lost because core 1 fell ADC_NUM_BLOCKS - 1 blocks behind,
+// and blocks core 1 picked up while another was already waiting
+uint32_t adc_dropped_blocks(void);
+uint32_t adc_late_blocks(void);
@@ -1,63 +1,141 @@
 #include "adc_mcp3202.h"
+#include "dsp_config.h"
 #include "hardware/spi.h"
 #include "hardware/dma.h"
 #include "hardware/irq.h"
+#include "hardware/clocks.h"
 #include "pico/stdlib.h"
 
-#define SPI_ADC spi0
-#define PIN_CS  17
-#define FFT_SIZE 256
+#define SPI_ADC      spi0
+#define PIN_CS       17         // spi0 CSn, driven by the SPI block
+#define ADC_SPI_BAUD 2000000
 
-static int16_t buffer_a[FFT_SIZE];
-static int16_t buffer_b[FFT_SIZE];
+#if ADC_CLOCKS_PER_SAMPLE * ADC_CHANNELS * SAMPLE_RATE_HZ > ADC_SPI_BAUD
+#error "SAMPLE_RATE_HZ too high for the MCP3202 SPI clock"
+#endif
 
-volatile int16_t *adc_ready_buffer = NULL;
-static bool use_a = true;
-static int dma_chan;
+// Pace transfers per run: ~13 h at 44.1 kHz stereo, then restarted by
+// the ISR
+#define PACE_COUNT 0xFFFFFFFFu
 
-// dma_handler is the interrupt routing when DMA channel finishes transferring FFT_SIZE samples
+// tx reads these through a read ring of their own size, so they must
+// be aligned to it
+#if ADC_CHANNELS == 2
+#define CMD_RING_BITS 3
+static const uint16_t cmd[ADC_FRAMES_PER_PERIOD]
+    __attribute__((aligned(8))) = { MCP3202_CMD_CH0, 0, MCP3202_CMD_CH1, 0 };
+#else
+#define CMD_RING_BITS 2
+static const uint16_t cmd[ADC_FRAMES_PER_PERIOD]
+    __attribute__((aligned(4))) = { MCP3202_CMD_CH0, 0 };
+#endif
+
+// Written by pace into tx's count-and-trigger register every conversion
+static const uint32_t tx_count = ADC_FRAMES_PER_SAMPLE;
+
+// ctrl reads this ring: entry i is where rx goes after raw block i
+static void *raw_next[ADC_RAW_BLOCKS]
+    __attribute__((aligned(ADC_RAW_BLOCKS * sizeof(void *))));
+
+static int pace_chan, tx_chan, rx_chan, ctrl_chan;
+static int pace_timer;
+
+// Fires when rx finishes a raw block (ctrl has already moved rx on to
+// the next one) and, once in a long while, when pace runs out
 void __isr dma_handler() {
-    // clear the DMA interrupt flag for the channel, so we don't immediately enter ISR again
-    dma_hw->ints0 = 1u << dma_chan;
-    adc_ready_buffer = use_a ? buffer_a : buffer_b;
-    use_a = !use_a;
-
-    dma_channel_set_write_addr(
-        dma_chan,
-        use_a ? buffer_a : buffer_b,
-        true
-    );
+    uint32_t ints = dma_hw->ints0;
+
+    if (ints & (1u << rx_chan)) {
+        dma_hw->ints0 = 1u << rx_chan;
+        adc_acq_raw_block_done();
+    }
+
+    if (ints & (1u << pace_chan)) {
+        dma_hw->ints0 = 1u << pace_chan;
+        dma_channel_set_trans_count(pace_chan, PACE_COUNT, true);
+    }
 }
 
-void adc_init() {
-    spi_init(SPI_ADC, 2000000);
-    spi_set_format(SPI_ADC, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+static void dma_setup(void) {
+    io_rw_32 *spi_dr = &spi_get_hw(SPI_ADC)->dr;
+
+    pace_chan = dma_claim_unused_channel(true);
+    tx_chan   = dma_claim_unused_channel(true);
+    rx_chan   = dma_claim_unused_channel(true);
+    ctrl_chan = dma_claim_unused_channel(true);
+
+    for (int i = 0; i < ADC_RAW_BLOCKS; i++)
+        raw_next[i] = adc_raw_ring[(i + 1) & (ADC_RAW_BLOCKS - 1)];
 
-    gpio_init(PIN_CS);
-    gpio_set_dir(PIN_CS, GPIO_OUT);
-    gpio_put(PIN_CS, 1);
+    // tx: 2 command frames per trigger, read address wraps on the ring,
+    // so stereo triggers alternate CH0 and CH1
+    dma_channel_config c = dma_channel_get_default_config(tx_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_ring(&c, false, CMD_RING_BITS);
+    channel_config_set_dreq(&c, spi_get_dreq(SPI_ADC, true));
+    dma_channel_configure(tx_chan, &c, spi_dr, cmd, ADC_FRAMES_PER_SAMPLE, false);
+
+    // pace: one timer tick → one tx trigger (one conversion)
+    c = dma_channel_get_default_config(pace_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, dma_get_timer_dreq(pace_timer));
+    dma_channel_configure(pace_chan, &c,
+        &dma_hw->ch[tx_chan].al1_transfer_count_trig,
+        &tx_count, PACE_COUNT, false);
 
-    dma_chan = dma_claim_unused_channel(true);
-    dma_channel_config c = dma_channel_get_default_config(dma_chan);
+    // rx: one raw block, then hand over to ctrl
+    c = dma_channel_get_default_config(rx_chan);
     channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
     channel_config_set_read_increment(&c, false);
     channel_config_set_write_increment(&c, true);
     channel_config_set_dreq(&c, spi_get_dreq(SPI_ADC, false));
+    channel_config_set_chain_to(&c, ctrl_chan);
+    dma_channel_configure(rx_chan, &c, adc_raw_ring[0], spi_dr,
+        AUDIO_BLOCK_SIZE * ADC_FRAMES_PER_PERIOD, false);
 
-    dma_channel_configure(
-        dma_chan,
-        &c,
-        buffer_a,
-        &spi_get_hw(SPI_ADC)->dr,
-        FFT_SIZE,
-        false
-    );
+    // ctrl: next raw block address → rx write address, which retriggers rx
+    c = dma_channel_get_default_config(ctrl_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_ring(&c, false, __builtin_ctz(sizeof(raw_next)));
+    dma_channel_configure(ctrl_chan, &c,
+        &dma_hw->ch[rx_chan].al2_write_addr_trig,
+        raw_next, 1, false);
 
-    dma_channel_set_irq0_enabled(dma_chan, true);
+    dma_channel_set_irq0_enabled(rx_chan, true);
+    dma_channel_set_irq0_enabled(pace_chan, true);
     irq_set_exclusive_handler(DMA_IRQ_0, dma_handler);
     irq_set_enabled(DMA_IRQ_0, true);
 }
 
+uint32_t adc_init(uint32_t sample_rate_hz) {
+    // 9-bit frames in mode 1,1 keep CSn low across both frames of a
+    // conversion, so the SPI block can drive chip select itself; it
+    // goes high in the idle gap before the next pace tick
+    spi_init(SPI_ADC, ADC_SPI_BAUD);
+    spi_set_format(SPI_ADC, 9, SPI_CPOL_1, SPI_CPHA_1, SPI_MSB_FIRST);
+    gpio_set_function(PIN_CS, GPIO_FUNC_SPI);
+
+    adc_acq_init();
+
+    uint16_t x, y;
+    pace_timer = dma_claim_unused_timer(true);
+    uint32_t rate = adc_acq_timer_fraction(clock_get_hz(clk_sys),
+                                           sample_rate_hz, &x, &y);
+    // one conversion per channel, locked to the PWM's X/Y
+    dma_timer_set_fraction(pace_timer, (uint16_t)(x * ADC_CHANNELS), y);
+
+    dma_setup();
+    return rate;
+}
+
 void adc_start_dma() {
-    dma_channel_start(dma_chan);
+    // rx waits on the SPI FIFO; the pace timer starts the conversions
+    dma_channel_start(rx_chan);
+    dma_channel_start(pace_chan);
 }
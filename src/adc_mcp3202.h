@@ -1,7 +1,18 @@
 #pragma once
 #include <stdint.h>
+#include "adc_acq.h"
 
-void adc_init(void);
-void adc_start_dma(void);
+/*
+ * MCP3202 on spi0, sampled continuously by DMA:
+ *   pace  DMA timer at ADC_CHANNELS × the sample rate retriggers tx
+ *         once per conversion
+ *   tx    writes the two command frames of a conversion to the SPI FIFO
+ *   rx    SPI FIFO → raw block ring, chains to ctrl at the end of a block
+ *   ctrl  points rx at the next raw block and retriggers it
+ * No CPU work per sample; one IRQ per AUDIO_BLOCK_SIZE samples (see
+ * adc_acq.h).
+ */
 
-extern volatile int16_t *adc_ready_buffer;
+// Returns the sample rate actually achieved by the pacing timer
+uint32_t adc_init(uint32_t sample_rate_hz);
+void adc_start_dma(void);
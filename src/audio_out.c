@@ -0,0 +1,78 @@
+#include "audio_out.h"
+#include "spsc.h"
+
+#include <stddef.h>
+
+static audio_out_block_t ring[AUDIO_OUT_BLOCKS];
+static audio_out_block_t silence;
+
+/*
+ * Block n lives in ring[n % AUDIO_OUT_BLOCKS].
+ *   head    blocks committed (producer)
+ *   loaded  blocks handed to a DMA channel (ISR)
+ *   tail    blocks finished playing, buffer free again (ISR)
+ * tail <= loaded <= head <= tail + AUDIO_OUT_BLOCKS
+ */
+static volatile uint32_t head, loaded, tail;
+static volatile uint32_t underruns, overruns;
+
+// Per in-flight DMA load, oldest first: was it a ring block (true) or
+// silence? Decides whether its buffer goes back when it finishes.
+static bool in_flight[AUDIO_OUT_IN_FLIGHT];
+static uint32_t in_flight_pos;
+
+void audio_out_init(uint16_t idle_level) {
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+        silence[i] = idle_level;
+    head = loaded = tail = 0;
+    underruns = overruns = 0;
+    for (int i = 0; i < AUDIO_OUT_IN_FLIGHT; i++)
+        in_flight[i] = false;
+    in_flight_pos = 0;
+}
+
+uint16_t *audio_out_write_block(void) {
+    if (head - tail >= AUDIO_OUT_BLOCKS) {
+        overruns++;
+        return NULL;
+    }
+    return ring[head & (AUDIO_OUT_BLOCKS - 1)];
+}
+
+void audio_out_commit(void) {
+    spsc_barrier();                 // block data before the index
+    head = head + 1;
+}
+
+uint32_t audio_out_fill(void) {
+    return head - loaded;
+}
+
+uint32_t audio_out_free(void) {
+    return AUDIO_OUT_BLOCKS - (head - tail);
+}
+
+const uint16_t *audio_out_next_block(void) {
+    // The channel asking has finished the oldest in-flight block
+    bool *slot = &in_flight[in_flight_pos];
+    in_flight_pos = (in_flight_pos + 1) % AUDIO_OUT_IN_FLIGHT;
+    if (*slot) {
+        spsc_barrier();             // DMA done reading before handing back
+        tail = tail + 1;
+    }
+
+    uint32_t n = loaded;
+    if (n == head) {
+        if (head) underruns++;
+        *slot = false;
+        return silence;
+    }
+    spsc_barrier();                 // index before the block data
+    loaded = n + 1;
+    *slot = true;
+    return ring[n & (AUDIO_OUT_BLOCKS - 1)];
+}
+
+const uint16_t *audio_out_silence(void) { return silence; }
+uint32_t audio_out_underruns(void)      { return underruns; }
+uint32_t audio_out_overruns(void)       { return overruns; }
@@ -0,0 +1,49 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "dsp_config.h"
+
+/*
+ * Hardware-independent half of the audio output engine.
+ *
+ * The audio path (audio_path.c) fills blocks of PWM levels into a
+ * ring; the output DMA plays them back to back on two chained
+ * channels, so one block is always playing while the next one is
+ * already loaded. Each time a channel finishes, its ISR takes the next
+ * queued block for it, or a block of silence (counted as an underrun)
+ * if none has been delivered. The DMA/PWM side lives in
+ * audio_out_pwm.c.
+ */
+
+// Blocks in the ring (power of two): two in flight on the DMA
+// channels, the rest queued
+#define AUDIO_OUT_BLOCKS     4
+#define AUDIO_OUT_IN_FLIGHT  2
+
+typedef uint16_t audio_out_block_t[AUDIO_BLOCK_SIZE];
+
+// Silence block at idle_level (the PWM midpoint)
+void audio_out_init(uint16_t idle_level);
+
+// Producer: block to fill next, or NULL if the ring is full (the block
+// is then dropped and counted as an overrun)
+uint16_t *audio_out_write_block(void);
+
+// Producer: the block from audio_out_write_block() is ready to play
+void audio_out_commit(void);
+
+// Producer: blocks committed and not yet loaded into a DMA channel, and
+// blocks that can be written without overrunning
+uint32_t audio_out_fill(void);
+uint32_t audio_out_free(void);
+
+// DMA ISR: a channel finished its block; returns the next block for it
+const uint16_t *audio_out_next_block(void);
+
+// Silence block, loaded into both channels before the first commit
+const uint16_t *audio_out_silence(void);
+
+// Blocks of silence played because the ring ran dry (not counted
+// before the first commit), and blocks dropped because it was full
+uint32_t audio_out_underruns(void);
+uint32_t audio_out_overruns(void);
@@ -1,42 +1,100 @@
 #include "audio_out_pwm.h"
+#include "audio_out.h"
+#include "audio_path.h"
+#include "audio_quant.h"
+#include "adc_acq.h"
+#include "dsp_config.h"
 #include "hardware/pwm.h"
 #include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
 
-#define FFT_SIZE 256
-#define PWM_WRAP 499
+// Compare levels 0..AUDIO_PWM_WRAP; the carrier is clk_sys /
+// (AUDIO_PWM_WRAP + 1), divided down to AUDIO_PWM_CARRIER_HZ if set.
+// Fewer levels buy a faster carrier, and noise shaping makes up for
+// part of the lost resolution.
+#ifndef AUDIO_PWM_WRAP
+#define AUDIO_PWM_WRAP 1023
+#endif
+#ifndef AUDIO_PWM_CARRIER_HZ
+#define AUDIO_PWM_CARRIER_HZ 0
+#endif
+
+#if AUDIO_PWM_WRAP < 1 || AUDIO_PWM_WRAP > AUDIO_QUANT_MAX_WRAP
+#error "AUDIO_PWM_WRAP out of range"
+#endif
+#if AUDIO_PWM_CARRIER_HZ && AUDIO_PWM_CARRIER_HZ < 2 * SAMPLE_RATE_HZ
+#error "AUDIO_PWM_CARRIER_HZ must be at least twice the sample rate"
+#endif
 
 static uint slice;
-static int dma_chan;
-static uint16_t pwm_buf[FFT_SIZE];
+static int chan[2];
+static int pace_timer;
+
+// A channel finished its block and has already chained to the other
+// one: process the newest input block and load it into this channel
+// to play after that (no trigger: the other channel's chain starts it),
+// then wake the core-1 main loop for the new samples (sched.h)
+static void __isr audio_dma_handler(void) {
+    uint32_t ints = dma_hw->ints1;
+
+    for (int i = 0; i < 2; i++) {
+        if (ints & (1u << chan[i])) {
+            dma_hw->ints1 = 1u << chan[i];
+            audio_path_step();
+            dma_channel_set_read_addr(chan[i], audio_out_next_block(), false);
+        }
+    }
+    __sev();
+}
 
-void audio_pwm_init(uint gpio) {
+void audio_pwm_init(uint gpio, uint32_t sample_rate_hz) {
     gpio_set_function(gpio, GPIO_FUNC_PWM);
     slice = pwm_gpio_to_slice_num(gpio);
-    pwm_set_wrap(slice, PWM_WRAP);
+    pwm_set_wrap(slice, AUDIO_PWM_WRAP);
+#if AUDIO_PWM_CARRIER_HZ
+    // 8.4 fractional divider, 1..255.9375
+    uint32_t div16 = (uint32_t)(((uint64_t)clock_get_hz(clk_sys) * 16) /
+                                ((uint64_t)AUDIO_PWM_CARRIER_HZ * (AUDIO_PWM_WRAP + 1)));
+    if (div16 < 16) div16 = 16;
+    if (div16 > 0xFFF) div16 = 0xFFF;
+    pwm_set_clkdiv_int_frac(slice, (uint8_t)(div16 >> 4), (uint8_t)(div16 & 15));
+#endif
     pwm_set_enabled(slice, true);
 
-    dma_chan = dma_claim_unused_channel(true);
-    dma_channel_config c = dma_channel_get_default_config(dma_chan);
-    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
-    channel_config_set_read_increment(&c, true);
-    channel_config_set_write_increment(&c, false);
-    channel_config_set_dreq(&c, DREQ_PWM_WRAP0 + slice);
-
-    dma_channel_configure(
-        dma_chan, &c,
-        &pwm_hw->slice[slice].cc,
-        pwm_buf,
-        FFT_SIZE,
-        false
-    );
-}
+    audio_path_init(AUDIO_PWM_WRAP);
+    audio_out_init((AUDIO_PWM_WRAP + 1) / 2);
+
+    uint16_t x, y;
+    pace_timer = dma_claim_unused_timer(true);
+    adc_acq_timer_fraction(clock_get_hz(clk_sys), sample_rate_hz, &x, &y);
+    dma_timer_set_fraction(pace_timer, x, y);
+
+    chan[0] = dma_claim_unused_channel(true);
+    chan[1] = dma_claim_unused_channel(true);
 
-void audio_pwm_play(const int16_t *s) {
-    for (int i = 0; i < FFT_SIZE; i++) {
-        int v = s[i] + 2048;
-        if (v < 0) v = 0;
-        if (v > PWM_WRAP) v = PWM_WRAP;
-        pwm_buf[i] = v;
+    // Ping-pong: each channel plays one block into the PWM compare
+    // register, one sample per timer tick, then chains to the other
+    for (int i = 0; i < 2; i++) {
+        dma_channel_config c = dma_channel_get_default_config(chan[i]);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_dreq(&c, dma_get_timer_dreq(pace_timer));
+        channel_config_set_chain_to(&c, chan[i ^ 1]);
+        dma_channel_configure(chan[i], &c,
+            &pwm_hw->slice[slice].cc,
+            audio_out_silence(),
+            AUDIO_BLOCK_SIZE,
+            false);
     }
-    dma_channel_set_read_addr(dma_chan, pwm_buf, true);
+
+    // This core takes the refills
+    dma_channel_set_irq1_enabled(chan[0], true);
+    dma_channel_set_irq1_enabled(chan[1], true);
+    irq_set_exclusive_handler(DMA_IRQ_1, audio_dma_handler);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    dma_channel_start(chan[0]);
 }
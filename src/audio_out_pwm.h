@@ -1,6 +1,11 @@
 #pragma once
 #include <stdint.h>
+#include <stdbool.h>
 #include "pico/stdlib.h"
 
-void audio_pwm_init(uint gpio);
-void audio_pwm_play(const int16_t *samples);
+// PWM audio on gpio, one sample per tick of a DMA pacing timer at
+// sample_rate_hz (the ADC runs ADC_CHANNELS times the same fraction, so
+// the two stay locked).
+// Each finished output block runs audio_path_step() from the DMA
+// interrupt of the calling core.
+void audio_pwm_init(uint gpio, uint32_t sample_rate_hz);
@@ -0,0 +1,130 @@
+#include "audio_path.h"
+#include "adc_acq.h"
+#include "audio_out.h"
+#include "audio_quant.h"
+#include "dsp_fx.h"
+#include "dsp_time.h"
+#include "params.h"
+#include "prof.h"
+#include "spsc.h"
+
+#include <stddef.h>
+
+static audio_quant_t quant;
+
+static int16_t in_hist[ADC_CHANNELS][AUDIO_HISTORY];
+static int16_t out_hist[AUDIO_HISTORY];
+static sample_ring_t in_ring[ADC_CHANNELS], out_ring;
+
+static volatile uint32_t skipped;
+
+// Parameters as of this block
+static param_snapshot_t params;
+
+void audio_path_init(uint16_t pwm_wrap) {
+    audio_quant_init(&quant, pwm_wrap, true);
+    for (int c = 0; c < ADC_CHANNELS; c++)
+        sample_ring_init(&in_ring[c], in_hist[c], AUDIO_HISTORY);
+    sample_ring_init(&out_ring, out_hist, AUDIO_HISTORY);
+    params_latch_init(&params);
+    skipped = 0;
+}
+
+void audio_reader_init(audio_reader_t *r) {
+    r->next_end = FFT_SIZE;
+    r->next_seq = 0;
+    r->dropped = 0;
+}
+
+bool audio_path_step(void) {
+    static int16_t fx[AUDIO_BLOCK_SIZE];
+#if ADC_CHANNELS == 2
+    static int16_t mid[AUDIO_BLOCK_SIZE];
+#endif
+
+    const int16_t *in = adc_acquire_block();
+    if (!in) return false;
+
+    PROF_START(t_block);
+
+    // Parameter changes land between blocks, all at once; the effect
+    // ramps to them. If a write is in progress, the last values stay.
+    params_latch(&params);
+    dsp_fx_sync_params(&params);
+
+    // Play only the newest block. Older ones still go through the
+    // effect (so its state stays continuous) and into the history.
+    for (;;) {
+        bool newest = adc_pending_blocks() == 1;
+
+        PROF_START(t_fx);
+#if ADC_CHANNELS == 2
+        adc_mono(in, mid, AUDIO_BLOCK_SIZE);
+        const int16_t *fx_in = mid;
+#else
+        const int16_t *fx_in = in;
+#endif
+        dsp_time_process(fx_in, fx, AUDIO_BLOCK_SIZE,
+                         (int16_t)params.v[PARAM_MIX], params.v[PARAM_BYPASS]);
+        PROF_END(PROF_DSP_TIME, t_fx);
+
+        if (newest) {
+            PROF_START(t_play);
+            uint16_t *out = audio_out_write_block();
+            if (out) {
+                audio_quant_block(&quant, fx, out, AUDIO_BLOCK_SIZE);
+                audio_out_commit();
+            }
+            PROF_END(PROF_AUDIO_PLAY, t_play);
+        } else {
+            skipped++;
+        }
+
+        for (int c = 0; c < ADC_CHANNELS; c++)
+            sample_ring_write(&in_ring[c], in + c * AUDIO_BLOCK_SIZE, AUDIO_BLOCK_SIZE);
+        sample_ring_write(&out_ring, fx, AUDIO_BLOCK_SIZE);
+        adc_release_block();
+
+        if (newest) break;
+        in = adc_acquire_block();
+    }
+
+    PROF_END(PROF_AUDIO_BLOCK, t_block);
+    return true;
+}
+
+// Next len samples ending at the reader's position, then move on hop
+static bool take(audio_reader_t *r, uint32_t hop, uint32_t len,
+                 int16_t *in, int16_t *out, uint32_t *seq) {
+    uint32_t behind = out_ring.written - r->next_end;
+    if ((int32_t)behind < 0) return false;
+
+    // fell too far behind: skip to the newest complete span
+    if (behind > AUDIO_HISTORY - len) {
+        uint32_t n = behind / hop;
+        r->next_end += n * hop;
+        r->next_seq += n;
+        r->dropped += n;
+    }
+
+    // the output history is written last, so both are complete here
+    uint32_t end = r->next_end;
+    *seq = r->next_seq++;
+    r->next_end += hop;
+    bool ok = !out || sample_ring_read(&out_ring, end, out, len);
+    for (int c = 0; in && ok && c < ADC_CHANNELS; c++)
+        ok = sample_ring_read(&in_ring[c], end, in + c * len, len);
+    if (!ok) r->dropped++;
+    return ok;
+}
+
+bool audio_path_window(audio_reader_t *r, uint32_t hop,
+                       int16_t *in, int16_t *out, uint32_t *seq) {
+    return take(r, hop, FFT_SIZE, in, out, seq);
+}
+
+bool audio_path_read(audio_reader_t *r, int16_t *in, uint32_t n, uint32_t *seq) {
+    return take(r, n, n, in, NULL, seq);
+}
+
+uint32_t audio_path_skipped(void) { return skipped; }
@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "dsp_config.h"
+
+/*
+ * Low-latency monitoring path and the analysis stream it feeds.
+ *
+ * audio_path_step() runs once per AUDIO_BLOCK_SIZE block from the
+ * output DMA interrupt on core 1: the newest ADC block goes through
+ * dsp_time_process and the requantizer straight into the output ring,
+ * so the signal is back out within about three audio blocks however
+ * long the FFT takes. The input and effect output also go into sample
+ * histories, from which readers on the core-1 main loop cut FFT_SIZE
+ * windows at their own pace and hop: overlapping ones for the STFT,
+ * back-to-back ones for capture.
+ *
+ * In stereo the effect and the PWM output get the mid (L + R) / 2;
+ * both input channels are kept for the analysis.
+ */
+
+// Samples of history kept for the analysis (power of two). A reader
+// may fall this much less one window behind before windows are
+// dropped.
+#define AUDIO_HISTORY (2 * FFT_SIZE)
+
+// One consumer of the history. Readers are independent; each belongs
+// to a single core-1 main loop caller.
+typedef struct {
+    uint32_t next_end;      // stream position just past the next window
+    uint32_t next_seq;
+    uint32_t dropped;       // windows lost by falling too far behind
+} audio_reader_t;
+
+// Output levels 0..pwm_wrap (see audio_quant.h)
+void audio_path_init(uint16_t pwm_wrap);
+
+// Output ISR: process the newest ADC block into the output ring. Older
+// blocks still waiting are not played (and are counted), so a hiccup
+// never leaves extra latency behind; they still reach the analysis.
+// Returns false if no block was ready.
+bool audio_path_step(void);
+
+// First window ends FFT_SIZE samples into the stream
+void audio_reader_init(audio_reader_t *r);
+
+// Core 1 main loop: the reader's next window, FFT_SIZE samples of input
+// and effect output (either may be NULL), starting hop (1..FFT_SIZE)
+// samples after the previous one. Returns false until it is complete.
+// *seq numbers windows; it jumps if windows were dropped. The hop may
+// change from one call to the next. in takes ADC_CHANNELS planes of
+// FFT_SIZE samples, left first (see adc_mono()).
+bool audio_path_window(audio_reader_t *r, uint32_t hop,
+                       int16_t *in, int16_t *out, uint32_t *seq);
+
+// As audio_path_window, for n (1..FFT_SIZE) input samples per channel
+// (planes of n) straight after the last ones this reader returned: a
+// gapless stream, unless the reader fell behind (then *seq jumps).
+bool audio_path_read(audio_reader_t *r, int16_t *in, uint32_t n, uint32_t *seq);
+
+// ADC blocks not played to catch up
+uint32_t audio_path_skipped(void);
@@ -0,0 +1,37 @@
+#include "audio_quant.h"
+
+void audio_quant_init(audio_quant_t *q, uint16_t wrap, bool shape) {
+    if (wrap > AUDIO_QUANT_MAX_WRAP) wrap = AUDIO_QUANT_MAX_WRAP;
+    q->wrap = wrap;
+    q->gain = ((int32_t)wrap + 1) << 4;     // (wrap + 1) / 4096 in Q16
+    q->err = 0;
+    q->shape = shape;
+}
+
+void audio_quant_block(audio_quant_t *q, const int16_t *in, uint16_t *out, int n) {
+    const int32_t top = q->wrap;
+    int32_t err = q->err;
+
+    for (int i = 0; i < n; i++) {
+        int32_t s = in[i];
+        if (s < -2048) s = -2048;
+        if (s > 2047) s = 2047;
+
+        // Offset binary → PWM levels (Q16), less the previous error
+        int32_t v = (s + 2048) * q->gain - err;
+
+        int32_t level = (v + 0x8000) >> 16;
+        if (level < 0) level = 0;
+        if (level > top) level = top;
+        out[i] = (uint16_t)level;
+
+        if (q->shape) {
+            // Clipped samples would feed back more than one level of
+            // error and ring; hold it to one level
+            err = (level << 16) - v;
+            if (err > 0x10000) err = 0x10000;
+            if (err < -0x10000) err = -0x10000;
+        }
+    }
+    q->err = err;
+}
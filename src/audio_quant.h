@@ -0,0 +1,27 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 12-bit signed samples → PWM compare levels 0..wrap.
+ *
+ * Full scale maps onto the whole PWM range. With wrap + 1 < 4096 that
+ * drops input bits; the requantization error is fed back into the next
+ * sample (first-order error feedback, noise transfer 1 - z^-1), which
+ * keeps the average level exact and pushes the lost resolution up
+ * towards fs/2, where the output RC filter takes it out.
+ */
+
+// Largest supported wrap: one PWM level per input step
+#define AUDIO_QUANT_MAX_WRAP 4095
+
+typedef struct {
+    int32_t  gain;      // PWM levels per input step, Q16
+    int32_t  err;       // last requantization error, Q16 levels
+    uint16_t wrap;
+    bool     shape;     // error feedback on (off: plain rounding)
+} audio_quant_t;
+
+void audio_quant_init(audio_quant_t *q, uint16_t wrap, bool shape);
+
+void audio_quant_block(audio_quant_t *q, const int16_t *in, uint16_t *out, int n);
@@ -0,0 +1,53 @@
+#include "capture.h"
+
+#include <stddef.h>
+
+static capture_block_t blocks[CAPTURE_BLOCKS];
+static block_ring_t ring;
+
+static inline uint32_t code12(int16_t s) {
+    if (s > 2047) s = 2047;
+    if (s < -2048) s = -2048;
+    return (uint32_t)(s + 2048);
+}
+
+void capture_pack(const int16_t *samples, int count, uint8_t *out) {
+    for (int i = 0; i < count; i += 2) {
+        uint32_t a = code12(samples[i]);
+        uint32_t b = code12(samples[i + 1]);
+        *out++ = (uint8_t)a;
+        *out++ = (uint8_t)((a >> 8) | (b << 4));
+        *out++ = (uint8_t)(b >> 4);
+    }
+}
+
+void capture_unpack(const uint8_t *in, int count, int16_t *samples) {
+    for (int i = 0; i < count; i += 2, in += 3) {
+        samples[i]     = (int16_t)((in[0] | ((in[1] & 0x0F) << 8)) - 2048);
+        samples[i + 1] = (int16_t)(((in[1] >> 4) | (in[2] << 4)) - 2048);
+    }
+}
+
+void capture_init(void) {
+    block_ring_init(&ring, CAPTURE_BLOCKS);
+}
+
+bool capture_push(const int16_t *samples, uint32_t seq, capture_source_t source) {
+    capture_block_t *b = &blocks[block_ring_write_slot(&ring)];
+
+    b->seq = seq;
+    b->source = (uint8_t)source;
+    capture_pack(samples, FFT_SIZE, b->data);
+    return block_ring_push(&ring);
+}
+
+const capture_block_t *capture_acquire(void) {
+    int slot = block_ring_acquire(&ring);
+    return slot < 0 ? NULL : &blocks[slot];
+}
+
+void capture_release(void) {
+    block_ring_release(&ring);
+}
+
+uint32_t capture_dropped(void) { return ring.dropped; }
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "dsp_config.h"
+#include "spsc.h"
+
+/*
+ * Raw sample capture: core 1 packs a copy of each analysis window (ADC
+ * input or effect output) straight into a ring slot, core 0 streams the
+ * slots out as TLM_CAPTURE messages. Core 1 never waits; if core 0 (or
+ * the USB link) falls behind, blocks are dropped and show up as gaps in
+ * the block sequence numbers.
+ *
+ * Samples are 12-bit offset binary, two to three bytes:
+ *   b0 = a[7:0]   b1 = b[3:0] a[11:8]   b2 = b[11:4]
+ */
+
+typedef enum {
+    CAPTURE_OFF,
+    CAPTURE_ADC,        // samples as acquired
+    CAPTURE_AUDIO,      // effect output sent to the PWM
+} capture_source_t;
+
+// Blocks buffered between core 1 and the USB link (power of two)
+#define CAPTURE_BLOCKS          8
+
+#define CAPTURE_PACKED_SIZE(n)  ((n) * 3 / 2)
+#define CAPTURE_BLOCK_BYTES     CAPTURE_PACKED_SIZE(FFT_SIZE)
+
+// Samples per TLM_CAPTURE message (FFT_SIZE is a multiple of this)
+#define CAPTURE_CHUNK_SAMPLES   128
+#define CAPTURE_CHUNK_BYTES     CAPTURE_PACKED_SIZE(CAPTURE_CHUNK_SAMPLES)
+#define CAPTURE_CHUNKS          (FFT_SIZE / CAPTURE_CHUNK_SAMPLES)
+
+typedef struct {
+    uint32_t seq;                       // analysis window number
+    uint8_t  source;                    // capture_source_t
+    uint8_t  data[CAPTURE_BLOCK_BYTES];
+} capture_block_t;
+
+// Pack / unpack count (even) signed 12-bit samples, clamped to range
+void capture_pack(const int16_t *samples, int count, uint8_t *out);
+void capture_unpack(const uint8_t *in, int count, int16_t *samples);
+
+void capture_init(void);
+
+// Core 1: copy one FFT_SIZE-sample block into the ring. Returns false
+// if the ring was full and the block was dropped.
+bool capture_push(const int16_t *samples, uint32_t seq, capture_source_t source);
+
+// Core 0: oldest queued block, or NULL; valid until capture_release()
+const capture_block_t *capture_acquire(void);
+void capture_release(void);
+
+uint32_t capture_dropped(void);
@@ -1,17 +1,145 @@
 #include "debug_usb.h"
-#include <stdio.h>
-#include <stdbool.h>
+#include "dsp_config.h"
+#include "capture.h"
+#include "tusb.h"
 
-void debug_print_bands(const float *b) {
-    printf("B:");
-    for (int i = 0; i < 16; i++) printf(" %.2f", b[i]);
-    printf("\n");
+#include <string.h>
+
+// Power of two; holds ~8 blocks of capture or ~90 band frames
+#define TX_RING_SIZE 4096
+
+static uint8_t  tx_ring[TX_RING_SIZE];
+static uint32_t tx_head, tx_tail;   // free-running, core 0 only
+static uint32_t tx_dropped;
+static uint8_t  tx_seq;          // unsolicited messages; replies echo the request
+
+static tlm_decoder_t rx;
+
+// Capture block being streamed, and its next chunk
+static const capture_block_t *cap_block;
+static int cap_chunk;
+
+void debug_init(void) {
+    tx_head = tx_tail = 0;
+    tlm_decoder_init(&rx);
+}
+
+bool debug_send(const tlm_msg_t *msg) {
+    uint8_t wire[TLM_MAX_WIRE];
+    size_t n = tlm_encode(msg, wire);
+    if (TX_RING_SIZE - (tx_head - tx_tail) < n) {
+        tx_dropped++;
+        return false;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        tx_ring[(tx_head + i) & (TX_RING_SIZE - 1)] = wire[i];
+    tx_head += n;
+    return true;
+}
+
+void debug_send_bands(uint32_t frame, const int16_t *bands) {
+    tlm_msg_t m;
+    tlm_msg_init(&m, TLM_BANDS, tx_seq++);
+    tlm_pack_bands(&m, frame, bands, NUM_BANDS);
+    debug_send(&m);
 }
 
-void debug_handle_cmd(int c, float *mix, bool *bypass) {
-    if (c == '+') *mix += 0.05f;
-    if (c == '-') *mix -= 0.05f;
-    if (c == 'b') *bypass = !*bypass;
-    if (*mix < 0) *mix = 0;
-    if (*mix > 1) *mix = 1;
+void debug_send_stats(tlm_stats_t *stats) {
+    tlm_msg_t m;
+    stats->tx_dropped = tx_dropped;
+    stats->rx_bad = rx.bad;
+    stats->cap_dropped = capture_dropped();
+    tlm_msg_init(&m, TLM_STATS, tx_seq++);
+    tlm_pack_stats(&m, stats);
+    debug_send(&m);
 }
+
+void debug_send_profiles(void) {
+    for (int i = 0; i < PROF_STAGE_COUNT; i++) {
+        tlm_msg_t m;
+        tlm_msg_init(&m, TLM_PROFILE, tx_seq++);
+        tlm_pack_profile(&m, (uint8_t)i);
+        debug_send(&m);
+    }
+}
+
+// Stream queued capture blocks a chunk at a time while the TX ring has
+// room; the packed samples go from the capture slot into the frame
+static void capture_drain(void) {
+    for (;;) {
+        if (!cap_block) {
+            cap_block = capture_acquire();
+            cap_chunk = 0;
+            if (!cap_block) return;
+        }
+        if (TX_RING_SIZE - (tx_head - tx_tail) < TLM_MAX_WIRE) return;
+
+        tlm_msg_t m;
+        tlm_msg_init(&m, TLM_CAPTURE, tx_seq++);
+        tlm_put_u32(&m, cap_block->seq);
+        tlm_put_u8(&m, cap_block->source);
+        tlm_put_u8(&m, (uint8_t)cap_chunk);
+        tlm_put_u8(&m, CAPTURE_CHUNKS);
+        tlm_put_bytes(&m, &cap_block->data[cap_chunk * CAPTURE_CHUNK_BYTES],
+                      CAPTURE_CHUNK_BYTES);
+        debug_send(&m);
+
+        if (++cap_chunk == CAPTURE_CHUNKS) {
+            capture_release();
+            cap_block = NULL;
+        }
+    }
+}
+
+/*
+ * The CDC calls below go straight to TinyUSB, whose FIFOs have no
+ * locking (no RTOS). pico_stdio_usb is built without its background
+ * IRQ task (CMakeLists.txt), so tud_task() runs only from debug_poll()
+ * and every TinyUSB call is on core 0 in thread context. Nothing
+ * prints, so stdio_usb does not call in either.
+ */
+static void tx_drain(void) {
+    if (!tud_cdc_connected()) {
+        // nobody listening: don't let stale frames pile up
+        tx_tail = tx_head;
+        return;
+    }
+
+    while (tx_head != tx_tail) {
+        uint32_t avail = tud_cdc_write_available();
+        if (!avail) break;
+
+        uint32_t off = tx_tail & (TX_RING_SIZE - 1);
+        uint32_t n = tx_head - tx_tail;
+        if (n > TX_RING_SIZE - off) n = TX_RING_SIZE - off;   // up to the wrap
+        if (n > avail) n = avail;
+
+        tx_tail += tud_cdc_write(&tx_ring[off], n);
+    }
+    tud_cdc_write_flush();
+}
+
+static void rx_poll(void) {
+    uint8_t buf[64];
+    tlm_msg_t req, reply;
+
+    while (tud_cdc_available()) {
+        uint32_t n = tud_cdc_read(buf, sizeof(buf));
+        for (uint32_t i = 0; i < n; i++) {
+            if (!tlm_decode_byte(&rx, buf[i], &req)) continue;
+            if (tlm_handle_request(&req, &reply))
+                debug_send(&reply);
+        }
+    }
+}
+
+void debug_poll(void) {
+    tud_task();
+    rx_poll();
+    capture_drain();
+    tx_drain();
+}
+
+uint32_t debug_tx_dropped(void) { return tx_dropped; }
+uint32_t debug_rx_bad(void)     { return rx.bad; }
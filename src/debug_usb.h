@@ -1,5 +1,31 @@
 #pragma once
 #include <stdbool.h>
+#include <stdint.h>
+#include "telemetry.h"
 
-void debug_print_bands(const float *bands);
-void debug_handle_cmd(int c, float *mix, bool *bypass);
+/*
+ * USB CDC telemetry and control (protocol in telemetry.h). Everything
+ * here is non-blocking: messages are framed into a TX ring and drained
+ * to the CDC endpoint from debug_poll(); a message that does not fit is
+ * dropped and counted.
+ */
+
+void debug_init(void);
+
+// Queue one message as is; false if the TX ring is full (dropped)
+bool debug_send(const tlm_msg_t *msg);
+
+// Band levels (dBFS, Q8) of one published frame
+void debug_send_bands(uint32_t frame, const int16_t *bands);
+void debug_send_stats(tlm_stats_t *stats);
+// Profile of every stage (see prof.h)
+void debug_send_profiles(void);
+
+// Run the TinyUSB device task, answer any received requests
+// (telemetry.h), frame queued capture blocks and drain the TX ring.
+// Call from the core 0 loop, often enough to keep the USB serviced.
+void debug_poll(void);
+
+// Telemetry frames dropped on TX, and damaged frames received
+uint32_t debug_tx_dropped(void);
+uint32_t debug_rx_bad(void);
@@ -3,18 +3,23 @@
 #include "hardware/i2c.h"
 #include "pico/stdlib.h"
 #include <string.h>
-#include <math.h>  // for fminf/fmaxf
 #include <time.h>
 #include <stdlib.h>
 #include <ctype.h>
 #include <stdio.h>
 
-// --- Framebuffers for 4 daisy-chained 8x8 modules ---
-static uint8_t fb0[8], fb1[8], fb2[8], fb3[8];
+// --- 16×16 framebuffer, row-major: bit x of fb[y] is pixel (x, y) ---
+static uint16_t fb[LED_HEIGHT];
 
 // Column map to accommodate the LED backpack module
 static const uint8_t col_map_8[8] = {7,0,1,2,3,4,5,6};
 
+// Logical 8-pixel row → module RAM byte (col_map_8 applied), built once
+static uint8_t col_remap[256];
+
+// Bars between frames: ballistics, peak hold, floor and AGC
+static display_dyn_t dyn;
+
 // default brightness value
 static uint8_t global_brightness = 15;
 
@@ -38,10 +43,7 @@ const uint8_t smiley[8] = {
 
 // --- Framebuffer helpers ---
 void display_clear(void) {
-    memset(fb0, 0, sizeof(fb0));
-    memset(fb1, 0, sizeof(fb1));
-    memset(fb2, 0, sizeof(fb2));
-    memset(fb3, 0, sizeof(fb3));
+    memset(fb, 0, sizeof(fb));
 }
 
 /*
@@ -63,48 +65,41 @@ Top-right → LED 1
 Bottom-left → LED 2
 Bottom-right → LED 3
 
-Each module has its own 8×8 framebuffer to communicate over I2C.
+The framebuffer is split into the four module RAM images (and the
+column map applied) only when it is flushed by display_render*().
 */
 
 
-// Logical (0..15,0..15) → physical LED
+// Logical (0..15,0..15) → framebuffer bit
 void display_set_pixel(int x, int y) {
     if ((unsigned)x > 15 || (unsigned)y > 15) return;
+    fb[y] |= (uint16_t)(1u << x);
+}
 
-    uint8_t bit = col_map_8[x & 7];
-
-    if (y < 8) {
-        if (x < 8) fb0[y] |= (1 << bit);
-        else       fb1[y] |= (1 << bit);
-    } else {
-        if (x < 8) fb2[y - 8] |= (1 << bit);
-        else       fb3[y - 8] |= (1 << bit);
-    }
+// Bars of heights[x] pixels (clamped to LED_HEIGHT) in columns
+// 0..LED_COLUMNS-1, lit from row 0
+void display_draw_bars(const uint8_t *heights) {
+    display_raster_bars(heights, fb);
 }
 
 void display_draw_glyph_8x8(int x0, int y0, const uint8_t glyph[8]) {
     for (int y = 0; y < 8; y++) {
         uint8_t row = glyph[y];
-        for (int x = 0; x < 8; x++) {
-            if (row & (1 << x)) {
-                display_set_pixel(x0 + x, y0 + y);
-            }
+        if ((unsigned)(y0 + y) > 15) continue;
+
+        if (x0 >= 0 && x0 <= 8) {
+            fb[y0 + y] |= (uint16_t)(row << x0);
+        } else {
+            for (int x = 0; x < 8; x++)
+                if (row & (1 << x))
+                    display_set_pixel(x0 + x, y0 + y);
         }
     }
 }
 
 void display_draw_char(int x0, int y0, char c) {
     if (!isdigit(c)) return;
-    const uint8_t *glyph = font_8x8[c - '0'];
-
-    for (int y = 0; y < 8; y++) {
-        uint8_t row = glyph[y];
-        for (int x = 0; x < 8; x++) {
-            if (row & (1 << x)) {
-                display_set_pixel(x0 + x, y0 + y);
-            }
-        }
-    }
+    display_draw_glyph_8x8(x0, y0, font_8x8[c - '0']);
 }
 
 void display_draw_string(int x_offset, int y, const char *s) {
@@ -125,11 +120,23 @@ void display_init(void) {
     gpio_pull_up(DISPLAY_I2C_SCL);
     sleep_ms(10);
 
+    for (int v = 0; v < 256; v++) {
+        uint8_t b = 0;
+        for (int x = 0; x < 8; x++)
+            if (v & (1 << x)) b |= (uint8_t)(1u << col_map_8[x]);
+        col_remap[v] = b;
+    }
+
     // Initialize HT16K33 devices
     ht16k33_init(HT16K33_ADDR0);
     ht16k33_init(HT16K33_ADDR1);
     ht16k33_init(HT16K33_ADDR2);
     ht16k33_init(HT16K33_ADDR3);
+    ht16k33_async_init();
+
+    display_dyn_config_t cfg;
+    display_dyn_config_params(&cfg);
+    display_dyn_init(&dyn, &cfg);
 
     display_clear();
     display_render();
@@ -137,11 +144,38 @@ void display_init(void) {
 
 
 // --- Render framebuffer to physical LEDs ---
+static const uint8_t module_addrs[4] = {
+    HT16K33_ADDR0, HT16K33_ADDR1, HT16K33_ADDR2, HT16K33_ADDR3
+};
+static uint8_t module_rows[4][8];
+static const uint8_t *const module_fbs[4] = {
+    module_rows[0], module_rows[1], module_rows[2], module_rows[3]
+};
+
+// Split the framebuffer into the module RAM images; the driver sends
+// only the rows that differ from what each module already shows
+bool display_render_async(void) {
+    if (display_render_busy()) return false;
+
+    for (int m = 0; m < 4; m++) {
+        const uint16_t *rows = &fb[(m >> 1) * 8];
+        int shift = (m & 1) * 8;
+        for (int i = 0; i < 8; i++)
+            module_rows[m][i] = col_remap[(rows[i] >> shift) & 0xFF];
+    }
+
+    return ht16k33_update_async(module_addrs, module_fbs, 4);
+}
+
+bool display_render_busy(void) {
+    return ht16k33_busy();
+}
+
 void display_render(void) {
-    ht16k33_update( HT16K33_ADDR0, fb0);
-    ht16k33_update( HT16K33_ADDR1, fb1);
-    ht16k33_update( HT16K33_ADDR2, fb2);
-    ht16k33_update( HT16K33_ADDR3, fb3);
+    while (!display_render_async())
+        tight_loop_contents();
+    while (display_render_busy())
+        tight_loop_contents();
 }
 
 static void display_set_brightness(uint8_t level) {
@@ -245,12 +279,7 @@ static void spectrum_draw(const uint8_t *spectrum) {
     display_clear();
     if (!spectrum) return;
 
-    for (int x = 0; x < 16; x++) {
-        uint8_t h = spectrum[x];
-        if (h > 16) h = 16;
-        for (int y = 0; y < h; y++)
-            display_set_pixel(x, y);
-    }
+    display_draw_bars(spectrum);
 }
 
 static void test_brightness(void) {
@@ -331,38 +360,21 @@ void display_update(display_mode_t mode, const uint8_t *spectrum) {
     }
 }
 
-void display_update_float(const float *spectrum, int length) {
-    if (!spectrum || length <= 0) return;
-
-    display_clear();
-
-    // Find max value in the array for normalization
-    float max_val = 0.0f;
-    for (int i = 0; i < length; i++) {
-        if (spectrum[i] > max_val) max_val = spectrum[i];
-    }
-    if (max_val <= 0.0f) max_val = 1.0f;  // avoid divide by zero
+void display_set_dynamics(const display_dyn_config_t *cfg) {
+    display_dyn_configure(&dyn, cfg);
+}
 
-    // Map to LED columns
-    for (int col = 0; col < LED_COLUMNS; col++) {
-        // Map input spectrum index to LED column
-        int start = col * length / LED_COLUMNS;
-        int end   = (col + 1) * length / LED_COLUMNS;
-        if (end > length) end = length;
+void display_update_db(const int16_t *levels_q8, int length) {
+    if (!levels_q8 || length <= 0) return;
 
-        // Average the values in this range
-        float sum = 0.0f;
-        for (int i = start; i < end; i++) sum += spectrum[i];
-        float avg = sum / (end - start);
+    display_clear();
 
-        // Map average to 0–LED_HEIGHT
-        uint8_t h = (uint8_t)fminf((avg / max_val) * LED_HEIGHT, LED_HEIGHT);
+    uint8_t heights[LED_COLUMNS], peaks[LED_COLUMNS];
+    display_dyn_step(&dyn, levels_q8, length, time_us_32(), heights, peaks);
 
-        // Light up the LEDs
-        for (int y = 0; y < h; y++) {
-            display_set_pixel(col, y);
-        }
-    }
+    // Light up the LEDs
+    display_draw_bars(heights);
+    display_raster_peaks(peaks, fb);
 }
 
 // A struct to capture LED display modes
@@ -1,11 +1,20 @@
 #pragma once
 #include <stdint.h>
+#include <stdbool.h>
+#include "display_map.h"
+#include "display_dyn.h"
 
 // ---- I2C configuration (DISPLAY OWNS THIS) ----
 #define DISPLAY_I2C_PORT i2c0
 #define DISPLAY_I2C_SDA  4
 #define DISPLAY_I2C_SCL  5
+// Fast-mode Plus is beyond the HT16K33's rated 400 kHz and needs
+// strong pull-ups; enable with -DPICO_SPECTRUM_I2C_FMP=ON
+#ifdef DISPLAY_I2C_FMP
+#define DISPLAY_I2C_BAUD 1000000
+#else
 #define DISPLAY_I2C_BAUD 400000
+#endif
 
 // I2C addresses for the four HT16K33 backpacks
 #define HT16K33_ADDR0 0x70
@@ -13,9 +22,6 @@
 #define HT16K33_ADDR2 0x72
 #define HT16K33_ADDR3 0x73
 
-#define LED_HEIGHT 16
-#define LED_COLUMNS 16
-
 #define FONT_W 8
 #define FONT_H 8
 
@@ -36,14 +42,27 @@ void display_init(void);
 // Update framebuffer only (no I2C writes)
 void display_update(display_mode_t mode, const uint8_t *spectrum);
 
-// Update the framebuffer using an array of float values
-void display_update_float(const float *spectrum, int length);
+// Update the framebuffer from band levels in dBFS, Q8 (see dsp.h),
+// through the display dynamics (display_dyn.h): bars and peak dots
+void display_update_db(const int16_t *levels_q8, int length);
+
+// Settings of the display dynamics; cheap to call every frame
+void display_set_dynamics(const display_dyn_config_t *cfg);
 
-// Push framebuffer to all HT16K33 devices
+// Push framebuffer to all HT16K33 devices (blocks until sent)
 void display_render(void);
 
+// Queue the framebuffer to all HT16K33 devices and return at once; the
+// framebuffer may be redrawn immediately. Returns false (frame skipped)
+// while the previous frame is still being sent.
+bool display_render_async(void);
+bool display_render_busy(void);
+
 // Optional helpers (useful elsewhere)
 void display_clear(void);
 void display_set_pixel(int x, int y);
 
+// OR bars of heights[0..LED_COLUMNS-1] pixels into the framebuffer
+void display_draw_bars(const uint8_t *heights);
+
 void display_test(void);
@@ -0,0 +1,161 @@
+#include "display_dyn.h"
+#include "dsp_log.h"
+#include "params.h"
+
+// log2(e) in Q10: dt / tau in units of ln 2
+#define LOG2E_Q10  1477
+
+void display_dyn_config_params(display_dyn_config_t *cfg) {
+    cfg->agc             = param_get(PARAM_DISP_AGC) != 0;
+    cfg->range_db        = param_get(PARAM_DISP_RANGE);
+    cfg->attack_ms       = param_get(PARAM_DISP_ATTACK);
+    cfg->decay_db_s      = param_get(PARAM_DISP_DECAY);
+    cfg->hold_ms         = param_get(PARAM_DISP_HOLD);
+    cfg->peak_decay_db_s = param_get(PARAM_DISP_PEAK_DECAY);
+}
+
+// Share of the way (Q15) a one-pole follower with time constant tau_ms
+// goes in dt ms: 1 - e^(-dt / tau)
+static void fill_k(uint16_t *k, int32_t tau_ms) {
+    for (int dt = 0; dt <= DISPLAY_DT_MAX; dt++) {
+        if (tau_ms <= 0) {
+            k[dt] = dt ? 32768 : 0;
+            continue;
+        }
+        int32_t l = dt * LOG2E_Q10 / tau_ms;
+        k[dt] = l > 17 << 10 ? 32768
+                             : (uint16_t)(32768 - ((exp2_q16(-l) + 1) >> 1));
+    }
+}
+
+// dB/s as dB Q8 per ms, Q16
+static int32_t rate_q16(int32_t db_s) {
+    return (int32_t)(((int64_t)db_s << 24) / 1000);
+}
+
+static bool same_config(const display_dyn_config_t *a, const display_dyn_config_t *b) {
+    return a->agc == b->agc && a->range_db == b->range_db &&
+           a->attack_ms == b->attack_ms && a->decay_db_s == b->decay_db_s &&
+           a->hold_ms == b->hold_ms && a->peak_decay_db_s == b->peak_decay_db_s;
+}
+
+static void apply(display_dyn_t *d, const display_dyn_config_t *cfg) {
+    d->cfg = *cfg;
+    fill_k(d->rise_k, cfg->attack_ms);
+    d->decay_q16 = rate_q16(cfg->decay_db_s);
+    d->peak_decay_q16 = rate_q16(cfg->peak_decay_db_s);
+}
+
+void display_dyn_init(display_dyn_t *d, const display_dyn_config_t *cfg) {
+    fill_k(d->att_k, DISPLAY_AGC_ATTACK_MS);
+    fill_k(d->rel_k, DISPLAY_AGC_RELEASE_MS);
+    d->floor_rise_q16 = rate_q16(DISPLAY_FLOOR_RISE);
+    d->primed = false;
+    apply(d, cfg);
+}
+
+void display_dyn_configure(display_dyn_t *d, const display_dyn_config_t *cfg) {
+    if (!same_config(&d->cfg, cfg)) apply(d, cfg);
+}
+
+// v towards target, a k_q15 share of the way
+static inline int32_t follow(int32_t v, int32_t target, uint32_t k_q15) {
+    return v + (((target - v) * (int32_t)k_q15) >> 15);
+}
+
+// v down towards target by rate (Q16 per ms) times dt, or at once for 0
+static inline int32_t fall(int32_t v, int32_t target, int32_t rate_q16, uint32_t dt) {
+    if (!rate_q16) return target;
+    v -= (int32_t)(((uint32_t)rate_q16 * dt) >> 16);
+    return v < target ? target : v;
+}
+
+// Rows lit for a level: how many of the LED_HEIGHT ascending thresholds
+// it reaches
+static inline uint8_t rows_at(const int32_t *t, int32_t level) {
+    if (level >= t[LED_HEIGHT - 1]) return LED_HEIGHT;
+    uint32_t h = 0;
+    if (level >= t[h + 7]) h += 8;
+    if (level >= t[h + 3]) h += 4;
+    if (level >= t[h + 1]) h += 2;
+    if (level >= t[h]) h += 1;
+    return (uint8_t)h;
+}
+
+void display_dyn_step(display_dyn_t *d, const int16_t *levels_q8, int length,
+                      uint32_t now_us, uint8_t *heights, uint8_t *peaks) {
+    int16_t col[LED_COLUMNS];
+    display_map_columns(levels_q8, length, col);
+
+    int32_t lo = col[0], hi = col[0];
+    for (int c = 1; c < LED_COLUMNS; c++) {
+        if (col[c] < lo) lo = col[c];
+        if (col[c] > hi) hi = col[c];
+    }
+
+    uint32_t dt = 0;
+    if (!d->primed) {
+        for (int c = 0; c < LED_COLUMNS; c++) {
+            d->bar[c] = d->peak[c] = col[c];
+            d->hold[c] = (uint16_t)d->cfg.hold_ms;
+        }
+        d->floor = lo;
+        d->top = hi;
+        d->last_us = now_us;
+        d->primed = true;
+    } else {
+        dt = (now_us - d->last_us) / 1000;
+        if (dt > DISPLAY_DT_MAX) {
+            dt = DISPLAY_DT_MAX;
+            d->last_us = now_us;
+        } else {
+            d->last_us += dt * 1000;
+        }
+
+        // floor: down at once, up slowly; AGC: towards the loudest column
+        int32_t up = d->floor + (int32_t)(((uint32_t)d->floor_rise_q16 * dt) >> 16);
+        d->floor = lo < up ? lo : up;
+        d->top = follow(d->top, hi, hi > d->top ? d->att_k[dt] : d->rel_k[dt]);
+
+        for (int c = 0; c < LED_COLUMNS; c++) {
+            int32_t v = col[c], b = d->bar[c], p = d->peak[c];
+
+            b = v > b ? follow(b, v, d->rise_k[dt]) : fall(b, v, d->decay_q16, dt);
+            if (b >= p) {
+                p = b;
+                d->hold[c] = (uint16_t)d->cfg.hold_ms;
+            } else if (d->hold[c] > dt) {
+                d->hold[c] -= (uint16_t)dt;
+            } else {
+                d->hold[c] = 0;
+                p = fall(p, b, d->peak_decay_q16, dt);
+            }
+            d->bar[c] = (int16_t)b;
+            d->peak[c] = (int16_t)p;
+        }
+    }
+
+    // The window, and the level at which each row lights
+    int32_t bottom, span;
+    if (d->cfg.agc) {
+        int32_t top = d->floor + DB_Q8(DISPLAY_AGC_MIN_SPAN);
+        if (top < DB_Q8(DISPLAY_AGC_MIN_TOP)) top = DB_Q8(DISPLAY_AGC_MIN_TOP);
+        if (top < d->top) top = d->top;
+        int32_t cut = d->floor + DB_Q8(DISPLAY_FLOOR_MARGIN);
+        bottom = top - DB_Q8(d->cfg.range_db);
+        if (bottom < cut) bottom = cut;
+        span = top - bottom;
+    } else {
+        bottom = DB_Q8(DISPLAY_DB_MIN);
+        span = DB_Q8(DISPLAY_DB_MAX - DISPLAY_DB_MIN);
+    }
+    int32_t t[LED_HEIGHT];
+    for (int r = 0; r < LED_HEIGHT; r++)
+        t[r] = bottom + ((r + 1) * span + LED_HEIGHT - 1) / LED_HEIGHT;
+
+    bool dots = peaks && d->cfg.hold_ms;
+    for (int c = 0; c < LED_COLUMNS; c++) {
+        heights[c] = rows_at(t, d->bar[c]);
+        if (peaks) peaks[c] = dots ? rows_at(t, d->peak[c]) : 0;
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "display_map.h"
+
+/*
+ * Display dynamics: between the band levels and the bars, once per
+ * drawn frame on core 0. Integer only, and on the LED_COLUMNS columns
+ * (the loudest band in each, as display_map_db()) rather than the bands:
+ *
+ *   noise floor  the quietest column, followed down at once and up at
+ *                DISPLAY_FLOOR_RISE dB/s; nothing within
+ *                DISPLAY_FLOOR_MARGIN dB of it lights
+ *   AGC          the loudest column, followed with a slow attack and a
+ *                slower release, is the top of a window `range` dB tall
+ *                (cut off at the floor margin). The top stays at least
+ *                DISPLAY_AGC_MIN_SPAN dB over the floor and no lower
+ *                than DISPLAY_AGC_MIN_TOP dBFS, so a quiet passage
+ *                fills more of the display but the noise under it, or
+ *                on its own, stays low
+ *   ballistics   each bar rises with a time constant and falls at a
+ *                fixed rate in dB/s
+ *   peak hold    a dot over each bar at its recent peak, held for a
+ *                time and then falling at its own rate
+ *
+ * With the AGC off the window is the fixed DISPLAY_DB_MIN..MAX one.
+ *
+ * Time constants become tables of coefficients per elapsed millisecond
+ * when they are set, and levels map to rows by comparing against the
+ * frame's LED_HEIGHT row thresholds, so a frame has no divisions (one
+ * for the elapsed time) and no float.
+ */
+
+// Longest step the dynamics take in one frame, in ms: the coefficient
+// tables run this far, and a longer gap between frames counts as this
+#define DISPLAY_DT_MAX  100
+
+#ifndef DISPLAY_FLOOR_RISE
+#define DISPLAY_FLOOR_RISE      3       // dB/s
+#endif
+#ifndef DISPLAY_FLOOR_MARGIN
+#define DISPLAY_FLOOR_MARGIN    10      // dB
+#endif
+#ifndef DISPLAY_AGC_ATTACK_MS
+#define DISPLAY_AGC_ATTACK_MS   100
+#endif
+#ifndef DISPLAY_AGC_RELEASE_MS
+#define DISPLAY_AGC_RELEASE_MS  4000
+#endif
+#ifndef DISPLAY_AGC_MIN_SPAN
+#define DISPLAY_AGC_MIN_SPAN    24      // dB
+#endif
+#ifndef DISPLAY_AGC_MIN_TOP
+#define DISPLAY_AGC_MIN_TOP     (-40)   // dBFS
+#endif
+
+typedef struct {
+    bool    agc;                // noise floor and AGC; off: fixed window
+    int32_t range_db;           // window height with the AGC on
+    int32_t attack_ms;          // bar rise time constant, 0 = at once
+    int32_t decay_db_s;         // bar fall, 0 = at once
+    int32_t hold_ms;            // peak hold, 0 = no peak dots
+    int32_t peak_decay_db_s;    // peak fall after the hold, 0 = at once
+} display_dyn_config_t;
+
+typedef struct {
+    display_dyn_config_t cfg;
+    uint16_t rise_k[DISPLAY_DT_MAX + 1];    // Q15 share of the way, per ms elapsed
+    uint16_t att_k[DISPLAY_DT_MAX + 1];
+    uint16_t rel_k[DISPLAY_DT_MAX + 1];
+    int32_t  decay_q16;                     // dB Q8 per ms, Q16
+    int32_t  peak_decay_q16;
+    int32_t  floor_rise_q16;
+    int16_t  bar[LED_COLUMNS];              // dBFS, Q8
+    int16_t  peak[LED_COLUMNS];
+    uint16_t hold[LED_COLUMNS];             // ms of hold left
+    int32_t  floor, top;                    // dBFS, Q8
+    uint32_t last_us;
+    bool     primed;
+} display_dyn_t;
+
+// The configuration the display_* parameters (params.h) hold
+void display_dyn_config_params(display_dyn_config_t *cfg);
+
+// Cleared state (the first frame is taken as it is)
+void display_dyn_init(display_dyn_t *d, const display_dyn_config_t *cfg);
+
+// New settings, keeping the state; the tables are only rebuilt if
+// something changed
+void display_dyn_configure(display_dyn_t *d, const display_dyn_config_t *cfg);
+
+// One frame of band levels (dBFS, Q8) at now_us (any microsecond clock,
+// modulo 2^32): bar heights (0..LED_HEIGHT) and peak dots (row + 1,
+// 0 = none) per column. peaks may be NULL.
+void display_dyn_step(display_dyn_t *d, const int16_t *levels_q8, int length,
+                      uint32_t now_us, uint8_t *heights, uint8_t *peaks);
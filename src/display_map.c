@@ -0,0 +1,57 @@
+#include "display_map.h"
+
+void display_map_columns(const int16_t *levels_q8, int length, int16_t *columns) {
+    for (int col = 0; col < LED_COLUMNS; col++) {
+        // Map input level index to LED column, keep the loudest level
+        int start = col * length / LED_COLUMNS;
+        int end   = (col + 1) * length / LED_COLUMNS;
+        if (end <= start) end = start + 1;
+        if (end > length) end = length;
+
+        int16_t level = levels_q8[start];
+        for (int i = start + 1; i < end; i++)
+            if (levels_q8[i] > level) level = levels_q8[i];
+        columns[col] = level;
+    }
+}
+
+void display_map_db(const int16_t *levels_q8, int length, uint8_t *heights) {
+    const int32_t lo = DISPLAY_DB_MIN * 256;
+    const int32_t span = (DISPLAY_DB_MAX - DISPLAY_DB_MIN) * 256;
+    int16_t columns[LED_COLUMNS];
+
+    display_map_columns(levels_q8, length, columns);
+    for (int col = 0; col < LED_COLUMNS; col++) {
+        // Map the dB window to 0–LED_HEIGHT
+        int32_t h = (columns[col] - lo) * LED_HEIGHT / span;
+        if (h < 0) h = 0;
+        if (h > LED_HEIGHT) h = LED_HEIGHT;
+        heights[col] = (uint8_t)h;
+    }
+}
+
+// Columns are bucketed by height and each row is then one OR of
+// everything taller than it
+void display_raster_bars(const uint8_t *heights, uint16_t *fb) {
+    uint16_t ends[LED_HEIGHT + 1] = { 0 };
+
+    for (int x = 0; x < LED_COLUMNS; x++) {
+        uint8_t h = heights[x];
+        if (h > LED_HEIGHT) h = LED_HEIGHT;
+        ends[h] |= (uint16_t)(1u << x);
+    }
+
+    uint16_t lit = 0;
+    for (int y = LED_HEIGHT - 1; y >= 0; y--) {
+        lit |= ends[y + 1];
+        fb[y] |= lit;
+    }
+}
+
+void display_raster_peaks(const uint8_t *peaks, uint16_t *fb) {
+    for (int x = 0; x < LED_COLUMNS; x++) {
+        uint8_t p = peaks[x];
+        if (p > LED_HEIGHT) p = LED_HEIGHT;
+        if (p) fb[p - 1] |= (uint16_t)(1u << x);
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * Band levels → LED bars, hardware-independent so host tools render
+ * exactly what the matrix shows. display.c draws through these.
+ */
+
+#define LED_HEIGHT 16
+#define LED_COLUMNS 16
+
+// dBFS window shown by display_update_db (bottom row .. full column)
+#define DISPLAY_DB_MIN (-60)
+#define DISPLAY_DB_MAX 0
+
+// Level per column from band levels in dBFS, Q8: the loudest band that
+// falls in each column
+void display_map_columns(const int16_t *levels_q8, int length, int16_t *columns);
+
+// Bar height (0..LED_HEIGHT) per column from band levels in dBFS, Q8:
+// the column level (display_map_columns) over the dB window
+void display_map_db(const int16_t *levels_q8, int length, uint8_t *heights);
+
+// OR bars of heights[0..LED_COLUMNS-1] pixels, lit from row 0, into a
+// row-major framebuffer (bit x of fb[y] is pixel (x, y))
+void display_raster_bars(const uint8_t *heights, uint16_t *fb);
+
+// OR a dot at row peaks[x] - 1 of each column (none for 0)
+void display_raster_peaks(const uint8_t *peaks, uint16_t *fb);
@@ -1,135 +1,132 @@
 #include "dsp.h"
+#include "dsp_fft.h"
+#include "dsp_log.h"
+#include "dsp_tables.h"
 #include <string.h>
-#include <math.h>
-
-#define FFT_SIZE   256
-#define NUM_BANDS  16
-
-/* ---------- Fixed-point FFT types ---------- */
-
-typedef struct {
-    int16_t re;  // real
-    int16_t im;  // imaginary
-} cpx16_t;       // complex number 
 
+// FFT_SIZE real samples packed as even/odd pairs, or a stereo window
+// as { left, right } pairs
 static cpx16_t fft_buf[FFT_SIZE];
 
-/* Output bands */
-float band_levels[NUM_BANDS];
+/* Output bands, dBFS in Q8 */
+int16_t band_levels[NUM_BANDS];
+band_exchange_t dsp_band_frames;
 
-/* ---------- Sine table (Q15) ---------- */
+static const int16_t *window = dsp_window_hann;
+static int32_t window_loss_q8 = DSP_HANN_LOSS_Q8;
 
-static const int16_t sin_lut[128] = {
-      0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
-   6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
-  12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
-  18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
-  23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
-  27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
-  30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
-  32138, 32286, 32415, 32524, 32615, 32686, 32738, 32767,
-};
+/* ---------- Public API ---------- */
 
-/* ---------- Helpers ---------- */
+void dsp_init(void) {
+    for (int b = 0; b < NUM_BANDS; b++)
+        band_levels[b] = DB_FLOOR_Q8;
+    dsp_set_window(DSP_WINDOW_HANN);
+}
 
-static inline int16_t q15_mul(int16_t a, int16_t b) {
-    return (int16_t)((a * b) >> 15);
+void dsp_set_window(dsp_window_t w) {
+    switch (w) {
+        case DSP_WINDOW_RECT:
+            window = NULL;
+            window_loss_q8 = 0;
+            break;
+        case DSP_WINDOW_BLACKMAN:
+            window = dsp_window_blackman;
+            window_loss_q8 = DSP_BLACKMAN_LOSS_Q8;
+            break;
+        default:
+            window = dsp_window_hann;
+            window_loss_q8 = DSP_HANN_LOSS_Q8;
+            break;
+    }
 }
 
-static inline int16_t sin_q15(int i) {
-    return sin_lut[i & 0x7F];
+/* ---------- Helpers ---------- */
+
+// FFT_SIZE 12-bit samples → Q15 at dst[0], dst[stride], ...
+static void load(const int16_t *samples, int16_t *dst, int stride) {
+    if (!window) {
+        for (int i = 0; i < FFT_SIZE; i++)
+            dst[i * stride] = samples[i] << 4;  // scale 12-bit ADC to full Q15 range
+    } else {
+        // windowed: 12-bit × Q15 >> 11 = Q15, rounded
+        for (int i = 0; i < FFT_SIZE; i++)
+            dst[i * stride] = (int16_t)((samples[i] * window[i] + (1 << 10)) >> 11);
+    }
 }
 
-static inline int16_t cos_q15(int i) {
-    return sin_lut[(i + 32) & 0x7F];
+static inline uint32_t bin_power(int32_t re, int32_t im) {
+    return (uint32_t)(re * re) + (uint32_t)(im * im);
 }
 
-/* ---------- FFT ---------- */
-
-static void fft256(cpx16_t *buf) {
-    /* Bit reversal */
-    for (uint16_t i = 1, j = 0; i < FFT_SIZE; i++) {
-        uint16_t bit = FFT_SIZE >> 1;
-        for (; j & bit; bit >>= 1) j ^= bit;
-        j |= bit;
-        if (i < j) {
-            cpx16_t t = buf[i];
-            buf[i] = buf[j];
-            buf[j] = t;
-        }
+static void publish(const uint64_t *power, int exponent) {
+    /* Power → dBFS (0 dB = full-scale sine) */
+    for (int b = 0; b < NUM_BANDS; b++) {
+        int32_t db = DB_FLOOR_Q8;
+        if (power[b])
+            db = power_db_q8(power[b], exponent) - DSP_DBFS_OFFSET_Q8 + window_loss_q8;
+        if (db < DB_FLOOR_Q8) db = DB_FLOOR_Q8;
+        band_levels[b] = (int16_t)db;
     }
 
-    /* FFT Butterfly */
-    for (uint16_t len = 2; len <= FFT_SIZE; len <<= 1) {
-        // number of butterflies per group
-        uint16_t half = len >> 1;
-        // twiddle factor spacing
-        uint16_t step = FFT_SIZE / len;
-
-        // iterate over each group
-        for (uint16_t i = 0; i < FFT_SIZE; i += len) {
-            // iterate over the butterflies in each group
-            for (uint16_t j = 0; j < half; j++) {
-                // index into the SIN/COS table
-                uint16_t k = j * step;
-                // twiddle factor
-                // W=cos−j⋅sin
-                int16_t wr = cos_q15(k);
-                int16_t wi = -sin_q15(k);
-
-                cpx16_t a = buf[i + j];
-                cpx16_t b = buf[i + j + half];
-                
-                int16_t tr =
-                    q15_mul(b.re, wr) - q15_mul(b.im, wi);
-                int16_t ti =
-                    q15_mul(b.re, wi) + q15_mul(b.im, wr);
-
-                buf[i + j].re = a.re + tr;
-                buf[i + j].im = a.im + ti;
-                buf[i + j + half].re = a.re - tr;
-                buf[i + j + half].im = a.im - ti;
-            }
-        }
-    }
+    band_exchange_publish(&dsp_band_frames, band_levels);
 }
 
-/* ---------- Public API ---------- */
+/* ---------- Analysis ---------- */
 
-void dsp_init(void) {
-    memset(band_levels, 0, sizeof(band_levels));
-}
+void dsp_process(const int16_t *samples) {
+    /* Copy input (Q15), even samples → re, odd samples → im */
+    load(samples, &fft_buf[0].re, 1);
 
-// 0.6f is a visual tuning constant for log compressions
-const float VISUAL_TUNING = 0.6f;
+    // block exponent: true bins = fft_buf * 2^exponent
+    int exponent = fft_real(fft_buf);
 
-void dsp_process(volatile int16_t *samples) {
-    /* Copy input (Q15) */
-    for (int i = 0; i < FFT_SIZE; i++) {
-        fft_buf[i].re = samples[i] << 3;  // scale 12-bit ADC to ~15 bit range
-        fft_buf[i].im = 0;
-    }
+    /* Bin → band power (log-spaced bands, integer) */
+    uint64_t power[NUM_BANDS];
+    memset(power, 0, sizeof(power));
 
-    fft256(fft_buf);
+    for (int i = 1; i < FFT_SIZE / 2; i++)
+        power[dsp_band_map[i]] += bin_power(fft_buf[i].re, fft_buf[i].im);
 
-    /* Clear bands */
-    for (int b = 0; b < NUM_BANDS; b++)
-        band_levels[b] = 0;
+    publish(power, exponent);
+}
 
-    /* Bin → band mapping (log-ish) */
-    for (int i = 1; i < FFT_SIZE / 2; i++) {
-        int band = (i * NUM_BANDS) / (FFT_SIZE / 2);
-        int32_t mag =
-            (int32_t)fft_buf[i].re * fft_buf[i].re +
-            (int32_t)fft_buf[i].im * fft_buf[i].im;
+void dsp_process_stereo(const int16_t *samples, dsp_view_t view) {
+    static int16_t mid[FFT_SIZE];
+    const int16_t *right = samples + FFT_SIZE;
 
-        band_levels[band] += (float)mag;
+    if (view != DSP_VIEW_LR && view != DSP_VIEW_MS) {
+        // fft_real on the folded window is cheaper than fft_stereo
+        for (int i = 0; i < FFT_SIZE; i++)
+            mid[i] = (int16_t)((samples[i] + right[i]) >> 1);
+        dsp_process(mid);
+        return;
     }
 
+    /* Left → re, right → im */
+    load(samples, &fft_buf[0].re, 2);
+    load(right, &fft_buf[0].im, 2);
 
-    /* Log compression + scaling */
-    for (int b = 0; b < NUM_BANDS; b++) {
-        float v = band_levels[b];
-        band_levels[b] = v > 0 ? (log10f(v) * VISUAL_TUNING) : 0;
+    // L[k] = fft_buf[k], R[k] = fft_buf[FFT_SIZE - k]
+    int exponent = fft_stereo(fft_buf);
+
+    /* Bin → half-band power: first half of the display L or M, second R or S */
+    uint64_t power[NUM_BANDS];
+    memset(power, 0, sizeof(power));
+
+    for (int i = 1; i < FFT_SIZE / 2; i++) {
+        cpx16_t l = fft_buf[i];
+        cpx16_t r = fft_buf[FFT_SIZE - i];
+        int b = dsp_band_map[i] >> 1;
+
+        if (view == DSP_VIEW_LR) {
+            power[b] += bin_power(l.re, l.im);
+            power[NUM_BANDS / 2 + b] += bin_power(r.re, r.im);
+        } else {
+            // M = (L + R) / 2, S = (L - R) / 2
+            power[b] += bin_power((l.re + r.re) >> 1, (l.im + r.im) >> 1);
+            power[NUM_BANDS / 2 + b] += bin_power((l.re - r.re) >> 1, (l.im - r.im) >> 1);
+        }
     }
+
+    publish(power, exponent);
 }
@@ -1,7 +1,51 @@
 #pragma once
 #include <stdint.h>
+#include "dsp_config.h"
+#include "spsc.h"
+
+// Analysis window applied before the FFT. Tapered windows trade a
+// wider main lobe for far less leakage into neighbouring bands.
+typedef enum {
+    DSP_WINDOW_RECT,
+    DSP_WINDOW_HANN,        // default
+    DSP_WINDOW_BLACKMAN,
+    DSP_WINDOW_COUNT
+} dsp_window_t;
+
+// Analysis engine writing band_levels: the FFT (dsp_process) or the
+// constant-Q filterbank (dsp_fb.h)
+typedef enum {
+    DSP_ENGINE_FFT,
+    DSP_ENGINE_FILTERBANK,
+    DSP_ENGINE_COUNT
+} dsp_engine_t;
+
+// What the bands of a stereo window show. The split views give each
+// half of the display NUM_BANDS / 2 bands, two FFT bands merged into
+// each: left then right, or mid then side.
+typedef enum {
+    DSP_VIEW_MID,           // default: (L + R) / 2 over all bands
+    DSP_VIEW_LR,
+    DSP_VIEW_MS,
+    DSP_VIEW_COUNT
+} dsp_view_t;
 
 void dsp_init(void);
-void dsp_process(volatile int16_t *samples);
+void dsp_process(const int16_t *samples);
+
+// Planar stereo window: FFT_SIZE left samples, then FFT_SIZE right.
+// The split views put both channels through one FFT_SIZE-point complex
+// FFT (fft_stereo); the mid view folds them and runs dsp_process.
+void dsp_process_stereo(const int16_t *samples, dsp_view_t view);
+
+// Window for the following dsp_process calls; levels stay in dBFS
+// whichever is chosen. Out-of-range values select Hann.
+void dsp_set_window(dsp_window_t window);
+
+// Per-band level in dBFS, Q8 (1/256 dB); 0 dB = full-scale sine.
+// Scratch for the core running dsp_process; other cores read
+// dsp_band_frames instead.
+extern int16_t band_levels[NUM_BANDS];
 
-extern float band_levels[16];
+// Every dsp_process result, published tear-free for core 0
+extern band_exchange_t dsp_band_frames;
@@ -0,0 +1,49 @@
+#pragma once
+
+// Analysis FFT size, from the PICO_SPECTRUM_FFT_SIZE CMake option
+#ifndef FFT_SIZE
+#define FFT_SIZE 256
+#endif
+
+#if FFT_SIZE < 128 || FFT_SIZE > 2048 || (FFT_SIZE & (FFT_SIZE - 1))
+#error "FFT_SIZE must be a power of two in 128..2048"
+#endif
+
+// ADC → effect → PWM block size, from the PICO_SPECTRUM_AUDIO_BLOCK
+// CMake option. The analysis cuts its own FFT_SIZE windows from the
+// same stream, so this only sets the monitoring latency.
+#ifndef AUDIO_BLOCK_SIZE
+#define AUDIO_BLOCK_SIZE 32
+#endif
+
+#if AUDIO_BLOCK_SIZE < 8 || AUDIO_BLOCK_SIZE > FFT_SIZE || \
+    (AUDIO_BLOCK_SIZE & (AUDIO_BLOCK_SIZE - 1))
+#error "AUDIO_BLOCK_SIZE must be a power of two in 8..FFT_SIZE"
+#endif
+
+// Band frames per second the display wants; the STFT hop is kept short
+// enough for a new analysis window every frame (see dsp_hop.h)
+#ifndef ANALYSIS_FRAME_HZ
+#define ANALYSIS_FRAME_HZ 60
+#endif
+
+// MCP3202 inputs sampled, from the PICO_SPECTRUM_STEREO CMake option:
+// 2 = CH0 left, CH1 right; 1 = CH0 only
+#ifndef ADC_CHANNELS
+#define ADC_CHANNELS 2
+#endif
+
+#if ADC_CHANNELS != 1 && ADC_CHANNELS != 2
+#error "ADC_CHANNELS must be 1 or 2"
+#endif
+
+// Effect chain slots (dsp_fx.h)
+#define FX_SLOTS 4
+
+// Spectrum bands (one per display column)
+#define NUM_BANDS 16
+
+// ADC sample rate, from the PICO_SPECTRUM_SAMPLE_RATE CMake option
+#ifndef SAMPLE_RATE_HZ
+#define SAMPLE_RATE_HZ 44100
+#endif
@@ -0,0 +1,93 @@
+#include "dsp_fb.h"
+#include "dsp.h"
+#include "dsp_log.h"
+#include "dsp_tables.h"
+
+#if NUM_BANDS % 2 || NUM_BANDS > 32
+#error "the filterbank needs an even NUM_BANDS of at most 32"
+#endif
+
+#define FB_OCTAVES    (NUM_BANDS / 2)
+
+// Envelope time constant, 2^FB_ENV_SHIFT samples at the octave's rate
+#define FB_ENV_SHIFT  3
+
+// dB (Q8) of the envelope of a full-scale sine: mean of (2^15 sin)^2
+#define FB_DBFS_OFFSET_Q8  DB_Q8(87.2987)
+
+typedef struct {
+    int16_t x1, x2, y1, y2;
+} biquad_t;
+
+static biquad_t bandpass[FB_OCTAVES][2];
+static biquad_t lowpass[FB_OCTAVES - 1][2];
+static int32_t  envelope[FB_OCTAVES][2];    // power, Q30
+
+// Bit o set: octave o + 1 takes the next low-pass output of octave o
+static uint32_t decimate;
+
+void dsp_fb_init(void) {
+    for (int o = 0; o < FB_OCTAVES; o++) {
+        for (int j = 0; j < 2; j++) {
+            bandpass[o][j] = (biquad_t){ 0 };
+            envelope[o][j] = 0;
+            if (o < FB_OCTAVES - 1) lowpass[o][j] = (biquad_t){ 0 };
+        }
+    }
+    decimate = 0;
+}
+
+// Direct form I, Q14 coefficients { b0, b1, b2, a1, a2 }; their
+// magnitudes sum below 4 (checked by the generator), so the int32 sum
+// cannot overflow
+static inline int16_t biquad(biquad_t *f, const int16_t *c, int16_t x) {
+    int32_t acc = c[0] * x + c[1] * f->x1 + c[2] * f->x2
+                - c[3] * f->y1 - c[4] * f->y2;
+    int32_t y = (acc + (1 << 13)) >> 14;
+    if (y > 32767) y = 32767;
+    if (y < -32768) y = -32768;
+
+    f->x2 = f->x1;
+    f->x1 = x;
+    f->y2 = f->y1;
+    f->y1 = (int16_t)y;
+    return (int16_t)y;
+}
+
+void dsp_fb_process(const int16_t *samples, int n) {
+    for (int i = 0; i < n; i++) {
+        int16_t x = (int16_t)(samples[i] << 4);     // 12-bit → Q15
+
+        for (int o = 0; ; o++) {
+            for (int j = 0; j < 2; j++) {
+                int32_t y = biquad(&bandpass[o][j], dsp_fb_bandpass[j], x);
+                envelope[o][j] += (y * y - envelope[o][j]) >> FB_ENV_SHIFT;
+            }
+            if (o == FB_OCTAVES - 1) break;
+
+            x = biquad(&lowpass[o][0], dsp_fb_lowpass[0], x);
+            x = biquad(&lowpass[o][1], dsp_fb_lowpass[1], x);
+            decimate ^= 1u << o;
+            if (decimate & (1u << o)) break;        // every other sample goes down
+        }
+    }
+
+    for (int o = 0; o < FB_OCTAVES; o++) {
+        for (int j = 0; j < 2; j++) {
+            int b = NUM_BANDS - 1 - 2 * o - j;
+            int32_t db = DB_FLOOR_Q8;
+            if (envelope[o][j] > 0)
+                db = power_db_q8((uint64_t)envelope[o][j], 0) - FB_DBFS_OFFSET_Q8;
+            if (db < DB_FLOOR_Q8) db = DB_FLOOR_Q8;
+            band_levels[b] = (int16_t)db;
+        }
+    }
+
+    band_exchange_publish(&dsp_band_frames, band_levels);
+}
+
+uint32_t dsp_fb_band_hz(int band) {
+    int k = NUM_BANDS - 1 - band;
+    uint32_t per_mille = k & 1 ? DSP_FB_CENTRE_LOWER : DSP_FB_CENTRE_UPPER;
+    return ((uint32_t)SAMPLE_RATE_HZ * per_mille / 1000) >> (k / 2);
+}
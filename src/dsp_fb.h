@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+#include "dsp_config.h"
+
+/*
+ * Constant-Q analysis: a multirate filterbank of half-octave Q15
+ * biquad band-passes, two per octave, in place of the FFT.
+ *
+ * The top octave runs at the sample rate; a 4th-order low-pass and
+ * decimation by two feed each octave below, so every octave uses the
+ * same coefficients and the whole bank costs about eight biquads per
+ * input sample whatever the number of octaves. Each band has a power
+ * envelope with a time constant of 8 samples at its octave's rate,
+ * i.e. the same number of cycles of its centre frequency in every
+ * band: the treble settles within a millisecond, the bass about as
+ * fast as its narrow band allows, and nothing waits for an FFT window.
+ *
+ * Band b sits in octave (NUM_BANDS - 1 - b) / 2 from the top, with
+ * the top band centred at 0.3 x the sample rate (13.2 kHz at 44.1 kHz)
+ * and the bottom one 7.5 octaves below. Levels go to band_levels and
+ * dsp_band_frames in the same dBFS as dsp_process.
+ */
+
+// Samples per dsp_fb_process call on the device (one band frame each)
+#define DSP_FB_BLOCK 128
+
+void dsp_fb_init(void);
+
+// Run n 12-bit samples through the bank, then publish the band levels
+void dsp_fb_process(const int16_t *samples, int n);
+
+// Centre frequency of a band at the build's sample rate
+uint32_t dsp_fb_band_hz(int band);
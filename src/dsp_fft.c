@@ -0,0 +1,259 @@
+#include "dsp_fft.h"
+#include "dsp_tables.h"
+
+/*
+ * Real FFTs are computed as a half-size complex FFT over the even/odd
+ * sample pairs, followed by a split pass that recovers bins 0..N/2.
+ *
+ * The complex kernel is a mixed-radix decimation-in-time FFT.
+ *
+ * The input is permuted into bit-reversed order once, using a table of
+ * swap pairs. Pairs of radix-2 stages are then fused into radix-4
+ * butterflies (3 complex multiplies per 4 points instead of 4). When
+ * log2(N) is odd a single twiddle-free radix-2 stage runs first.
+ *
+ * With bit-reversed input, the four quarter-blocks of a span-L group
+ * hold the L/4-point DFTs of the samples n = 0, 2, 1, 3 (mod 4), which
+ * is why the butterfly pairs the 2nd and 3rd quarters the way it does.
+ *
+ * The swap pairs and the stage-ordered twiddles ({ W^k, W^2k, W^3k } per
+ * k = 1..L/4-1 of each radix-4 stage) are generated for the configured
+ * FFT_SIZE by tools/gen_dsp_tables.py, once for the FFT_SIZE/2-point
+ * kernel of the real FFT and once for the FFT_SIZE-point kernel of the
+ * stereo FFT.
+ */
+
+/* ---------- Helpers ---------- */
+
+// Rotated values can reach sqrt(2) * full scale, so they stay 32-bit
+typedef struct {
+    int32_t re;
+    int32_t im;
+} cpx32_t;
+
+// Q15 complex multiply, single rounding shift
+static inline cpx32_t cmul_q15(cpx16_t a, cpx16_t w) {
+    cpx32_t r;
+    r.re = ((int32_t)a.re * w.re - (int32_t)a.im * w.im + 16384) >> 15;
+    r.im = ((int32_t)a.re * w.im + (int32_t)a.im * w.re + 16384) >> 15;
+    return r;
+}
+
+static inline cpx32_t cpx32(cpx16_t a) {
+    cpx32_t r = { a.re, a.im };
+    return r;
+}
+
+/*
+ * Block floating point: before each stage the peak magnitude written by
+ * the previous stage picks a right shift that guarantees the stage
+ * cannot overflow int16. Worst-case component growth is 1 + 3*sqrt(2)
+ * for a radix-4 butterfly, 2 for the twiddle-free radix-2 stage and
+ * 1 + sqrt(2) for the real-FFT split pass, so the peak may use at most
+ * 12, 14 and 13 bits respectively. Shifts are summed into a block
+ * exponent: true spectrum = buf * 2^exponent.
+ */
+#define BFP_BITS_RADIX4  12
+#define BFP_BITS_RADIX2  14
+#define BFP_BITS_SPLIT   13
+
+// ~v for negatives is one short of |v|, which the limits above absorb
+static inline uint32_t mag_bits(int32_t v) {
+    return (uint32_t)(v ^ (v >> 31));
+}
+
+static int stage_shift(uint32_t peak, int max_bits) {
+    int bits = 0;
+    while (peak) { bits++; peak >>= 1; }
+    return bits > max_bits ? bits - max_bits : 0;
+}
+
+typedef struct {
+    int      shift;
+    int32_t  round;
+    uint32_t peak;    // OR of magnitudes written this stage
+} bfp_t;
+
+static inline void bfp_begin(bfp_t *st, int max_bits) {
+    st->shift = stage_shift(st->peak, max_bits);
+    st->round = st->shift ? 1 << (st->shift - 1) : 0;
+    st->peak  = 0;
+}
+
+static inline int16_t bfp_out(bfp_t *st, int32_t v) {
+    v = (v + st->round) >> st->shift;
+    st->peak |= mag_bits(v);
+    return (int16_t)v;
+}
+
+static inline void radix4(bfp_t *st,
+                          cpx16_t *p0, cpx16_t *p1, cpx16_t *p2, cpx16_t *p3,
+                          cpx32_t b, cpx32_t c, cpx32_t d) {
+    cpx16_t a = *p0;
+
+    int32_t t0r = a.re + b.re, t0i = a.im + b.im;
+    int32_t t1r = a.re - b.re, t1i = a.im - b.im;
+    int32_t t2r = c.re + d.re, t2i = c.im + d.im;
+    int32_t t3r = c.re - d.re, t3i = c.im - d.im;
+
+    p0->re = bfp_out(st, t0r + t2r);  p0->im = bfp_out(st, t0i + t2i);
+    p2->re = bfp_out(st, t0r - t2r);  p2->im = bfp_out(st, t0i - t2i);
+    // X1 = t1 - j*t3, X3 = t1 + j*t3
+    p1->re = bfp_out(st, t1r + t3i);  p1->im = bfp_out(st, t1i - t3r);
+    p3->re = bfp_out(st, t1r - t3i);  p3->im = bfp_out(st, t1i + t3r);
+}
+
+/* ---------- FFT ---------- */
+
+typedef struct {
+    int             size;
+    int             log2;
+    int             num_swaps;
+    const uint16_t (*swaps)[2];
+    const cpx16_t  *twiddles;
+} fft_plan_t;
+
+static const fft_plan_t half_plan = {
+    FFT_CPX_SIZE, FFT_CPX_LOG2, FFT_NUM_SWAPS, fft_bitrev_swaps, fft_twiddles,
+};
+
+static const fft_plan_t full_plan = {
+    FFT_SIZE, FFT_LOG2, FFT_STEREO_NUM_SWAPS, fft_stereo_swaps, fft_stereo_twiddles,
+};
+
+// Inlined into each caller, so the plan's sizes are constants again
+static inline int fft_complex_bfp(cpx16_t *buf, bfp_t *st, const fft_plan_t *plan) {
+    const int size = plan->size;
+    int exponent = 0;
+
+    /* Input headroom */
+    st->peak = 0;
+    for (int i = 0; i < size; i++)
+        st->peak |= mag_bits(buf[i].re) | mag_bits(buf[i].im);
+
+    /* Bit reversal */
+    for (int n = 0; n < plan->num_swaps; n++) {
+        uint16_t i = plan->swaps[n][0];
+        uint16_t j = plan->swaps[n][1];
+        cpx16_t t = buf[i];
+        buf[i] = buf[j];
+        buf[j] = t;
+    }
+
+    int len = 4;
+
+    /* Radix-2 stage for odd log2(N) (W^0 only) */
+    if (plan->log2 & 1) {
+        bfp_begin(st, BFP_BITS_RADIX2);
+        for (int i = 0; i < size; i += 2) {
+            cpx16_t a = buf[i];
+            cpx16_t b = buf[i + 1];
+            buf[i].re     = bfp_out(st, (int32_t)a.re + b.re);
+            buf[i].im     = bfp_out(st, (int32_t)a.im + b.im);
+            buf[i + 1].re = bfp_out(st, (int32_t)a.re - b.re);
+            buf[i + 1].im = bfp_out(st, (int32_t)a.im - b.im);
+        }
+        exponent += st->shift;
+        len = 8;
+    }
+
+    /* Radix-4 stages */
+    const cpx16_t *w = plan->twiddles;
+    for (; len <= size; len <<= 2) {
+        int q = len >> 2;
+        bfp_begin(st, BFP_BITS_RADIX4);
+
+        // k = 0: all twiddles are 1
+        for (int i = 0; i < size; i += len)
+            radix4(st, &buf[i], &buf[i + q], &buf[i + 2 * q], &buf[i + 3 * q],
+                   cpx32(buf[i + q]), cpx32(buf[i + 2 * q]), cpx32(buf[i + 3 * q]));
+
+        for (int k = 1; k < q; k++, w += 3) {
+            cpx16_t w1 = w[0], w2 = w[1], w3 = w[2];
+            for (int i = k; i < size; i += len) {
+                cpx16_t *p = &buf[i];
+                radix4(st, p, p + q, p + 2 * q, p + 3 * q,
+                       cmul_q15(p[q], w2),
+                       cmul_q15(p[2 * q], w1),
+                       cmul_q15(p[3 * q], w3));
+            }
+        }
+        exponent += st->shift;
+    }
+    return exponent;
+}
+
+int fft_complex(cpx16_t *buf) {
+    bfp_t st;
+    return fft_complex_bfp(buf, &st, &half_plan);
+}
+
+/* ---------- Real FFT ---------- */
+
+/*
+ * With Z = FFT(x[2n] + j*x[2n+1]) and M = FFT_SIZE/2:
+ *   Fe[k] = (Z[k] + conj(Z[M-k])) / 2          even-sample spectrum
+ *   Fo[k] = -j * (Z[k] - conj(Z[M-k])) / 2     odd-sample spectrum
+ *   X[k]   = Fe[k] + W^k * Fo[k]
+ *   X[M-k] = conj(Fe[k] - W^k * Fo[k])
+ * so each (k, M-k) pair is finished in place from one twiddle.
+ */
+int fft_real(cpx16_t *buf) {
+    bfp_t st;
+    int exponent = fft_complex_bfp(buf, &st, &half_plan);
+
+    bfp_begin(&st, BFP_BITS_SPLIT);
+    exponent += st.shift;
+
+    /* DC and Nyquist are real: pack them into bin 0 */
+    int32_t z0r = buf[0].re, z0i = buf[0].im;
+    buf[0].re = bfp_out(&st, z0r + z0i);
+    buf[0].im = bfp_out(&st, z0r - z0i);
+
+    for (int k = 1; k <= FFT_CPX_SIZE / 2; k++) {
+        cpx16_t a = buf[k];
+        cpx16_t b = buf[FFT_CPX_SIZE - k];
+
+        // Fe = (a + conj(b)) / 2, Fo = -j * (a - conj(b)) / 2
+        cpx16_t fe = {
+            (int16_t)(((int32_t)a.re + b.re) >> 1),
+            (int16_t)(((int32_t)a.im - b.im) >> 1),
+        };
+        cpx16_t fo = {
+            (int16_t)(((int32_t)a.im + b.im) >> 1),
+            (int16_t)(((int32_t)b.re - a.re) >> 1),
+        };
+        cpx32_t t = cmul_q15(fo, fft_split_twiddles[k]);
+
+        buf[k].re = bfp_out(&st, fe.re + t.re);
+        buf[k].im = bfp_out(&st, fe.im + t.im);
+        buf[FFT_CPX_SIZE - k].re = bfp_out(&st, fe.re - t.re);
+        buf[FFT_CPX_SIZE - k].im = bfp_out(&st, t.im - fe.im);
+    }
+    return exponent;
+}
+
+/* ---------- Stereo FFT ---------- */
+
+/*
+ * With Z = FFT(l + j*r) over FFT_SIZE points, N = FFT_SIZE:
+ *   L[k] = (Z[k] + conj(Z[N-k])) / 2
+ *   R[k] = -j * (Z[k] - conj(Z[N-k])) / 2
+ * Halving the sum keeps it in int16, so no extra scaling is needed.
+ */
+int fft_stereo(cpx16_t *buf) {
+    bfp_t st;
+    int exponent = fft_complex_bfp(buf, &st, &full_plan);
+
+    // bins 0 and N/2 are real in both channels: Z already holds { L, R }
+    for (int k = 1; k < FFT_SIZE / 2; k++) {
+        cpx16_t a = buf[k];
+        cpx16_t b = buf[FFT_SIZE - k];
+
+        buf[k].re = (int16_t)(((int32_t)a.re + b.re) >> 1);
+        buf[k].im = (int16_t)(((int32_t)a.im - b.im) >> 1);
+        buf[FFT_SIZE - k].re = (int16_t)(((int32_t)a.im + b.im) >> 1);
+        buf[FFT_SIZE - k].im = (int16_t)(((int32_t)b.re - a.re) >> 1);
+    }
+    return exponent;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <stdint.h>
+#include "dsp_config.h"
+
+/* ---------- Fixed-point FFT types ---------- */
+
+typedef struct {
+    int16_t re;  // real
+    int16_t im;  // imaginary
+} cpx16_t;       // complex number 
+
+#define FFT_CPX_SIZE  (FFT_SIZE / 2)     // points in the inner complex FFT
+
+/*
+ * All transforms use block floating point: each stage is scaled down
+ * only as far as needed to rule out int16 overflow, and the function
+ * returns the block exponent, i.e. true spectrum = buf * 2^exponent.
+ * Inputs may use the full Q15 range.
+ */
+
+// In-place FFT_CPX_SIZE-point complex FFT, natural-order out
+int fft_complex(cpx16_t *buf);
+
+/*
+ * Real-input FFT of FFT_SIZE samples using one FFT_CPX_SIZE-point
+ * complex FFT plus a split post-pass.
+ *
+ * In:  buf[n] = { x[2n], x[2n+1] }, n = 0..FFT_SIZE/2-1
+ * Out: buf[k] = X[k] for k = 1..FFT_SIZE/2-1; the two purely real bins
+ *      are packed into buf[0] as { X[0], X[FFT_SIZE/2] }.
+ *
+ * Bins match a full FFT_SIZE-point complex FFT of the same input to
+ * within FFT_REAL_ERR_DB of a full-scale sine bin, even for full-scale
+ * input; host/dsp_bench fails past it.
+ */
+int fft_real(cpx16_t *buf);
+
+// Largest fft_real bin error, dB re the bin of a full-scale sine
+#define FFT_REAL_ERR_DB  (-66)
+
+/*
+ * Two real channels of FFT_SIZE samples through one FFT_SIZE-point
+ * complex FFT, separated by conjugate symmetry.
+ *
+ * In:  buf[n] = { l[n], r[n] }, n = 0..FFT_SIZE-1
+ * Out: buf[k] = L[k] and buf[FFT_SIZE-k] = R[k] for k = 1..FFT_SIZE/2-1;
+ *      buf[0] = { L[0], R[0] } and buf[FFT_SIZE/2] = { L[N/2], R[N/2] }.
+ */
+int fft_stereo(cpx16_t *buf);
@@ -0,0 +1,608 @@
+#include "dsp_fx.h"
+#include "dsp_log.h"
+#include "dsp_ramp.h"
+#include "dsp_tables.h"
+#include "dsp_time.h"
+#include "params.h"
+#include "prof.h"
+
+#include <string.h>
+
+#if FX_SLOTS != 4
+#error "prof.h and params.c list four effect slots"
+#endif
+
+#if PARAM_FX_FIELDS != FX_FIELDS + 2
+#error "params.h and dsp_fx.h disagree on the effect slot fields"
+#endif
+
+#if FX_DELAY_MAX & (FX_DELAY_MAX - 1)
+#error "FX_DELAY_MAX must be a power of two"
+#endif
+
+#define ONE_Q28       (1 << 28)
+#define ONE_Q27       (1 << 27)
+
+// 20*log10(2^15): peak amplitude dB → dBFS
+#define FS_DB_Q8      DB_Q8(90.309)
+
+// Glide of the compressor makeup gain per control period (10 ms)
+#define MAKEUP_GLIDE_Q15  ((FX_CTRL << 15) / (FX_CTRL + SAMPLE_RATE_HZ / 100))
+
+// Samples per blend of a crossfading slot (stack buffer)
+#define BLEND_CHUNK   32
+
+// Drive: the original fixed effect
+#define LP_COEFF_Q15  Q15(0.15)
+#define GAIN_Q14      19661          // 1.2 in Q14
+
+/* ---------- Module state ---------- */
+
+// Direct form I, Q27 coefficients: a +15 dB shelf with a low corner
+// needs up to 11.3, a 20 Hz corner the fraction bits. The rounding
+// error of each output is fed back through the feedback coefficients
+// rounded to integers (second-order error feedback), so the poles of a
+// low corner do not amplify it into the noise floor. A new design is reached by moving
+// the coefficients in equal steps over FX_XFADE samples; the stability
+// region of (a1, a2) is convex, so every filter on the way is stable.
+//
+// This runs in the audio ISR and the M0+ has no 32x32 -> 64 multiply,
+// so each coefficient is applied as two 32-bit products (biquad_split)
+// instead of one 64-bit one; the sum is the same. Q14 coefficients, as
+// in dsp_fb.c, would put the poles of a 20 Hz corner on the unit circle.
+typedef struct {
+    int32_t c[5];               // b0, b1, b2, a1, a2
+    int32_t to[5], step[5];     // glide to a new design
+    int32_t glide;              // samples left
+    int32_t k1, k2;             // -a1, -a2 rounded
+    int16_t x1, x2, y1, y2;
+    int32_t e1, e2;             // fractional part of the last outputs
+} fx_biquad_t;
+
+// Compressor and gate: dB-domain gain computer at the control rate
+typedef struct {
+    int32_t  thr_q8;        // threshold, dBFS Q8
+    int32_t  slope_q15;     // compressor: 1 - 1/ratio
+    int32_t  makeup_to;     // dB Q16
+    int32_t  range_q8;      // gate: attenuation when closed
+    int32_t  att_q16;       // smoothing per control period
+    int32_t  rel_q16;
+    uint32_t hold;          // gate: control periods
+
+    int32_t  peak;          // |x| over this control period
+    int32_t  red_q16;       // gain reduction now, dB Q16
+    int32_t  makeup_q16;    // gliding to makeup_to
+    uint32_t held;
+    int32_t  gain_q17;      // Q14 gain << 3, ramping by step per sample
+    int32_t  step;
+    int      ctr;           // samples to the next control update
+} fx_dyn_t;
+
+// A new time crossfades from the old tap to the new one; feedback and
+// echo level ramp
+typedef struct {
+    uint32_t   len, old_len;
+    dsp_ramp_t tap;         // 0 = old tap, 32768 = new
+    dsp_ramp_t fb;
+    dsp_ramp_t level;
+    uint32_t   pos;
+} fx_delay_t;
+
+typedef struct {
+    fx_config_t cfg;
+    union {
+        fx_biquad_t bq;
+        fx_dyn_t    dyn;
+        fx_delay_t  dly;
+        int32_t     lp;     // drive, Q15
+    } s;
+    dsp_ramp_t  amount;     // 32768 = module in, 0 = bypassed
+    fx_config_t pending;    // a new module, once this one has faded out
+    bool        has_pending;
+    uint32_t ticks;         // since the last dsp_fx_record_costs
+    bool     ran;
+} fx_slot_t;
+
+static fx_slot_t slots[FX_SLOTS];
+static int16_t delay_lines[FX_SLOTS][FX_DELAY_MAX];
+
+// Raw parameter values each slot was last configured from
+static fx_config_t requested[FX_SLOTS];
+
+static const fx_config_t default_slot0 = { .type = FX_DRIVE };
+
+/* ---------- Helpers ---------- */
+
+static inline int32_t clamp(int32_t v, int32_t lo, int32_t hi) {
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+static inline int16_t sat16(int32_t v) {
+    return (int16_t)clamp(v, -32768, 32767);
+}
+
+static bool same_config(const fx_config_t *a, const fx_config_t *b) {
+    if (a->type != b->type || a->bypass != b->bypass) return false;
+    for (int i = 0; i < FX_FIELDS; i++)
+        if (a->f[i] != b->f[i]) return false;
+    return true;
+}
+
+// sin of ph/2^32 turns, ph up to 2^31 (pi), Q30
+static int64_t sin_q30(uint32_t ph) {
+    if (ph > 1u << 30) ph = (1u << 31) - ph;
+    uint32_t idx  = ph >> 22;
+    uint32_t frac = ph & 0x3FFFFF;
+    int64_t lo = dsp_sine_q30[idx];
+    if (!frac) return lo;
+    return lo + (((dsp_sine_q30[idx + 1] - lo) * frac + (1 << 21)) >> 22);
+}
+
+// One-pole smoothing per control period for a time constant in ms:
+// 1 - exp(-FX_CTRL / (fs * ms / 1000)), Q16. Slow ones come from the
+// series, where the Q10 exponent of exp2_q16 would be too coarse.
+static int32_t smoothing_q16(int32_t ms) {
+    if (ms <= 0) return 1 << 16;
+    uint64_t x = ((uint64_t)FX_CTRL * 1000 << 24) / ((uint64_t)SAMPLE_RATE_HZ * (uint32_t)ms);
+    if (x < 1 << 22) {
+        uint64_t x2 = (x * x) >> 24, x3 = (x2 * x) >> 24;
+        return (int32_t)((x - x2 / 2 + x3 / 6 + (1 << 7)) >> 8);
+    }
+    uint32_t l = (uint32_t)((x * 94548) >> 30);         // x / ln 2, Q10
+    if (l > 17 << 10) return 1 << 16;
+    return (1 << 16) - (int32_t)exp2_q16(-(int32_t)l);
+}
+
+/* ---------- Biquad EQ (RBJ cookbook, integer design) ---------- */
+
+static void biquad_design(int32_t *c, const int32_t *p) {
+    uint32_t ph = (uint32_t)(((uint64_t)p[1] << 32) / SAMPLE_RATE_HZ);
+    int64_t sn  = sin_q30(ph) >> 2;                     // sin w0, Q28
+    int64_t sh  = sin_q30(ph >> 1);                     // sin w0/2, Q30
+    int64_t omc = (sh * sh) >> 31;                      // 1 - cos w0 = 2 sin^2(w0/2)
+    int64_t cs  = ONE_Q28 - omc;
+    int64_t alpha = sn * 50 / p[2];                     // sin w0 / 2Q
+    int32_t db_q8 = p[3] * 256 / 10;
+    int64_t A   = (int64_t)db_gain_q14(db_q8 / 2) << 14;         // 10^(dB/40)
+    int64_t sA2 = (((int64_t)db_gain_q14(db_q8 / 4) << 14) * alpha) >> 27;  // 2 sqrt(A) alpha
+    int64_t b0, b1, b2, a0, a1, a2;
+
+    switch ((fx_eq_t)p[0]) {
+        case FX_EQ_HIGHPASS:
+            b0 = (2 * ONE_Q28 - omc) / 2;  b1 = -(2 * ONE_Q28 - omc);  b2 = b0;
+            a0 = ONE_Q28 + alpha;  a1 = -2 * cs;  a2 = ONE_Q28 - alpha;
+            break;
+        case FX_EQ_PEAK: {
+            int64_t aA = (alpha * A) >> 28, a_A = (alpha << 28) / A;
+            b0 = ONE_Q28 + aA;  b1 = -2 * cs;  b2 = ONE_Q28 - aA;
+            a0 = ONE_Q28 + a_A;  a1 = -2 * cs;  a2 = ONE_Q28 - a_A;
+            break;
+        }
+        case FX_EQ_LOW_SHELF:
+        case FX_EQ_HIGH_SHELF: {
+            int64_t ap = A + ONE_Q28, am = A - ONE_Q28;
+            int64_t apc = (ap * cs) >> 28, amc = (am * cs) >> 28;
+            int sign = p[0] == FX_EQ_LOW_SHELF ? 1 : -1;
+            b0 = (A * (ap - sign * amc + sA2)) >> 28;
+            b1 = sign * ((2 * A * (am - sign * apc)) >> 28);
+            b2 = (A * (ap - sign * amc - sA2)) >> 28;
+            a0 = ap + sign * amc + sA2;
+            a1 = -sign * 2 * (am + sign * apc);
+            a2 = ap + sign * amc - sA2;
+            break;
+        }
+        default:    // low-pass
+            b0 = omc / 2;  b1 = omc;  b2 = b0;
+            a0 = ONE_Q28 + alpha;  a1 = -2 * cs;  a2 = ONE_Q28 - alpha;
+            break;
+    }
+
+    c[0] = (int32_t)((b0 * ONE_Q27 + a0 / 2) / a0);
+    c[1] = (int32_t)((b1 * ONE_Q27 + (b1 < 0 ? -a0 : a0) / 2) / a0);
+    c[2] = (int32_t)((b2 * ONE_Q27 + a0 / 2) / a0);
+    c[3] = (int32_t)((a1 * ONE_Q27 + (a1 < 0 ? -a0 : a0) / 2) / a0);
+    c[4] = (int32_t)((a2 * ONE_Q27 + (a2 < 0 ? -a0 : a0) / 2) / a0);
+}
+
+static void biquad_tune(fx_biquad_t *f, const int32_t *p, bool glide) {
+    int32_t c[5];
+    biquad_design(c, p);
+    f->k1 = -((c[3] + (1 << 26)) >> 27);
+    f->k2 = -((c[4] + (1 << 26)) >> 27);
+
+    f->glide = glide ? FX_XFADE : 0;
+    for (int j = 0; j < 5; j++) {
+        f->to[j] = c[j];
+        f->step[j] = (int32_t)(((int64_t)c[j] - f->c[j]) / FX_XFADE);
+        if (!glide) f->c[j] = c[j];
+    }
+}
+
+// c = hi * 2^16 + lo with lo in (-2^15, 2^15], so lo times a sample is
+// in [-2^30, 2^30) and two of them still fit 32 bits
+static inline void biquad_split(const int32_t *c, int32_t *hi, int32_t *lo) {
+    for (int j = 0; j < 5; j++) {
+        int32_t m = c[j] - 1;
+        hi[j] = (m >> 16) + ((m >> 15) & 1);
+        lo[j] = c[j] - hi[j] * (1 << 16);
+    }
+}
+
+static void biquad_run(fx_biquad_t *f, int16_t *buf, int n) {
+    int32_t hi[5], lo[5];
+    biquad_split(f->c, hi, lo);
+
+    for (int i = 0; i < n; i++) {
+        if (f->glide) {
+            bool last = --f->glide == 0;
+            for (int j = 0; j < 5; j++)
+                f->c[j] = last ? f->to[j] : f->c[j] + f->step[j];
+            biquad_split(f->c, hi, lo);
+        }
+
+        // The Q27 sum as h * 2^16 + r, 32-bit products only: h adds the
+        // high parts (below 26 * 2^26, the largest sum of |c| being
+        // 25.5), and the low parts and the error feedback carry into it
+        int32_t x = buf[i];
+        int32_t h = hi[0] * x + hi[1] * f->x1 + hi[2] * f->x2
+                  - hi[3] * f->y1 - hi[4] * f->y2;
+        int32_t lx = lo[0] * x + lo[1] * f->x1;
+        int32_t lx2 = lo[2] * f->x2;
+        int32_t ly = lo[3] * f->y1 + lo[4] * f->y2;
+        int32_t r = (lx & 0xFFFF) + (lx2 & 0xFFFF) - (ly & 0xFFFF)
+                  + f->k1 * f->e1 + f->k2 * f->e2;
+        h += (lx >> 16) + (lx2 >> 16) - (ly >> 16) + (r >> 16);
+        r &= 0xFFFF;
+
+        int32_t y = h >> 11;
+        int32_t e = (h & 0x7FF) << 16 | r;
+        if (y > 32767 || y < -32768) {
+            y = sat16(y);
+            e = 0;
+        }
+        f->e2 = f->e1;
+        f->e1 = e;
+
+        f->x2 = f->x1;
+        f->x1 = (int16_t)x;
+        f->y2 = f->y1;
+        f->y1 = (int16_t)y;
+        buf[i] = (int16_t)y;
+    }
+}
+
+/* ---------- Compressor / limiter and gate ---------- */
+
+static void dyn_update(fx_dyn_t *d, fx_type_t type) {
+    int32_t level = d->peak ? power_db_q8((uint64_t)d->peak * (uint64_t)d->peak, 0) - FS_DB_Q8
+                            : DB_FLOOR_Q8;
+    int32_t target, coef, gain_db_q8;
+    d->peak = 0;
+
+    // target reduction in dB Q16
+    if (type == FX_COMPRESSOR) {
+        int32_t over = level - d->thr_q8;
+        target = over > 0 ? (over * d->slope_q15) >> 7 : 0;
+        coef = target > d->red_q16 ? d->att_q16 : d->rel_q16;
+    } else {
+        if (level >= d->thr_q8) d->held = d->hold;
+        target = 0;
+        if (level < d->thr_q8) {
+            if (d->held) d->held--;
+            else target = d->range_q8 << 8;
+        }
+        coef = target < d->red_q16 ? d->att_q16 : d->rel_q16;
+    }
+
+    d->red_q16 += (int32_t)(((int64_t)(target - d->red_q16) * coef + (1 << 15)) >> 16);
+    d->makeup_q16 += ((d->makeup_to - d->makeup_q16) * MAKEUP_GLIDE_Q15 + (1 << 14)) >> 15;
+    gain_db_q8 = (d->makeup_q16 - d->red_q16 + (1 << 7)) >> 8;
+
+    // ramp to the new gain over the next control period
+    d->step = (int32_t)db_gain_q14(gain_db_q8) - (d->gain_q17 >> 3);
+    d->ctr = FX_CTRL;
+}
+
+static void dyn_run(fx_dyn_t *d, fx_type_t type, int16_t *buf, int n) {
+    for (int i = 0; i < n; i++) {
+        int32_t x = buf[i];
+        int32_t a = x < 0 ? -x : x;
+        if (a > d->peak) d->peak = a;
+
+        d->gain_q17 += d->step;
+        buf[i] = sat16((x * (d->gain_q17 >> 3) + (1 << 13)) >> 14);
+
+        if (--d->ctr == 0) dyn_update(d, type);
+    }
+}
+
+// Threshold, ratio, range and times act through the smoothed gain
+// reduction; only the makeup gain needs a glide of its own
+static void dyn_tune(fx_dyn_t *d, fx_type_t type, const int32_t *p, bool glide) {
+    d->thr_q8 = p[0] * 256 / 10;
+    if (type == FX_COMPRESSOR) {
+        d->slope_q15 = p[1] ? 32768 - 32768 * 10 / p[1] : 32768;
+        d->makeup_to = (p[4] << 16) / 10;
+        if (!glide) d->makeup_q16 = d->makeup_to;
+    } else {
+        d->range_q8 = p[1] * 256 / 10;
+        d->hold = (uint32_t)((uint64_t)p[4] * SAMPLE_RATE_HZ / (1000u * FX_CTRL));
+    }
+    d->att_q16 = smoothing_q16(p[2]);
+    d->rel_q16 = smoothing_q16(p[3]);
+}
+
+/* ---------- Delay / echo ---------- */
+
+static void delay_tune(fx_delay_t *d, const int32_t *p, bool glide) {
+    uint32_t len = (uint32_t)((uint64_t)p[0] * SAMPLE_RATE_HZ / 1000);
+
+    if (!glide) {
+        d->len = d->old_len = len;
+        dsp_ramp_set(&d->tap, 32768);
+        dsp_ramp_set(&d->fb, p[1]);
+        dsp_ramp_set(&d->level, p[2]);
+        return;
+    }
+    if (len != d->len) {
+        // mid-crossfade, carry on from whichever tap is louder
+        if (dsp_ramp_value(&d->tap) < 16384) d->len = d->old_len;
+        d->old_len = d->len;
+        d->len = len;
+        dsp_ramp_set(&d->tap, 0);
+        dsp_ramp_to(&d->tap, 32768, FX_XFADE);
+    }
+    if (p[1] != d->fb.target) dsp_ramp_to(&d->fb, p[1], FX_XFADE);
+    if (p[2] != d->level.target) dsp_ramp_to(&d->level, p[2], FX_XFADE);
+}
+
+static void delay_run(fx_delay_t *d, int16_t *line, int16_t *buf, int n) {
+    const uint32_t mask = FX_DELAY_MAX - 1;
+
+    for (int i = 0; i < n; i++) {
+        int32_t x = buf[i];
+        int32_t e = line[(d->pos - d->len) & mask];
+        int32_t fb = dsp_ramp_next(&d->fb), level = dsp_ramp_next(&d->level);
+
+        if (dsp_ramp_active(&d->tap) || d->old_len != d->len) {
+            int32_t old = line[(d->pos - d->old_len) & mask];
+            int32_t t = dsp_ramp_next(&d->tap);
+            e = old + (((e - old) * (t >> 1) + (1 << 13)) >> 14);
+            if (!dsp_ramp_active(&d->tap)) d->old_len = d->len;
+        }
+
+        buf[i] = sat16(x + ((e * level + (1 << 14)) >> 15));
+        line[d->pos] = sat16(x + ((e * fb + (1 << 14)) >> 15));
+        d->pos = (d->pos + 1) & mask;
+    }
+}
+
+/* ---------- Drive ---------- */
+
+// x / (1 + |x|), x in Q15, interpolated from a 1/32-step table over
+// |x| < 4 (saturates at 0.8 beyond that)
+static inline int32_t soft_clip(int32_t x) {
+    uint32_t a = (uint32_t)(x < 0 ? -x : x);
+    if (a >= 4u << 15) a = (4u << 15) - 1;
+
+    uint32_t idx  = a >> 10;             // 1/32 steps
+    uint32_t frac = a & 1023;
+    int32_t lo = dsp_softclip_lut[idx];
+    int32_t y  = lo + (((dsp_softclip_lut[idx + 1] - lo) * (int32_t)frac) >> 10);
+
+    return x < 0 ? -y : y;
+}
+
+// Kept in int32 between stages, since the gain can push past 1.0
+static void drive_run(int32_t *lp, int16_t *buf, int n) {
+    for (int i = 0; i < n; i++) {
+        int32_t g = ((int32_t)buf[i] * GAIN_Q14) >> 14;
+        *lp += ((g - *lp) * LP_COEFF_Q15 + (1 << 14)) >> 15;
+        buf[i] = (int16_t)soft_clip(*lp);
+    }
+}
+
+/* ---------- Chain ---------- */
+
+static void clamp_config(fx_config_t *c) {
+    int32_t *p = c->f;
+
+    if ((unsigned)c->type >= FX_TYPE_COUNT) c->type = FX_NONE;
+    switch (c->type) {
+        case FX_BIQUAD:
+            p[0] = clamp(p[0], 0, FX_EQ_COUNT - 1);
+            p[1] = clamp(p[1], 20, SAMPLE_RATE_HZ * 45 / 100);
+            p[2] = clamp(p[2], 30, 1000);
+            p[3] = clamp(p[3], -150, 150);
+            p[4] = 0;
+            break;
+        case FX_COMPRESSOR:
+            p[0] = clamp(p[0], -600, 0);
+            p[1] = p[1] <= 0 ? 0 : clamp(p[1], 10, 200);
+            p[2] = clamp(p[2], 0, 500);
+            p[3] = clamp(p[3], 1, 5000);
+            p[4] = clamp(p[4], 0, 120);
+            break;
+        case FX_GATE:
+            p[0] = clamp(p[0], -800, 0);
+            p[1] = clamp(p[1], 0, 800);
+            p[2] = clamp(p[2], 0, 500);
+            p[3] = clamp(p[3], 1, 5000);
+            p[4] = clamp(p[4], 0, 2000);
+            break;
+        case FX_DELAY:
+            p[0] = clamp(p[0], 1, (int32_t)((FX_DELAY_MAX - 1) * 1000ull / SAMPLE_RATE_HZ));
+            p[1] = clamp(p[1], 0, Q15(0.95));
+            p[2] = clamp(p[2], 0, 32767);
+            p[3] = p[4] = 0;
+            break;
+        default:
+            memset(p, 0, sizeof(c->f));
+            break;
+    }
+}
+
+// Amount a slot should sit at with this configuration
+static int32_t slot_on(const fx_config_t *c) {
+    return c->bypass || c->type == FX_NONE ? 0 : 32768;
+}
+
+// Put a clamped configuration into the slot's module. A new module
+// starts from silence; the same one keeps its state and, with glide,
+// moves to the new settings over FX_XFADE samples.
+static void apply(int slot, const fx_config_t *c, bool glide) {
+    fx_slot_t *sl = &slots[slot];
+
+    if (c->type != sl->cfg.type) {
+        memset(&sl->s, 0, sizeof(sl->s));
+        if (c->type == FX_COMPRESSOR || c->type == FX_GATE) {
+            sl->s.dyn.gain_q17 = 16384 << 3;
+            sl->s.dyn.ctr = FX_CTRL;
+        }
+        if (c->type == FX_DELAY) memset(delay_lines[slot], 0, sizeof(delay_lines[slot]));
+        glide = false;
+    }
+
+    switch (c->type) {
+        case FX_BIQUAD:
+            biquad_tune(&sl->s.bq, c->f, glide);
+            break;
+        case FX_COMPRESSOR:
+        case FX_GATE:
+            dyn_tune(&sl->s.dyn, c->type, c->f, glide);
+            break;
+        case FX_DELAY:
+            delay_tune(&sl->s.dly, c->f, glide);
+            break;
+        default:
+            break;
+    }
+    sl->cfg = *c;
+}
+
+void dsp_fx_init(void) {
+    static const fx_config_t none = { .type = FX_NONE };
+
+    memset(slots, 0, sizeof(slots));
+    for (int s = 0; s < FX_SLOTS; s++) {
+        requested[s] = s == 0 ? default_slot0 : none;
+        dsp_fx_configure(s, &requested[s]);
+    }
+}
+
+void dsp_fx_configure(int slot, const fx_config_t *cfg) {
+    if ((unsigned)slot >= FX_SLOTS) return;
+    fx_slot_t *sl = &slots[slot];
+    fx_config_t c = *cfg;
+
+    clamp_config(&c);
+    apply(slot, &c, false);
+    sl->has_pending = false;
+    dsp_ramp_set(&sl->amount, slot_on(&c));
+}
+
+void dsp_fx_update(int slot, const fx_config_t *cfg) {
+    if ((unsigned)slot >= FX_SLOTS) return;
+    fx_slot_t *sl = &slots[slot];
+    fx_config_t c = *cfg;
+    clamp_config(&c);
+
+    // Another module: fade this one out first, unless it is silent
+    if (c.type != sl->cfg.type) {
+        if (dsp_ramp_value(&sl->amount) == 0 && !dsp_ramp_active(&sl->amount)) {
+            apply(slot, &c, false);
+            sl->has_pending = false;
+            if (slot_on(&c)) dsp_ramp_to(&sl->amount, slot_on(&c), FX_XFADE);
+        } else {
+            sl->pending = c;
+            sl->has_pending = true;
+            if (sl->amount.target != 0) dsp_ramp_to(&sl->amount, 0, FX_XFADE);
+        }
+        return;
+    }
+
+    sl->has_pending = false;
+    apply(slot, &c, true);
+    if (slot_on(&c) != sl->amount.target) dsp_ramp_to(&sl->amount, slot_on(&c), FX_XFADE);
+}
+
+const fx_config_t *dsp_fx_config(int slot) {
+    return &slots[(unsigned)slot < FX_SLOTS ? slot : 0].cfg;
+}
+
+void dsp_fx_sync_params(const param_snapshot_t *p) {
+    for (int s = 0; s < FX_SLOTS; s++) {
+        fx_config_t c;
+        c.type = (fx_type_t)p->v[PARAM_FX(s, PARAM_FX_TYPE)];
+        c.bypass = p->v[PARAM_FX(s, PARAM_FX_BYPASS)] != 0;
+        for (int i = 0; i < FX_FIELDS; i++)
+            c.f[i] = p->v[PARAM_FX(s, PARAM_FX_A + i)];
+
+        if (!same_config(&c, &requested[s])) {
+            requested[s] = c;
+            dsp_fx_update(s, &c);
+        }
+    }
+}
+
+static void run_module(int slot, int16_t *buf, int n) {
+    fx_slot_t *sl = &slots[slot];
+
+    switch (sl->cfg.type) {
+        case FX_BIQUAD:     biquad_run(&sl->s.bq, buf, n);                   break;
+        case FX_COMPRESSOR:
+        case FX_GATE:       dyn_run(&sl->s.dyn, sl->cfg.type, buf, n);       break;
+        case FX_DELAY:      delay_run(&sl->s.dly, delay_lines[slot], buf, n); break;
+        case FX_DRIVE:      drive_run(&sl->s.lp, buf, n);                    break;
+        default: break;
+    }
+}
+
+// Module output faded against its input by the slot's amount ramp
+static void run_blended(int slot, int16_t *buf, int n) {
+    dsp_ramp_t *amount = &slots[slot].amount;
+
+    for (int base = 0; base < n; base += BLEND_CHUNK) {
+        int16_t dry[BLEND_CHUNK];
+        int len = n - base < BLEND_CHUNK ? n - base : BLEND_CHUNK;
+        int16_t *b = buf + base;
+
+        memcpy(dry, b, (size_t)len * sizeof(dry[0]));
+        run_module(slot, b, len);
+        for (int i = 0; i < len; i++) {
+            int32_t a = dsp_ramp_next(amount) >> 1;     // Q14, so the product fits
+            b[i] = (int16_t)(dry[i] + (((b[i] - dry[i]) * a + (1 << 13)) >> 14));
+        }
+    }
+}
+
+void dsp_fx_process(int16_t *buf, int n) {
+    for (int s = 0; s < FX_SLOTS; s++) {
+        fx_slot_t *sl = &slots[s];
+        bool fading = dsp_ramp_active(&sl->amount);
+
+        if (!fading && dsp_ramp_value(&sl->amount) == 0) {
+            // silent: the place to switch modules
+            if (sl->has_pending) dsp_fx_update(s, &sl->pending);
+            fading = dsp_ramp_active(&sl->amount);
+            if (!fading) continue;
+        }
+
+        PROF_START(t);
+        if (fading) run_blended(s, buf, n);
+        else run_module(s, buf, n);
+#if PROF_ENABLE
+        sl->ticks += (prof_now() - t) & prof_clock_mask();
+#endif
+        sl->ran = true;
+    }
+}
+
+void dsp_fx_record_costs(void) {
+    for (int s = 0; s < FX_SLOTS; s++) {
+        if (!slots[s].ran) continue;
+        PROF_RECORD((prof_stage_t)(PROF_FX0 + s), slots[s].ticks);
+        slots[s].ticks = 0;
+        slots[s].ran = false;
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "dsp_config.h"
+#include "params.h"
+
+/*
+ * Effect chain: FX_SLOTS slots run in order on Q15 blocks, in place.
+ * Each slot holds one module (or nothing) with its own bypass, and is
+ * reconfigured at runtime without allocation: the delay lines are
+ * static, one per slot. dsp_time_process() runs the chain as its wet
+ * path; with the default configuration (the drive in slot 0, the rest
+ * empty) that is the original fixed effect.
+ *
+ * Module fields, all integers:
+ *   FX_BIQUAD      a fx_eq_t shape, b Hz, c Q x 100, d gain dB x 10
+ *                  (peak and shelves, +-15 dB)
+ *   FX_COMPRESSOR  a threshold dBFS x 10, b ratio x 10 (0 = limiter),
+ *                  c attack ms, d release ms, e makeup dB x 10 (0..12 dB)
+ *   FX_GATE        a threshold dBFS x 10, b range dB x 10, c attack ms,
+ *                  d release ms, e hold ms
+ *   FX_DELAY       a time ms (up to FX_DELAY_MAX samples), b feedback
+ *                  Q15 (up to 0.95), c echo level Q15
+ *   FX_DRIVE       gain 1.2 → one-pole low-pass → soft clip (no fields)
+ * Out-of-range fields are clamped when the slot is configured.
+ *
+ * The compressor and gate measure the peak over FX_CTRL samples and
+ * work out their gain in dB once per FX_CTRL samples, ramping to it
+ * linearly over the next FX_CTRL.
+ *
+ * Live changes (dsp_fx_update()) never step: a slot's bypass
+ * crossfades over FX_XFADE samples, a new module only goes in once
+ * the old one has faded out, biquad coefficients glide to a new design
+ * over FX_XFADE samples, the echo crossfades to a new delay time and
+ * ramps its levels, and the compressor makeup gain glides.
+ */
+
+typedef enum {
+    FX_NONE,
+    FX_BIQUAD,
+    FX_COMPRESSOR,
+    FX_GATE,
+    FX_DELAY,
+    FX_DRIVE,
+    FX_TYPE_COUNT
+} fx_type_t;
+
+typedef enum {
+    FX_EQ_LOWPASS,
+    FX_EQ_HIGHPASS,
+    FX_EQ_PEAK,
+    FX_EQ_LOW_SHELF,
+    FX_EQ_HIGH_SHELF,
+    FX_EQ_COUNT
+} fx_eq_t;
+
+#define FX_FIELDS  5
+
+typedef struct {
+    fx_type_t type;
+    bool      bypass;
+    int32_t   f[FX_FIELDS];     // a..e, meaning per type (see above)
+} fx_config_t;
+
+// Delay line per slot, in samples (186 ms at 44.1 kHz); FX_SLOTS of
+// them are static SRAM
+#ifndef FX_DELAY_MAX
+#define FX_DELAY_MAX  8192
+#endif
+
+// Control period of the compressor and gate, in samples
+#define FX_CTRL  8
+
+// Crossfade and glide length for live changes, in samples (5 ms)
+#define FX_XFADE  (SAMPLE_RATE_HZ / 200)
+
+// Default chain and cleared state
+void dsp_fx_init(void);
+
+// Configure one slot, taking effect at once: coefficients and times
+// are worked out here, integer only. Keeps the module's state if the
+// type is unchanged. Call on the core running the chain.
+void dsp_fx_configure(int slot, const fx_config_t *cfg);
+
+// The same for a slot that is playing: crossfades and glides to the
+// new configuration (see above)
+void dsp_fx_update(int slot, const fx_config_t *cfg);
+
+// Current configuration of a slot (as clamped)
+const fx_config_t *dsp_fx_config(int slot);
+
+// Update any slot whose fxN_* parameters changed in the snapshot
+void dsp_fx_sync_params(const param_snapshot_t *p);
+
+// n Q15 samples through every active slot, in place
+void dsp_fx_process(int16_t *buf, int n);
+
+// Record the ticks each active slot took since the last call as one
+// run of its PROF_FX* stage (prof.h): once per audio block
+void dsp_fx_record_costs(void);
@@ -0,0 +1,55 @@
+#include "dsp_hop.h"
+
+// Share of the hop period one window may take before the hop grows,
+// and the share it must fit in at the smaller hop before it shrinks
+#define HOP_HIGH_PCT 75
+#define HOP_LOW_PCT  50
+
+#define HOP_MAX_SHIFT 2
+
+void dsp_hop_init(dsp_hop_t *h, uint32_t window_ticks) {
+    h->window_ticks = window_ticks;
+    h->cost = 0;
+    h->shift = 0;
+}
+
+// Smallest shift with at least one window per display frame
+static uint8_t frame_shift(void) {
+    const uint32_t frame = SAMPLE_RATE_HZ / ANALYSIS_FRAME_HZ;
+    uint8_t s = 0;
+    while (s < HOP_MAX_SHIFT && (uint32_t)(FFT_SIZE >> s) > frame) s++;
+    return s;
+}
+
+// Share of the hop period (FFT_SIZE >> shift) that cost takes, in %
+static uint32_t load_pct(const dsp_hop_t *h, uint32_t cost, uint8_t shift) {
+    return (uint32_t)(((uint64_t)cost * 100u << shift) / h->window_ticks);
+}
+
+uint32_t dsp_hop_next(dsp_hop_t *h, uint32_t cost, dsp_window_t window,
+                      uint32_t fixed) {
+    if (cost >= h->cost) h->cost = cost;
+    else h->cost -= (h->cost - cost) >> 4;
+
+    if (fixed) {
+        if (fixed < DSP_HOP_MIN) fixed = DSP_HOP_MIN;
+        if (fixed > FFT_SIZE) fixed = FFT_SIZE;
+        return fixed;
+    }
+
+    uint8_t target = window == DSP_WINDOW_RECT ? 0
+                   : window == DSP_WINDOW_BLACKMAN ? 2 : 1;
+    uint8_t fs = frame_shift();
+    if (fs > target) target = fs;
+
+    if (h->shift > target || !h->window_ticks) {
+        h->shift = target;      // no clock: nothing to back off for
+    } else {
+        if (h->shift > 0 && load_pct(h, h->cost, h->shift) > HOP_HIGH_PCT)
+            h->shift--;
+        else if (h->shift < target &&
+                 load_pct(h, h->cost, h->shift + 1) <= HOP_LOW_PCT)
+            h->shift++;
+    }
+    return FFT_SIZE >> h->shift;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+#include "dsp.h"
+#include "dsp_config.h"
+
+/*
+ * STFT hop size: how far apart the overlapping analysis windows start.
+ *
+ * The hop is FFT_SIZE, FFT_SIZE/2 or FFT_SIZE/4. The controller aims
+ * for the smallest hop that is still needed: enough overlap for the
+ * window's taper (50% for Hann, 75% for Blackman, so no stretch of
+ * input is seen only at low weight) and at least one new window per
+ * display frame (ANALYSIS_FRAME_HZ). When the measured cost per window
+ * leaves too little headroom at that hop, it backs off to a larger
+ * one, and it comes back once there is room again.
+ *
+ * It backs off when a window takes more than 75% of the current hop
+ * period, and steps down only when a window would take at most 50% of
+ * the smaller hop's period: at most 25% of the current one, since the
+ * hop halves. A window that costs 30% of FFT_SIZE samples stays at
+ * FFT_SIZE; 50% and 75% overlap need 25% and 12.5% or less.
+ */
+
+#define DSP_HOP_MIN (FFT_SIZE / 4)
+
+typedef struct {
+    uint32_t window_ticks;  // FFT_SIZE sample periods, in cost units
+    uint32_t cost;          // per window: follows rises at once, falls slowly
+    uint8_t  shift;         // hop = FFT_SIZE >> shift
+} dsp_hop_t;
+
+// Costs are given in any clock unit; window_ticks is FFT_SIZE sample
+// periods in that unit (0: no clock, always use the target hop)
+void dsp_hop_init(dsp_hop_t *h, uint32_t window_ticks);
+
+// Hop for the next window, given what the last one cost (0 = none).
+// fixed = 0 adapts; anything else is used as the hop, clamped to
+// DSP_HOP_MIN..FFT_SIZE.
+uint32_t dsp_hop_next(dsp_hop_t *h, uint32_t cost, dsp_window_t window,
+                      uint32_t fixed);
@@ -0,0 +1,70 @@
+#include "dsp_log.h"
+#include "dsp_tables.h"
+
+/*
+ * Fixed-point logarithms for the analysis path (no soft-float).
+ *
+ * log2 is split into the MSB position (integer part) and the fraction
+ * log2(1.m), read from the 33-entry dsp_log2_frac table with linear
+ * interpolation on the next 10 mantissa bits. Worst-case error is about
+ * 2e-4 octave, i.e. well below 0.01 dB. exp2 is the same the other way
+ * round, from dsp_exp2_frac.
+ */
+
+// 10*log10(2) * 256 / 1024 in Q16: Q10 log2 → Q8 dB
+#define LOG2_Q10_TO_DB_Q8  49321u
+
+// 1024 / 256 / (20*log10(2)) in Q16: Q8 amplitude dB → Q10 log2
+#define DB_Q8_TO_LOG2_Q10  43541
+
+uint32_t log2_q10(uint64_t x) {
+    if (!x) return 0;
+
+    /* Reduce to 32 bits, remembering the shift */
+    uint32_t e = 0;
+    uint32_t hi = (uint32_t)(x >> 32);
+    while (hi) { hi >>= 1; e++; }
+    uint32_t v = (uint32_t)(x >> e);
+
+    /* MSB position by binary search (no CLZ on the M0+) */
+    uint32_t msb = 0;
+    if ((v >> msb) >= 1u << 16) msb += 16;
+    if ((v >> msb) >= 1u << 8)  msb += 8;
+    if ((v >> msb) >= 1u << 4)  msb += 4;
+    if ((v >> msb) >= 1u << 2)  msb += 2;
+    if ((v >> msb) >= 1u << 1)  msb += 1;
+
+    /* v = 1.f in Q31: 5 index bits, 10 interpolation bits */
+    v <<= 31 - msb;
+    uint32_t idx  = (v >> 26) & 31;
+    uint32_t frac = (v >> 16) & 1023;
+    uint32_t lo   = dsp_log2_frac[idx];
+    uint32_t l15  = lo + (((dsp_log2_frac[idx + 1] - lo) * frac) >> 10);
+
+    return ((e + msb) << 10) + (l15 >> 5);
+}
+
+int32_t power_db_q8(uint64_t power, int exponent) {
+    uint32_t l = log2_q10(power) + ((uint32_t)(2 * exponent) << 10);
+    return (int32_t)((l * LOG2_Q10_TO_DB_Q8) >> 16);
+}
+
+uint32_t exp2_q16(int32_t x) {
+    int32_t e = x >> 10;                    // floor
+    uint32_t f = (uint32_t)x & 1023;
+    if (e > 14) return UINT32_MAX;
+    if (e < -17) return 0;
+
+    /* 2^(f/1024) in Q14: 5 index bits, 5 interpolation bits */
+    uint32_t idx = f >> 5;
+    uint32_t lo  = dsp_exp2_frac[idx];
+    uint32_t m   = lo + (((dsp_exp2_frac[idx + 1] - lo) * (f & 31) + 16) >> 5);
+
+    // Q14 mantissa → Q16, times 2^e, rounded
+    if (e >= -2) return m << (e + 2);
+    return (m + (1u << (-e - 3))) >> (-e - 2);
+}
+
+uint32_t db_gain_q14(int32_t db_q8) {
+    return (exp2_q16((db_q8 * DB_Q8_TO_LOG2_Q10 + (1 << 15)) >> 16) + 2) >> 2;
+}
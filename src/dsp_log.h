@@ -0,0 +1,24 @@
+#pragma once
+#include <stdint.h>
+
+// dB values are Q8 (1/256 dB) throughout the analysis path
+#define DB_Q8(db)        ((int32_t)((db) * 256))
+
+// Level reported for an all-zero band
+#define DB_FLOOR_Q8      DB_Q8(-120)
+
+// log2(x) in Q10, integer only (x = 0 returns 0)
+uint32_t log2_q10(uint64_t x);
+
+// 2^(x / 1024) in Q16, integer only: the inverse of log2_q10. Saturates
+// above x = 15 << 10.
+uint32_t exp2_q16(int32_t x_q10);
+
+// Amplitude gain of a dB value in Q14 (0 dB = 16384), for the effect
+// chain; up to +12 dB fits 16 bits
+uint32_t db_gain_q14(int32_t db_q8);
+
+// 10*log10(power * 2^(2*exponent)) in Q8, i.e. the dB of a power sum
+// taken from a block-floating-point spectrum with that block exponent.
+// power must be non-zero.
+int32_t power_db_q8(uint64_t power, int exponent);
@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Per-sample parameter ramps for the audio path, so a new value never
+ * lands as a step. A ramp holds a Q15-range value (|v| <= 32768) with
+ * 15 more fraction bits and walks it to its target in equal steps:
+ *
+ *   dsp_ramp_to()     linearly over n samples
+ *   dsp_ramp_glide()  exponentially: each call (once per block) aims a
+ *                     linear segment over the block a fraction k of the
+ *                     way to the target, so the value follows a
+ *                     one-pole curve made of per-block line segments
+ *
+ * Between targets a ramp costs one test per sample.
+ */
+
+#define DSP_RAMP_FRAC  15
+
+typedef struct {
+    int32_t value;      // current, Q15 value << DSP_RAMP_FRAC
+    int32_t step;
+    int32_t target;     // where this segment lands, Q15 value
+    int32_t left;       // samples until it lands
+} dsp_ramp_t;
+
+// Jump straight to v
+static inline void dsp_ramp_set(dsp_ramp_t *r, int32_t v) {
+    r->value = v << DSP_RAMP_FRAC;
+    r->target = v;
+    r->step = 0;
+    r->left = 0;
+}
+
+static inline int32_t dsp_ramp_value(const dsp_ramp_t *r) {
+    return r->value >> DSP_RAMP_FRAC;
+}
+
+static inline bool dsp_ramp_active(const dsp_ramp_t *r) {
+    return r->left != 0;
+}
+
+// Linearly from where it is now to target over n samples (n >= 1)
+static inline void dsp_ramp_to(dsp_ramp_t *r, int32_t target, int32_t n) {
+    r->target = target;
+    r->left = n;
+    r->step = ((target << DSP_RAMP_FRAC) - r->value) / n;
+    if (r->step == 0) dsp_ramp_set(r, target);
+}
+
+// One block of an exponential approach to target: a k_q15 share of the
+// remaining distance over the next n samples. Within one LSB it lands.
+static inline void dsp_ramp_glide(dsp_ramp_t *r, int32_t target, int32_t k_q15, int32_t n) {
+    int32_t now = dsp_ramp_value(r);
+    int32_t d = target - now;
+    if (d == 0 && !r->left) return;
+    if (d >= -1 && d <= 1) {
+        dsp_ramp_to(r, target, n);
+    } else {
+        int32_t end = now + (int32_t)(((int64_t)d * k_q15) >> 15);
+        dsp_ramp_to(r, end == now ? target : end, n);
+    }
+}
+
+// Next sample's value
+static inline int32_t dsp_ramp_next(dsp_ramp_t *r) {
+    if (r->left) {
+        if (--r->left == 0) r->value = r->target << DSP_RAMP_FRAC;
+        else r->value += r->step;
+    }
+    return r->value >> DSP_RAMP_FRAC;
+}
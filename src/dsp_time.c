@@ -1,32 +1,93 @@
 #include "dsp_time.h"
-#include <math.h>
+#include "dsp_config.h"
+#include "dsp_fx.h"
+#include "dsp_ramp.h"
 
-#define FFT_SIZE 256
+/*
+ * Fixed-point effect path. Samples are lifted from 12-bit to Q15, run
+ * through the effect chain (dsp_fx.c) a chunk at a time as the wet
+ * signal and mixed back with the dry. host/dsp_time_ref.c holds the
+ * float version of the default chain this is checked against.
+ *
+ * The mix glides to a new value (10 ms time constant) and bypass
+ * crossfades over FX_XFADE samples; with neither moving, the loop is
+ * the plain mix.
+ */
 
-static float lp = 0;
-static float gain = 1.2f;
+// Wet samples per chain call; bounds the stack use of the output ISR
+#define FX_CHUNK    64
 
-void dsp_time_init() { lp = 0; }
+// Time constant of the mix glide, in samples
+#define MIX_GLIDE   (SAMPLE_RATE_HZ / 100)
 
-static inline float soft_clip(float x) {
-    return x / (1.0f + fabsf(x));
+static dsp_ramp_t mix;          // wet amount, Q15
+static dsp_ramp_t fx_on;        // 32768 = effect in, 0 = bypassed
+static bool primed;             // the first block takes its values at once
+
+void dsp_time_init() {
+    dsp_fx_init();
+    primed = false;
+}
+
+static inline int16_t clamp12(int32_t v) {
+    if (v > 2047) v = 2047;
+    if (v < -2048) v = -2048;
+    return (int16_t)v;
 }
 
 void dsp_time_process(
-    volatile int16_t *in,
+    const int16_t *in,
     int16_t *out,
-    float mix,
+    int n,
+    int16_t mix_q15,
     bool bypass
 ) {
-    for (int i = 0; i < FFT_SIZE; i++) {
-        float dry = in[i];
-        if (bypass) { out[i] = in[i]; continue; }
+    int32_t on = bypass ? 0 : 32768;
+
+    if (!primed) {
+        dsp_ramp_set(&mix, mix_q15);
+        dsp_ramp_set(&fx_on, on);
+        primed = true;
+    } else if (n > 0) {
+        dsp_ramp_glide(&mix, mix_q15, (n << 15) / (n + MIX_GLIDE), n);
+        if (on != fx_on.target) dsp_ramp_to(&fx_on, on, FX_XFADE);
+    }
+
+    if (!dsp_ramp_active(&fx_on) && dsp_ramp_value(&fx_on) == 0) {
+        for (int i = 0; i < n; i++) out[i] = in[i];
+        return;
+    }
+
+    for (int base = 0; base < n; base += FX_CHUNK) {
+        int16_t wet[FX_CHUNK];
+        int len = n - base < FX_CHUNK ? n - base : FX_CHUNK;
+
+        for (int i = 0; i < len; i++)
+            wet[i] = (int16_t)(in[base + i] << 4);     // 12-bit → Q15
+        dsp_fx_process(wet, len);
+
+        if (!dsp_ramp_active(&mix) && !dsp_ramp_active(&fx_on)) {
+            int32_t wet_mix = dsp_ramp_value(&mix);
+            int32_t dry_mix = 32768 - wet_mix;
+
+            for (int i = 0; i < len; i++) {
+                int32_t dry = (int32_t)in[base + i] << 4;
 
-        float wet = soft_clip((lp += 0.15f * (dry*gain - lp)));
-        float v = dry * (1 - mix) + wet * mix;
+                // Q15 * Q15 → Q30, back to 12-bit with rounding
+                int32_t v = (dry * dry_mix + wet[i] * wet_mix + (1 << 18)) >> 19;
+                out[base + i] = clamp12(v);
+            }
+        } else {
+            for (int i = 0; i < len; i++) {
+                int32_t s = in[base + i];
+                int32_t wet_mix = dsp_ramp_next(&mix);
+                int32_t a = dsp_ramp_next(&fx_on);
 
-        if (v > 2047) v = 2047;
-        if (v < -2048) v = -2048;
-        out[i] = (int16_t)v;
+                int32_t v = ((s << 4) * (32768 - wet_mix) + wet[i] * wet_mix + (1 << 18)) >> 19;
+                v = s + (((v - s) * a + (1 << 14)) >> 15);
+                out[base + i] = clamp12(v);
+            }
+        }
     }
+    dsp_fx_record_costs();
 }
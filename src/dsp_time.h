@@ -2,10 +2,19 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// Q15 helpers for parameters (1.0 is stored as 32767)
+#define Q15(x)  ((int16_t)((x) >= 1.0 ? 32767 : (x) * 32768))
+
 void dsp_time_init(void);
+
+// The effect chain (dsp_fx.h; by default gain → one-pole low-pass →
+// soft clip), mixed with the dry signal. in/out are n 12-bit signed
+// samples (any block size; the chain state carries over), mix_q15 is
+// the wet amount. Records the chain's PROF_FX* stages.
 void dsp_time_process(
-    volatile int16_t *in,
+    const int16_t *in,
     int16_t *out,
-    float mix,
+    int n,
+    int16_t mix_q15,
     bool bypass
 );
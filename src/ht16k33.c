@@ -1,7 +1,42 @@
 #include "ht16k33.h"
 #include "display.h"
 #include "hardware/i2c.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
 #include <stdint.h>
+#include <stdbool.h>
+
+#define RAM_WRITE_LEN 17 // RAM start address + 8 rows × 2 bytes
+
+// Unchanged rows up to this long are rewritten rather than split into
+// a new transfer (START + address + RAM pointer costs about as much)
+#define RUN_MERGE_GAP 1
+#define MAX_RUNS      4  // per device: 8 rows, runs ≥ RUN_MERGE_GAP+1 apart
+
+// One DMA-fed IC_DATA_CMD word per byte; STOP is set on the last one
+typedef struct {
+    uint8_t  addr;
+    uint8_t  dev;
+    uint8_t  len;
+    uint16_t cmd[RAM_WRITE_LEN];
+} ht16k33_xfer_t;
+
+// What each device is showing, as far as we know
+typedef struct {
+    uint8_t addr;
+    bool    valid;
+    uint8_t rows[8];
+} ht16k33_shadow_t;
+
+static ht16k33_xfer_t xfers[HT16K33_MAX_DEVICES * MAX_RUNS];
+static ht16k33_shadow_t shown[HT16K33_MAX_DEVICES];
+static volatile int xfer_count;
+static volatile int xfer_next;
+static volatile bool busy;
+static volatile uint32_t batches_done;
+static volatile uint32_t errors;
+static uint32_t bytes_sent;
+static int i2c_dma_chan = -1;
 
 
 void ht16k33_init(uint8_t addr) {
@@ -17,9 +52,17 @@ void ht16k33_init(uint8_t addr) {
     i2c_write_blocking(DISPLAY_I2C_PORT, addr, &cmd, 1, false);
 }
 
+static void shadow_invalidate(uint8_t addr) {
+    for (int d = 0; d < HT16K33_MAX_DEVICES; d++)
+        if (shown[d].addr == addr) shown[d].valid = false;
+}
+
 void ht16k33_update(uint8_t addr, const uint8_t *rows) {
     uint8_t buffer[17];
 
+    // bypasses the async path, so resend everything next time
+    shadow_invalidate(addr);
+
     buffer[0] = 0x00; // RAM start address
 
     for (int i = 0; i < 8; i++) {
@@ -37,7 +80,146 @@ void ht16k33_update(uint8_t addr, const uint8_t *rows) {
 }
 
 void ht16k33_set_brightness(uint8_t addr, uint8_t level) {
+    // blocking writes must not interleave with a queued batch
+    while (ht16k33_busy())
+        tight_loop_contents();
+
     if (level > 15) level = 15;
     uint8_t cmd = 0xE0 | level;
     i2c_write_blocking(DISPLAY_I2C_PORT, addr, &cmd, 1, false);
 }
+
+
+// --------------------------------------------------
+// Non-blocking updates: the DMA channel feeds one device's RAM write
+// into the TX FIFO; STOP_DET moves on to the next device. TAR can only
+// change while the controller is disabled, i.e. between transfers.
+
+static void xfer_start(const ht16k33_xfer_t *x) {
+    i2c_hw_t *hw = i2c_get_hw(DISPLAY_I2C_PORT);
+
+    hw->enable = 0;
+    hw->tar = x->addr;
+    hw->enable = 1;
+
+    dma_channel_transfer_from_buffer_now(i2c_dma_chan, x->cmd, x->len);
+}
+
+static void __isr i2c_irq_handler(void) {
+    i2c_hw_t *hw = i2c_get_hw(DISPLAY_I2C_PORT);
+    uint32_t stat = hw->intr_stat;
+
+    if (stat & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+        // device NACKed: drop the rest of its write, STOP follows.
+        // Its RAM is now unknown, so resend all of it next frame.
+        (void)hw->clr_tx_abrt;
+        dma_channel_abort(i2c_dma_chan);
+        shown[xfers[xfer_next - 1].dev].valid = false;
+        errors++;
+    }
+
+    if (stat & I2C_IC_INTR_STAT_R_STOP_DET_BITS) {
+        (void)hw->clr_stop_det;
+
+        if (xfer_next < xfer_count) {
+            xfer_start(&xfers[xfer_next++]);
+        } else {
+            // leave the interrupts to i2c_write_blocking() again
+            hw->intr_mask = 0;
+            batches_done++;
+            busy = false;
+        }
+    }
+}
+
+void ht16k33_async_init(void) {
+    i2c_hw_t *hw = i2c_get_hw(DISPLAY_I2C_PORT);
+
+    i2c_dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(i2c_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(DISPLAY_I2C_PORT, true));
+    dma_channel_configure(i2c_dma_chan, &c, &hw->data_cmd, NULL, 0, false);
+
+    hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS;
+    hw->intr_mask = 0;
+
+    uint irq = i2c_hw_index(DISPLAY_I2C_PORT) ? I2C1_IRQ : I2C0_IRQ;
+    irq_set_exclusive_handler(irq, i2c_irq_handler);
+    irq_set_enabled(irq, true);
+}
+
+// Queue a RAM write of rows first..last of device d
+static int queue_run(int n, int d, uint8_t addr, const uint8_t *rows, int first, int last) {
+    ht16k33_xfer_t *x = &xfers[n];
+    int len = 0;
+
+    x->addr = addr;
+    x->dev = (uint8_t)d;
+    x->cmd[len++] = (uint16_t)(first * 2); // RAM address of the first row
+    for (int i = first; i <= last; i++) {
+        x->cmd[len++] = rows[i];
+        if (i < last)
+            x->cmd[len++] = 0x00; // unused
+    }
+    x->cmd[len - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+    x->len = (uint8_t)len;
+
+    bytes_sent += len;
+    return n + 1;
+}
+
+bool ht16k33_update_async(const uint8_t *addrs, const uint8_t *const *rows, int count) {
+    if (busy || count <= 0) return false;
+    if (count > HT16K33_MAX_DEVICES) count = HT16K33_MAX_DEVICES;
+
+    int n = 0;
+    for (int d = 0; d < count; d++) {
+        ht16k33_shadow_t *sh = &shown[d];
+        if (sh->addr != addrs[d]) {
+            sh->addr = addrs[d];
+            sh->valid = false;
+        }
+
+        // runs of changed rows, merging across short unchanged gaps
+        int first = -1, last = -1;
+        for (int i = 0; i < 8; i++) {
+            if (sh->valid && rows[d][i] == sh->rows[i]) continue;
+
+            if (first >= 0 && i - last - 1 > RUN_MERGE_GAP) {
+                n = queue_run(n, d, sh->addr, rows[d], first, last);
+                first = -1;
+            }
+            if (first < 0) first = i;
+            last = i;
+        }
+        if (first >= 0)
+            n = queue_run(n, d, sh->addr, rows[d], first, last);
+
+        for (int i = 0; i < 8; i++) sh->rows[i] = rows[d][i];
+        sh->valid = true;
+    }
+
+    if (n == 0) {
+        // nothing changed: done without touching the bus
+        batches_done++;
+        return true;
+    }
+
+    xfer_count = n;
+    xfer_next = 1;
+    busy = true;
+
+    i2c_hw_t *hw = i2c_get_hw(DISPLAY_I2C_PORT);
+    (void)hw->clr_intr;
+    hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+    xfer_start(&xfers[0]);
+    return true;
+}
+
+bool ht16k33_busy(void)            { return busy; }
+uint32_t ht16k33_batches_done(void) { return batches_done; }
+uint32_t ht16k33_errors(void)       { return errors; }
+uint32_t ht16k33_bytes_sent(void)   { return bytes_sent; }
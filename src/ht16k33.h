@@ -1,6 +1,31 @@
 #pragma once
 #include <stdint.h>
+#include <stdbool.h>
+
+#define HT16K33_MAX_DEVICES 4
 
 void ht16k33_init(uint8_t addr);
 void ht16k33_update(uint8_t addr, const uint8_t *rows);
-void ht16k33_set_brightness(uint8_t addr, uint8_t level);
\ No newline at end of file
+void ht16k33_set_brightness(uint8_t addr, uint8_t level);
+
+// ---- Non-blocking RAM updates (DMA + I2C IRQ) ----
+
+// Claim the DMA channel and install the I2C IRQ handler
+void ht16k33_async_init(void);
+
+// Queue an 8-row RAM update per device and return immediately. Only
+// rows that differ from what the device last received are sent, and a
+// device with no changes is skipped. The rows are copied, so the caller
+// may redraw at once. Returns false (nothing queued) while the previous
+// batch is still on the bus.
+bool ht16k33_update_async(const uint8_t *addrs, const uint8_t *const *rows, int count);
+
+// True while a batch queued by ht16k33_update_async() is in flight
+bool ht16k33_busy(void);
+
+// Batches completed, and device writes aborted (NACK etc.) so far
+uint32_t ht16k33_batches_done(void);
+uint32_t ht16k33_errors(void);
+
+// I2C data bytes (RAM pointer + rows) queued so far
+uint32_t ht16k33_bytes_sent(void);
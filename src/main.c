@@ -3,44 +3,169 @@
 
 #include "adc_mcp3202.h"
 #include "dsp.h"
+#include "dsp_hop.h"
+#include "dsp_fb.h"
 #include "dsp_time.h"
 #include "audio_out_pwm.h"
+#include "audio_out.h"
+#include "audio_path.h"
 #include "display.h"
 #include "debug_usb.h"
+#include "params.h"
+#include "ht16k33.h"
+#include "capture.h"
+#include "prof.h"
+#include "sched.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 
-static int16_t audio_out[256];
-static float mix = 0.7f;
-static bool bypass = false;
+// STFT window of the input (planar, ADC_CHANNELS), and the
+// non-overlapping block capture sends (mono in its first FFT_SIZE)
+static int16_t window_in[ADC_CHANNELS * FFT_SIZE];
+static int16_t capture_buf[ADC_CHANNELS * FFT_SIZE];
 
+static audio_reader_t analysis, capture_reader;
+static dsp_hop_t hop_ctl;
+static volatile uint32_t stft_hop = FFT_SIZE;   // or DSP_FB_BLOCK, filterbank
 
+// FFT_SIZE samples of time, in prof clock ticks
+static uint32_t window_ticks;
 
-// Run this on Core 1
+// Telemetry stats/profile cadence, in band frames
+#define STATS_EVERY 64
+
+
+// One STFT window through dsp_process, then the hop to the window
+// after the next one, from this one's cost. False if no window was
+// ready.
+static bool analyze_fft(void) {
+    static uint32_t hop = FFT_SIZE;
+    uint32_t seq;
+
+    if (stft_hop != hop) {      // back from the filterbank
+        stft_hop = hop;
+        prof_set_deadline(PROF_CORE1_BLOCK,
+                          (uint32_t)((uint64_t)window_ticks * hop / FFT_SIZE));
+    }
+    if (!audio_path_window(&analysis, hop, window_in, NULL, &seq)) return false;
+
+    PROF_START(t_block);
+
+    dsp_window_t window = (dsp_window_t)param_get(PARAM_WINDOW);
+    uint32_t t_dsp = prof_now();
+    dsp_set_window(window);
+#if ADC_CHANNELS == 2
+    dsp_process_stereo(window_in, (dsp_view_t)param_get(PARAM_VIEW));
+#else
+    dsp_process(window_in);
+#endif
+    uint32_t cost = (prof_now() - t_dsp) & prof_clock_mask();
+    PROF_RECORD(PROF_DSP_PROCESS, cost);   // the hop needs it either way
+
+    uint32_t next = dsp_hop_next(&hop_ctl, cost, window,
+                                 (uint32_t)param_get(PARAM_HOP));
+    if (next != hop) {
+        hop = next;
+        stft_hop = hop;
+        prof_set_deadline(PROF_CORE1_BLOCK,
+                          (uint32_t)((uint64_t)window_ticks * hop / FFT_SIZE));
+    }
+
+    PROF_END(PROF_CORE1_BLOCK, t_block);
+    return true;
+}
+
+// The next DSP_FB_BLOCK samples (of the mid, in stereo) through the
+// filterbank. False if they were not there yet.
+static bool analyze_filterbank(bool restart) {
+    uint32_t seq;
+
+    if (restart) {
+        dsp_fb_init();
+        stft_hop = DSP_FB_BLOCK;
+        prof_set_deadline(PROF_CORE1_BLOCK,
+                          (uint32_t)((uint64_t)window_ticks * DSP_FB_BLOCK / FFT_SIZE));
+    }
+    if (!audio_path_read(&analysis, window_in, DSP_FB_BLOCK, &seq)) return false;
+
+    PROF_START(t_block);
+    PROF_START(t_dsp);
+    adc_mono(window_in, window_in, DSP_FB_BLOCK);
+    dsp_fb_process(window_in, DSP_FB_BLOCK);
+    PROF_END(PROF_DSP_PROCESS, t_dsp);
+    PROF_END(PROF_CORE1_BLOCK, t_block);
+    return true;
+}
+
+// Run this on Core 1. The audio path runs from the output DMA
+// interrupt; the loop here only does the analysis, and sleeps until
+// the interrupt's SEV when there is none to do (sched.h).
 void core1_entry() {
     dsp_init();
     dsp_time_init();
-    audio_pwm_init(15);
 
+    prof_clock_init();
+    window_ticks =
+        prof_us_to_ticks((uint32_t)((uint64_t)FFT_SIZE * 1000000u / SAMPLE_RATE_HZ));
+    prof_set_deadline(PROF_CORE1_BLOCK, window_ticks);
+    prof_set_deadline(PROF_AUDIO_BLOCK,
+        prof_us_to_ticks((uint32_t)((uint64_t)AUDIO_BLOCK_SIZE * 1000000u / SAMPLE_RATE_HZ)));
+
+    dsp_hop_init(&hop_ctl, window_ticks);
+    audio_reader_init(&analysis);
+    audio_reader_init(&capture_reader);
+
+    audio_pwm_init(15, SAMPLE_RATE_HZ);
+
+    dsp_engine_t engine = DSP_ENGINE_FFT;
     while (1) {
-        if (adc_ready_buffer) {
-            dsp_process(adc_ready_buffer);
-            dsp_time_process(adc_ready_buffer, audio_out, mix, bypass);
-            audio_pwm_play(audio_out);
-            adc_ready_buffer = NULL;
+        uint32_t seq;
+        bool worked = false;
+
+        // capture goes out in back-to-back blocks, whatever the hop;
+        // ADC capture is the mid in stereo, as the effect hears it
+        int32_t cap = param_get(PARAM_CAPTURE);
+        if (audio_path_window(&capture_reader, FFT_SIZE,
+                              cap == CAPTURE_ADC ? capture_buf : NULL,
+                              cap == CAPTURE_AUDIO ? capture_buf : NULL, &seq) &&
+            cap != CAPTURE_OFF) {
+            if (cap == CAPTURE_ADC) adc_mono(capture_buf, capture_buf, FFT_SIZE);
+            capture_push(capture_buf, seq, (capture_source_t)cap);
+            worked = true;
         }
-        tight_loop_contents();
+
+        dsp_engine_t want = (dsp_engine_t)param_get(PARAM_ENGINE);
+        bool published = want == DSP_ENGINE_FILTERBANK
+                       ? analyze_filterbank(engine != want)
+                       : analyze_fft();
+        engine = want;
+
+        if (published) {
+            __sev();            // a new band frame for core 0
+            worked = true;
+        }
+        if (!worked) __wfe();
     }
 }
-
 int main() {
 
     stdio_init_all();
     srand(time(NULL));   // seed random generator
-    sleep_ms(1500);
 
+    prof_clock_init();
+    params_init();
+    capture_init();
+    debug_init();
+#ifdef DISPLAY_TEST
+    sleep_ms(1500);
+#else
+    // tud_task() runs only from debug_poll() (debug_usb.c), so keep
+    // enumeration going through the start-up delay
+    absolute_time_t up = make_timeout_time_ms(1500);
+    while (!time_reached(up)) debug_poll();
+#endif
     display_init();
 
 #ifdef DISPLAY_TEST
@@ -48,21 +173,83 @@ int main() {
     display_test();
 #else
     // main app loop
-    adc_init();
+    adc_init(SAMPLE_RATE_HZ);
     adc_start_dma();
 
     multicore_launch_core1(core1_entry);
 
+    band_frame_t frame = { 0 };
+    uint32_t last_frame = 0;
+    uint32_t last_stats = 0;
+    int32_t max_fps = param_get(PARAM_MAX_FPS);
+    sched_pacer_t pacer;
+    sched_pacer_init(&pacer, (uint32_t)max_fps);
+
+    // Woken by core 1 publishing a band frame, the USB, I2C and ADC
+    // interrupts, or the pacer's timer (sched.h)
     while (1) {
-        display_update_float(band_levels, 16);
-        display_render();
-        debug_print_bands(band_levels);
+        if (dsp_band_frames.published != last_frame) {
+            // newest complete band frame from core 1 (never half-updated)
+            band_exchange_read(&dsp_band_frames, &frame);
+            last_frame = frame.frame;
+
+            debug_send_bands(frame.frame, frame.levels);
+
+            // by distance, not frame % STATS_EVERY: core 0 reads only the
+            // newest frame, so any given number can be skipped
+            if (frame.frame - last_stats >= STATS_EVERY) {
+                last_stats = frame.frame;
+                tlm_stats_t stats = {
+                    .frame       = frame.frame,
+                    .adc_dropped = adc_dropped_blocks(),
+                    .adc_late    = adc_late_blocks(),
+                    .disp_frames = ht16k33_batches_done(),
+                    .disp_errors = ht16k33_errors(),
+                    .audio_underruns = audio_out_underruns(),
+                    .audio_overruns  = audio_out_overruns(),
+                    .audio_skipped   = audio_path_skipped(),
+                    .win_dropped     = analysis.dropped,
+                    .stft_hop        = stft_hop,
+                };
+                debug_send_stats(&stats);
+                debug_send_profiles();
+            }
+        }
+
+        if (param_get(PARAM_MAX_FPS) != max_fps) {
+            max_fps = param_get(PARAM_MAX_FPS);
+            sched_pacer_set_rate(&pacer, (uint32_t)max_fps);
+        }
+
+        // draw the frame now, hold it for the rate cap, or (while the
+        // last one is still on the bus) wait for the I2C interrupt
+        uint32_t now = time_us_32(), wake = 0;
+        sched_action_t act = sched_pacer_poll(&pacer, last_frame, now, &wake);
+        if (act == SCHED_RENDER && !display_render_busy()) {
+            display_dyn_config_t dyn;
+            display_dyn_config_params(&dyn);
+
+            PROF_START(t_update);
+            display_set_dynamics(&dyn);
+            display_update_db(frame.levels, NUM_BANDS);
+            PROF_END(PROF_DISPLAY_UPDATE, t_update);
+
+            PROF_START(t_render);
+            display_render_async();
+            PROF_END(PROF_DISPLAY_RENDER, t_render);
+            sched_pacer_done(&pacer, frame.frame, now);
+            act = SCHED_IDLE;
+        }
 
-        int c = getchar_timeout_us(0);
-        if (c != PICO_ERROR_TIMEOUT)
-            debug_handle_cmd(c, &mix, &bypass);
+        PROF_START(t_usb);
+        debug_poll();
+        PROF_END(PROF_USB_POLL, t_usb);
 
-        sleep_ms(30);
+        if (dsp_band_frames.published != last_frame) continue;
+        if (act == SCHED_HOLD)
+            best_effort_wfe_or_timeout(make_timeout_time_us(wake - now));
+        else
+            __wfe();
     }
 #endif
     return 0;
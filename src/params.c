@@ -0,0 +1,118 @@
+#include "params.h"
+#include "dsp_time.h"
+#include "capture.h"
+#include "dsp.h"
+#include "dsp_fx.h"
+#include "spsc.h"
+
+#include <string.h>
+
+#if FX_SLOTS != 4
+#error "param_defs lists four effect slots"
+#endif
+
+// Effect slot s: module and bypass, then its five fields (dsp_fx.h)
+#define FX_SLOT_DEFS(s, type_def) \
+    [PARAM_FX(s, PARAM_FX_TYPE)]   = { "fx" #s "_type",   PARAM_INT,  0, FX_TYPE_COUNT - 1, type_def }, \
+    [PARAM_FX(s, PARAM_FX_BYPASS)] = { "fx" #s "_bypass", PARAM_BOOL, 0, 1, 0 }, \
+    [PARAM_FX(s, PARAM_FX_A + 0)]  = { "fx" #s "_a",      PARAM_INT,  INT16_MIN, INT16_MAX, 0 }, \
+    [PARAM_FX(s, PARAM_FX_A + 1)]  = { "fx" #s "_b",      PARAM_INT,  INT16_MIN, INT16_MAX, 0 }, \
+    [PARAM_FX(s, PARAM_FX_A + 2)]  = { "fx" #s "_c",      PARAM_INT,  INT16_MIN, INT16_MAX, 0 }, \
+    [PARAM_FX(s, PARAM_FX_A + 3)]  = { "fx" #s "_d",      PARAM_INT,  INT16_MIN, INT16_MAX, 0 }, \
+    [PARAM_FX(s, PARAM_FX_A + 4)]  = { "fx" #s "_e",      PARAM_INT,  INT16_MIN, INT16_MAX, 0 }
+
+const param_def_t param_defs[PARAM_COUNT] = {
+    [PARAM_MIX]         = { "mix",         PARAM_Q15,  0, Q15(1.0), Q15(0.7) },
+    [PARAM_BYPASS]      = { "bypass",      PARAM_BOOL, 0, 1,        0        },
+    [PARAM_CAPTURE]     = { "capture",     PARAM_INT,  CAPTURE_OFF, CAPTURE_AUDIO, CAPTURE_OFF },
+    [PARAM_SAMPLE_RATE] = { "sample_rate", PARAM_INT,
+                            SAMPLE_RATE_HZ, SAMPLE_RATE_HZ, SAMPLE_RATE_HZ },
+    [PARAM_WINDOW]      = { "window",      PARAM_INT,  0, DSP_WINDOW_COUNT - 1, DSP_WINDOW_HANN },
+    [PARAM_HOP]         = { "hop",         PARAM_INT,  0, FFT_SIZE, 0 },
+    [PARAM_ENGINE]      = { "engine",      PARAM_INT,  0, DSP_ENGINE_COUNT - 1, DSP_ENGINE_FFT },
+    [PARAM_VIEW]        = { "view",        PARAM_INT,  0, DSP_VIEW_COUNT - 1, DSP_VIEW_MID },
+    [PARAM_MAX_FPS]     = { "max_fps",     PARAM_INT,  0, 1000, ANALYSIS_FRAME_HZ },
+    [PARAM_DISP_AGC]    = { "disp_agc",    PARAM_BOOL, 0, 1,    1   },
+    [PARAM_DISP_RANGE]  = { "disp_range",  PARAM_INT,  12, 90,  48  },
+    [PARAM_DISP_ATTACK] = { "disp_attack", PARAM_INT,  0, 1000, 15  },
+    [PARAM_DISP_DECAY]  = { "disp_decay",  PARAM_INT,  0, 1000, 40  },
+    [PARAM_DISP_HOLD]   = { "disp_hold",   PARAM_INT,  0, 5000, 600 },
+    [PARAM_DISP_PEAK_DECAY] = { "disp_peak_decay", PARAM_INT, 0, 1000, 20 },
+    FX_SLOT_DEFS(0, FX_DRIVE),
+    FX_SLOT_DEFS(1, FX_NONE),
+    FX_SLOT_DEFS(2, FX_NONE),
+    FX_SLOT_DEFS(3, FX_NONE),
+};
+
+static volatile int32_t values[PARAM_COUNT];
+
+// seqlock over values[]: odd while a write is under way
+static volatile uint32_t write_seq;
+
+// params_write_begin() depth; writer side only
+static uint32_t write_depth;
+
+void params_init(void) {
+    for (int i = 0; i < PARAM_COUNT; i++)
+        values[i] = param_defs[i].def;
+    write_seq += 2;
+}
+
+int32_t param_get(param_id_t id) {
+    return (unsigned)id < PARAM_COUNT ? values[id] : 0;
+}
+
+param_status_t param_set(param_id_t id, int32_t value, int32_t *applied) {
+    if ((unsigned)id >= PARAM_COUNT) return PARAM_BAD_ID;
+
+    const param_def_t *d = &param_defs[id];
+    param_status_t status = PARAM_OK;
+    if (value < d->min) { value = d->min; status = PARAM_CLAMPED; }
+    if (value > d->max) { value = d->max; status = PARAM_CLAMPED; }
+
+    params_write_begin();
+    values[id] = value;
+    params_write_end();
+    if (applied) *applied = value;
+    return status;
+}
+
+void params_write_begin(void) {
+    if (write_depth++ == 0) {
+        write_seq++;
+        spsc_barrier();
+    }
+}
+
+void params_write_end(void) {
+    if (--write_depth == 0) {
+        spsc_barrier();
+        write_seq++;
+    }
+}
+
+int param_find(const char *name) {
+    for (int i = 0; i < PARAM_COUNT; i++)
+        if (strcmp(param_defs[i].name, name) == 0) return i;
+    return -1;
+}
+
+void params_latch_init(param_snapshot_t *s) {
+    s->seq = 1;     // odd: never a finished write
+}
+
+bool params_latch(param_snapshot_t *s) {
+    uint32_t seq = write_seq;
+    if (seq == s->seq) return true;
+    if (seq & 1) return false;
+
+    int32_t v[PARAM_COUNT];
+    spsc_barrier();
+    for (int i = 0; i < PARAM_COUNT; i++) v[i] = values[i];
+    spsc_barrier();
+    if (write_seq != seq) return false;
+
+    memcpy(s->v, v, sizeof(v));
+    s->seq = seq;
+    return true;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "dsp_config.h"
+
+/*
+ * Runtime-tunable parameters, shared by core 1 (reads) and the USB
+ * control path on core 0 (writes). Values are int32 in the parameter's
+ * own fixed-point format; single aligned words, so reads never tear.
+ *
+ * The audio path does not read them one by one: once per block it
+ * latches all of them through a seqlock (params_latch()), and costs
+ * nothing more while no parameter changes. A write is one param_set(),
+ * or every param_set() between params_write_begin() and
+ * params_write_end() (a TLM_SET_MANY request); a block sees all of a
+ * write or none of it. Separate writes can land in different blocks,
+ * so the fields of one effect slot go in one write, or the chain
+ * designs and glides through the settings in between. The effect then
+ * ramps to the new values itself (dsp_ramp.h).
+ */
+
+typedef enum {
+    PARAM_Q15,      // 0..32767 = 0.0..1.0
+    PARAM_BOOL,     // 0 / 1
+    PARAM_INT,
+} param_type_t;
+
+#define PARAM_FX_FIELDS  7
+
+typedef enum {
+    PARAM_MIX,          // effect wet amount
+    PARAM_BYPASS,       // effect bypass
+    PARAM_CAPTURE,      // capture_source_t streamed over USB
+    PARAM_SAMPLE_RATE,  // Hz, read-only (min = max)
+    PARAM_WINDOW,       // dsp_window_t for the analysis
+    PARAM_HOP,          // STFT hop in samples, 0 = adapt to the CPU headroom
+    PARAM_ENGINE,       // dsp_engine_t: FFT or filterbank
+    PARAM_VIEW,         // dsp_view_t: mid, L/R or M/S split (stereo FFT only)
+    PARAM_MAX_FPS,      // display frame-rate cap, 0 = draw every band frame
+    PARAM_DISP_AGC,     // display dynamics (display_dyn.h): floor and AGC on
+    PARAM_DISP_RANGE,   // dB shown with the AGC on
+    PARAM_DISP_ATTACK,  // bar rise time constant, ms
+    PARAM_DISP_DECAY,   // bar fall, dB/s
+    PARAM_DISP_HOLD,    // peak-dot hold, ms (0 = no dots)
+    PARAM_DISP_PEAK_DECAY,  // peak-dot fall, dB/s
+    PARAM_FX_BASE,      // effect chain: PARAM_FX_FIELDS per slot (dsp_fx.h)
+    PARAM_FX_LAST = PARAM_FX_BASE + FX_SLOTS * PARAM_FX_FIELDS - 1,
+    PARAM_COUNT
+} param_id_t;
+
+// Fields of one effect slot: fxN_type, fxN_bypass, fxN_a..fxN_e
+enum {
+    PARAM_FX_TYPE,      // fx_type_t
+    PARAM_FX_BYPASS,
+    PARAM_FX_A,         // a..e: fx_config_t.f, meaning per type
+};
+
+#define PARAM_FX(slot, field)  ((param_id_t)(PARAM_FX_BASE + (slot) * PARAM_FX_FIELDS + (field)))
+
+typedef enum {
+    PARAM_OK,
+    PARAM_CLAMPED,  // set: value was out of range and was clamped
+    PARAM_BAD_ID,
+    PARAM_BAD_REQUEST,  // telemetry: payload of the wrong length
+} param_status_t;
+
+typedef struct {
+    const char  *name;
+    param_type_t type;
+    int32_t      min, max, def;
+} param_def_t;
+
+extern const param_def_t param_defs[PARAM_COUNT];
+
+void params_init(void);
+
+int32_t param_get(param_id_t id);
+
+// Clamp to the parameter's range and store; *applied (may be NULL)
+// receives the stored value
+param_status_t param_set(param_id_t id, int32_t value, int32_t *applied);
+
+// Make the param_set() calls in between one write. Writer side only;
+// params_latch() fails until the end, so keep it to a few stores. Nests.
+void params_write_begin(void);
+void params_write_end(void);
+
+// Parameter id by name, or -1
+int param_find(const char *name);
+
+// ---- Mailbox for the audio path ----
+
+typedef struct {
+    uint32_t seq;               // write count it was taken at
+    int32_t  v[PARAM_COUNT];
+} param_snapshot_t;
+
+// A snapshot the next params_latch() fills in
+void params_latch_init(param_snapshot_t *s);
+
+// Bring *s up to date with every parameter at once; false (and *s left
+// as it was, still consistent) if a write was under way: try again
+// next block. One writer (core 0) and any number of latching readers.
+bool params_latch(param_snapshot_t *s);
@@ -0,0 +1,100 @@
+#include "prof.h"
+#include "spsc.h"
+
+#include <string.h>
+
+const char *const prof_stage_names[PROF_STAGE_COUNT] = {
+    [PROF_DSP_PROCESS]    = "dsp_process",
+    [PROF_DSP_TIME]       = "dsp_time",
+    [PROF_FX0]            = "fx0",
+    [PROF_FX1]            = "fx1",
+    [PROF_FX2]            = "fx2",
+    [PROF_FX3]            = "fx3",
+    [PROF_AUDIO_PLAY]     = "audio_play",
+    [PROF_CORE1_BLOCK]    = "core1_block",
+    [PROF_AUDIO_BLOCK]    = "audio_block",
+    [PROF_DISPLAY_UPDATE] = "display_update",
+    [PROF_DISPLAY_RENDER] = "display_render",
+    [PROF_USB_POLL]       = "usb_poll",
+};
+
+// seqlock per stage: odd while the recording core is updating it
+typedef struct {
+    volatile uint32_t seq;
+    volatile bool     reset;    // requested by any core, done by the recorder
+    prof_stat_t       s;
+} prof_slot_t;
+
+static prof_slot_t slots[PROF_STAGE_COUNT];
+
+// MSB position by binary search, as in dsp_log.c (__builtin_clz is a
+// libgcc call on the M0+, which has no CLZ)
+static inline int log2_bucket(uint32_t v) {
+    int msb = 0;
+    if ((v >> msb) >= 1u << 16) msb += 16;
+    if ((v >> msb) >= 1u << 8)  msb += 8;
+    if ((v >> msb) >= 1u << 4)  msb += 4;
+    if ((v >> msb) >= 1u << 2)  msb += 2;
+    if ((v >> msb) >= 1u << 1)  msb += 1;
+    return msb;
+}
+
+void prof_reset(void) {
+    for (int i = 0; i < PROF_STAGE_COUNT; i++)
+        slots[i].reset = true;
+}
+
+void prof_set_deadline(prof_stage_t stage, uint32_t ticks) {
+    slots[stage].s.deadline = ticks;
+}
+
+void prof_record(prof_stage_t stage, uint32_t ticks) {
+    prof_slot_t *p = &slots[stage];
+    prof_stat_t *s = &p->s;
+
+    p->seq++;
+    spsc_barrier();
+    if (p->reset) {
+        uint32_t deadline = s->deadline;
+        memset(s, 0, sizeof(*s));
+        s->deadline = deadline;
+        p->reset = false;
+    }
+    if (!s->count++ || ticks < s->min) s->min = ticks;
+    s->sum += ticks;
+    if (ticks > s->max) s->max = ticks;
+    if (s->deadline && ticks > s->deadline) s->misses++;
+    s->hist[log2_bucket(ticks)]++;
+    spsc_barrier();
+    p->seq++;
+}
+
+uint32_t prof_us_to_ticks(uint32_t us) {
+    return (uint32_t)((uint64_t)us * prof_tick_hz() / 1000000u);
+}
+
+void prof_snapshot(prof_stage_t stage, prof_stat_t *out) {
+    prof_slot_t *p = &slots[stage];
+
+    for (;;) {
+        uint32_t seq = p->seq;
+        if (seq & 1) continue;
+        spsc_barrier();
+        memcpy(out, &p->s, sizeof(*out));
+        spsc_barrier();
+        if (p->seq == seq) break;
+    }
+    if (!out->count) out->min = 0;
+}
+
+uint32_t prof_percentile(const prof_stat_t *s, uint32_t pct) {
+    if (!s->count) return 0;
+
+    uint64_t want = ((uint64_t)s->count * pct + 99) / 100;
+    uint64_t seen = 0;
+    for (int b = 0; b < PROF_BUCKETS; b++) {
+        seen += s->hist[b];
+        if (seen >= want) return b ? 1u << b : 0;
+    }
+    return s->max;
+}
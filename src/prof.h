@@ -0,0 +1,94 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Per-stage execution time profiling.
+ *
+ * Each stage keeps count, min, max, sum, a log2 histogram of its
+ * durations and the number of runs over its deadline. Durations are in
+ * ticks of the platform clock: core clock cycles from SysTick on the
+ * RP2040 (prof_clock_rp2040.c), nanoseconds from CLOCK_MONOTONIC on the
+ * host (host/prof_clock_host.c).
+ *
+ * A stage is recorded from one core only; any core may read it. With
+ * PROF_ENABLE 0 (CMake PICO_SPECTRUM_PROFILE=OFF) the hooks compile to
+ * nothing and every stage reads as empty.
+ */
+
+#ifndef PROF_ENABLE
+#define PROF_ENABLE 1
+#endif
+
+typedef enum {
+    // core 1, per analysis window
+    PROF_DSP_PROCESS,
+    PROF_CORE1_BLOCK,       // whole window; deadline = FFT_SIZE samples
+    // core 1 output ISR, per audio block
+    PROF_DSP_TIME,
+    PROF_FX0,               // effect chain slots, one per FX_SLOTS
+    PROF_FX1,
+    PROF_FX2,
+    PROF_FX3,
+    PROF_AUDIO_PLAY,
+    PROF_AUDIO_BLOCK,       // whole step; deadline = AUDIO_BLOCK_SIZE samples
+    // core 0, per frame
+    PROF_DISPLAY_UPDATE,
+    PROF_DISPLAY_RENDER,
+    PROF_USB_POLL,
+    PROF_STAGE_COUNT
+} prof_stage_t;
+
+// Bucket b counts durations in [2^b, 2^(b+1)) ticks (bucket 0 also 0)
+#define PROF_BUCKETS 32
+
+typedef struct {
+    uint32_t count;
+    uint32_t min, max;
+    uint64_t sum;
+    uint32_t deadline;      // ticks, 0 = none
+    uint32_t misses;        // runs longer than deadline
+    uint32_t hist[PROF_BUCKETS];
+} prof_stat_t;
+
+extern const char *const prof_stage_names[PROF_STAGE_COUNT];
+
+// ---- Platform clock ----
+
+// Set up the tick source for the calling core
+void prof_clock_init(void);
+
+// Free-running tick count; differences are valid modulo prof_clock_mask()
+uint32_t prof_now(void);
+uint32_t prof_clock_mask(void);
+uint32_t prof_tick_hz(void);
+
+// ---- Recording ----
+
+// Clear every stage (deadlines are kept); takes effect at each stage's
+// next record, on the core that records it
+void prof_reset(void);
+void prof_set_deadline(prof_stage_t stage, uint32_t ticks);
+void prof_record(prof_stage_t stage, uint32_t ticks);
+
+// Ticks for a duration in microseconds at the platform clock
+uint32_t prof_us_to_ticks(uint32_t us);
+
+#if PROF_ENABLE
+#define PROF_START(t)        uint32_t t = prof_now()
+#define PROF_END(stage, t)   prof_record((stage), (prof_now() - (t)) & prof_clock_mask())
+#define PROF_RECORD(stage, ticks) prof_record((stage), (ticks))
+#else
+#define PROF_START(t)        ((void)0)
+#define PROF_END(stage, t)   ((void)0)
+#define PROF_RECORD(stage, ticks) ((void)0)
+#endif
+
+// ---- Queries (any core) ----
+
+// Consistent copy of a stage's statistics
+void prof_snapshot(prof_stage_t stage, prof_stat_t *out);
+
+// Lower edge of the histogram bucket holding the pct-th percentile, in
+// ticks; the true value is below twice this
+uint32_t prof_percentile(const prof_stat_t *s, uint32_t pct);
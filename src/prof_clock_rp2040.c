@@ -0,0 +1,29 @@
+#include "prof.h"
+#include "hardware/structs/systick.h"
+#include "hardware/clocks.h"
+
+// SysTick is per core: a 24-bit down-counter at the core clock
+
+#define SYST_CSR_ENABLE     (1u << 0)
+#define SYST_CSR_CLKSOURCE  (1u << 2)   // processor clock
+#define SYST_MAX            0x00FFFFFFu
+
+void prof_clock_init(void) {
+    systick_hw->csr = 0;
+    systick_hw->rvr = SYST_MAX;
+    systick_hw->cvr = 0;
+    systick_hw->csr = SYST_CSR_CLKSOURCE | SYST_CSR_ENABLE;
+}
+
+uint32_t prof_now(void) {
+    return SYST_MAX - systick_hw->cvr;
+}
+
+// ~134 ms at 125 MHz, far longer than any stage
+uint32_t prof_clock_mask(void) {
+    return SYST_MAX;
+}
+
+uint32_t prof_tick_hz(void) {
+    return clock_get_hz(clk_sys);
+}
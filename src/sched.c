@@ -0,0 +1,46 @@
+#include "sched.h"
+
+void sched_pacer_init(sched_pacer_t *p, uint32_t max_fps) {
+    p->shown = 0;
+    p->seen = 0;
+    p->seen_us = 0;
+    p->renders = 0;
+    p->superseded = 0;
+    p->last_us = 0;
+    sched_pacer_set_rate(p, max_fps);
+}
+
+void sched_pacer_set_rate(sched_pacer_t *p, uint32_t max_fps) {
+    p->period_us = max_fps ? (1000000u + max_fps / 2) / max_fps : 0;
+}
+
+sched_action_t sched_pacer_poll(sched_pacer_t *p, uint32_t newest,
+                                uint32_t now_us, uint32_t *wake_us) {
+    if (newest == p->shown) return SCHED_IDLE;
+    if (newest != p->seen) {
+        p->seen = newest;
+        p->seen_us = now_us;
+    }
+    if (!p->renders || !p->period_us) return SCHED_RENDER;
+
+    uint32_t due = p->last_us + p->period_us;
+    if ((int32_t)(now_us - due) < 0) {
+        *wake_us = due;
+        return SCHED_HOLD;
+    }
+    // due: draw a frame that came in since at once, an older one only
+    // if nothing fresher turns up within a quarter period
+    uint32_t stale = due + p->period_us / 4;
+    if ((int32_t)(p->seen_us - due) >= 0 || (int32_t)(now_us - stale) >= 0)
+        return SCHED_RENDER;
+    *wake_us = stale;
+    return SCHED_HOLD;
+}
+
+void sched_pacer_done(sched_pacer_t *p, uint32_t frame, uint32_t now_us) {
+    if (frame - p->shown > 1)
+        p->superseded += frame - p->shown - 1;
+    p->shown = frame;
+    p->last_us = now_us;
+    p->renders++;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Event-driven main loops. Neither core polls: each goes through its
+ * work, and if there was none it sleeps in WFE until an interrupt on
+ * that core or an SEV from the other one.
+ *
+ *   core 1  the output DMA interrupt SEVs after each audio block (new
+ *           samples in the histories, audio_path.h); the main loop
+ *           takes whatever windows are complete and sleeps again
+ *   core 0  core 1 SEVs when it publishes a band frame; USB, I2C and
+ *           the ADC DMA interrupts wake it too. The display pacer
+ *           below decides whether the newest frame is drawn now, held
+ *           for the frame-rate cap (with a timer to wake for it), or
+ *           was already shown
+ *
+ * Under the cap the pacer draws fresh frames rather than punctual
+ * ones: once a render is due, a frame that came in before that waits
+ * up to a quarter period for the next one, which is drawn as soon as
+ * it is published. Renders are never closer than the period, so the
+ * rate stays a little under the cap.
+ *
+ * An SEV that comes between the check and the WFE is not lost: it
+ * sets the event register and the WFE returns at once.
+ *
+ * Hardware-independent: the wait is the caller's, so host/sched_sim can
+ * run the same decisions against simulated events. Times are in
+ * microseconds, compared modulo 2^32.
+ */
+
+typedef enum {
+    SCHED_IDLE,     // nothing new: wait for the next event
+    SCHED_HOLD,     // a new frame waits for the rate cap: wake by *wake_us
+    SCHED_RENDER,   // draw the newest frame now
+} sched_action_t;
+
+typedef struct {
+    uint32_t period_us;     // least time between renders, 0 = no cap
+    uint32_t last_us;       // when the last render started
+    uint32_t shown;         // band frame on the display (0 = none yet)
+    uint32_t seen;          // newest frame poll has been given
+    uint32_t seen_us;       // and when it first was
+    uint32_t renders;
+    uint32_t superseded;    // frames published but never drawn
+} sched_pacer_t;
+
+// max_fps 0: draw every frame
+void sched_pacer_init(sched_pacer_t *p, uint32_t max_fps);
+
+// Change the cap; takes effect from the next render
+void sched_pacer_set_rate(sched_pacer_t *p, uint32_t max_fps);
+
+// What to do at now_us with `newest` the number of the newest published
+// band frame (band_exchange_t.published). Call on every wake: when it
+// first sees a frame is taken as when the frame came in.
+sched_action_t sched_pacer_poll(sched_pacer_t *p, uint32_t newest,
+                                uint32_t now_us, uint32_t *wake_us);
+
+// Frame `frame` went to the display at now_us
+void sched_pacer_done(sched_pacer_t *p, uint32_t frame, uint32_t now_us);
@@ -0,0 +1,109 @@
+#include "spsc.h"
+#include <string.h>
+
+/* ---------- Band frames ---------- */
+
+void band_exchange_publish(band_exchange_t *x, const int16_t *levels) {
+    uint32_t frame = x->published + 1;
+    band_slot_t *s = &x->slot[frame & 1];
+
+    s->seq++;                       // odd: write in progress
+    spsc_barrier();
+    s->data.frame = frame;
+    memcpy(s->data.levels, levels, sizeof(s->data.levels));
+    spsc_barrier();
+    s->seq++;                       // even: slot consistent
+    spsc_barrier();
+    x->published = frame;
+}
+
+bool band_exchange_read(band_exchange_t *x, band_frame_t *out) {
+    for (;;) {
+        uint32_t frame = x->published;
+        if (!frame) return false;
+
+        band_slot_t *s = &x->slot[frame & 1];
+        uint32_t seq = s->seq;
+        spsc_barrier();
+        if (seq & 1) continue;
+
+        memcpy(out, &s->data, sizeof(*out));
+        spsc_barrier();
+        if (s->seq == seq) return true;
+    }
+}
+
+/* ---------- Block ring ---------- */
+
+void block_ring_init(block_ring_t *r, uint32_t size) {
+    r->head = 0;
+    r->tail = 0;
+    r->dropped = 0;
+    r->late = 0;
+    r->mask = size - 1;
+}
+
+bool block_ring_push(block_ring_t *r) {
+    uint32_t head = r->head;
+    if (head + 1 - r->tail > r->mask) {
+        r->dropped++;
+        return false;
+    }
+    spsc_barrier();                 // block data before the index
+    r->head = head + 1;
+    return true;
+}
+
+int block_ring_acquire(block_ring_t *r) {
+    uint32_t tail = r->tail;
+    uint32_t pending = r->head - tail;
+    if (!pending) return -1;
+    if (pending > 1) r->late++;
+    spsc_barrier();                 // index before the block data
+    return (int)(tail & r->mask);
+}
+
+void block_ring_release(block_ring_t *r) {
+    spsc_barrier();                 // finish reading before handing back
+    r->tail++;
+}
+
+/* ---------- Sample history ---------- */
+
+void sample_ring_init(sample_ring_t *r, int16_t *buf, uint32_t size) {
+    r->buf = buf;
+    r->mask = size - 1;
+    r->written = 0;
+    r->writing = 0;
+}
+
+void sample_ring_write(sample_ring_t *r, const int16_t *s, uint32_t n) {
+    uint32_t w = r->written;
+    r->writing = w + n;
+    spsc_barrier();                 // claim before overwriting
+    for (uint32_t i = 0; i < n; i++)
+        r->buf[(w + i) & r->mask] = s[i];
+    spsc_barrier();                 // samples before the position
+    r->written = w + n;
+}
+
+// The span [end - n, end) is intact while it is no more than size
+// samples behind the append in progress
+static bool span_intact(const sample_ring_t *r, uint32_t end, uint32_t n) {
+    uint32_t ahead = r->writing - end;          // samples past the span
+    return ahead + n <= r->mask + 1;
+}
+
+bool sample_ring_read(const sample_ring_t *r, uint32_t end, int16_t *dst, uint32_t n) {
+    if ((int32_t)(r->written - end) < 0 || !span_intact(r, end, n))
+        return false;
+    spsc_barrier();                 // position before the samples
+
+    uint32_t start = end - n;
+    for (uint32_t i = 0; i < n; i++)
+        dst[i] = r->buf[(start + i) & r->mask];
+
+    // the producer may have lapped the span while we copied
+    spsc_barrier();
+    return span_intact(r, end, n);
+}
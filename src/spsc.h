@@ -0,0 +1,107 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "dsp_config.h"
+
+/*
+ * Lock-free single-producer / single-consumer handoff between cores
+ * (or between an ISR and a core). Hardware-independent: the only
+ * platform detail is the memory barrier.
+ */
+
+#if defined(__arm__)
+#define spsc_barrier() __asm volatile ("dmb" ::: "memory")
+#else
+#define spsc_barrier() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+/* ---------- Band frames (seqlock, double buffered) ---------- */
+
+typedef struct {
+    uint32_t frame;                 // 1, 2, 3... per published frame
+    int16_t  levels[NUM_BANDS];     // dBFS, Q8
+} band_frame_t;
+
+typedef struct {
+    volatile uint32_t seq;          // odd while the writer is in this slot
+    band_frame_t      data;
+} band_slot_t;
+
+typedef struct {
+    volatile uint32_t published;    // frame number of the newest complete frame
+    band_slot_t       slot[2];
+} band_exchange_t;
+
+// Writer (core 1): frame N goes to slot N & 1, so a reader copying the
+// newest frame only collides with the writer if it falls a whole frame
+// behind, in which case it retries.
+void band_exchange_publish(band_exchange_t *x, const int16_t *levels);
+
+// Reader (core 0): copy the newest complete frame into *out.
+// Returns false if nothing has been published yet.
+bool band_exchange_read(band_exchange_t *x, band_frame_t *out);
+
+/* ---------- Block ring ---------- */
+
+/*
+ * Counts blocks through a fixed pool of `size` buffers (power of two)
+ * that the producer fills in order. Block n lives in buffer n % size.
+ * The producer always owns buffer head % size, so at most size - 1
+ * blocks are queued; the consumer keeps the oldest one until it
+ * releases it.
+ */
+typedef struct {
+    volatile uint32_t head;         // blocks published (producer)
+    volatile uint32_t tail;         // blocks released (consumer)
+    volatile uint32_t dropped;      // blocks overwritten because the ring was full
+    volatile uint32_t late;         // blocks picked up with another already waiting
+    uint32_t          mask;         // size - 1
+} block_ring_t;
+
+void block_ring_init(block_ring_t *r, uint32_t size);
+
+// Producer: buffer index to fill next
+static inline uint32_t block_ring_write_slot(const block_ring_t *r) {
+    return r->head & r->mask;
+}
+
+// Producer: the block in block_ring_write_slot() is complete. Returns
+// false (and counts a drop) if the consumer is too far behind, in which
+// case the same buffer must be filled again.
+bool block_ring_push(block_ring_t *r);
+
+// Consumer: buffer index of the oldest queued block, or -1 if none
+int block_ring_acquire(block_ring_t *r);
+
+// Consumer: done with the block returned by block_ring_acquire()
+void block_ring_release(block_ring_t *r);
+
+// Blocks published and not yet released
+static inline uint32_t block_ring_pending(const block_ring_t *r) {
+    return r->head - r->tail;
+}
+
+/* ---------- Sample history ---------- */
+
+/*
+ * The last `size` samples (power of two) of a stream. The producer
+ * appends and never waits; the consumer copies out any span that has
+ * not been overwritten yet. Sample n lives in buf[n % size]; positions
+ * count samples since init and are compared modulo 2^32.
+ */
+typedef struct {
+    int16_t          *buf;
+    uint32_t          mask;         // size - 1
+    volatile uint32_t written;      // samples appended so far
+    volatile uint32_t writing;      // end of the append in progress
+} sample_ring_t;
+
+void sample_ring_init(sample_ring_t *r, int16_t *buf, uint32_t size);
+
+// Producer: append n samples
+void sample_ring_write(sample_ring_t *r, const int16_t *s, uint32_t n);
+
+// Consumer: copy the n samples before position end. Returns false if
+// they have not all been written yet, or were overwritten (before or
+// during the copy).
+bool sample_ring_read(const sample_ring_t *r, uint32_t end, int16_t *dst, uint32_t n);
@@ -0,0 +1,285 @@
+#include "telemetry.h"
+#include "params.h"
+
+#include <string.h>
+
+#define PARAM_NAME_MAX 16
+
+uint16_t tlm_crc16(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t)(*data++ << 8);
+        for (int i = 0; i < 8; i++)
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+/* ---------- Framing ---------- */
+
+size_t tlm_encode(const tlm_msg_t *msg, uint8_t *out) {
+    uint8_t raw[TLM_MAX_MSG];
+    size_t n = 0;
+
+    raw[n++] = msg->type;
+    raw[n++] = msg->seq;
+    memcpy(&raw[n], msg->payload, msg->len);
+    n += msg->len;
+    uint16_t crc = tlm_crc16(raw, n);
+    raw[n++] = (uint8_t)crc;
+    raw[n++] = (uint8_t)(crc >> 8);
+
+    // COBS: each code byte is the distance to the next zero
+    size_t o = 1, code_pos = 0;
+    uint8_t code = 1;
+    for (size_t i = 0; i < n; i++) {
+        if (raw[i]) {
+            out[o++] = raw[i];
+            code++;
+        }
+        if (!raw[i] || code == 0xFF) {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    out[o++] = 0x00;
+    return o;
+}
+
+void tlm_decoder_init(tlm_decoder_t *d) {
+    d->len = 0;
+    d->overflow = false;
+    d->bad = 0;
+}
+
+static bool cobs_decode(const uint8_t *in, size_t len, tlm_msg_t *msg) {
+    uint8_t raw[TLM_MAX_MSG];
+    size_t n = 0, i = 0;
+
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (!code || i + code - 1 > len) return false;
+        for (int k = 1; k < code; k++) {
+            if (n >= sizeof(raw)) return false;
+            raw[n++] = in[i++];
+        }
+        if (code < 0xFF && i < len) {
+            if (n >= sizeof(raw)) return false;
+            raw[n++] = 0;
+        }
+    }
+
+    if (n < 4) return false;
+    uint16_t crc = (uint16_t)(raw[n - 2] | (raw[n - 1] << 8));
+    if (tlm_crc16(raw, n - 2) != crc) return false;
+
+    msg->type = raw[0];
+    msg->seq = raw[1];
+    msg->len = (uint8_t)(n - 4);
+    memcpy(msg->payload, &raw[2], msg->len);
+    return true;
+}
+
+bool tlm_decode_byte(tlm_decoder_t *d, uint8_t byte, tlm_msg_t *msg) {
+    if (byte) {
+        if (d->len < sizeof(d->buf)) d->buf[d->len++] = byte;
+        else d->overflow = true;
+        return false;
+    }
+
+    // delimiter: an empty frame is just idle line / resync
+    bool ok = false;
+    if (d->len) {
+        ok = !d->overflow && cobs_decode(d->buf, d->len, msg);
+        if (!ok) d->bad++;
+    }
+    d->len = 0;
+    d->overflow = false;
+    return ok;
+}
+
+/* ---------- Payloads ---------- */
+
+void tlm_msg_init(tlm_msg_t *msg, uint8_t type, uint8_t seq) {
+    msg->type = type;
+    msg->seq = seq;
+    msg->len = 0;
+}
+
+void tlm_put_u8(tlm_msg_t *msg, uint8_t v) {
+    if (msg->len < TLM_MAX_PAYLOAD) msg->payload[msg->len++] = v;
+}
+
+void tlm_put_u16(tlm_msg_t *msg, uint16_t v) {
+    tlm_put_u8(msg, (uint8_t)v);
+    tlm_put_u8(msg, (uint8_t)(v >> 8));
+}
+
+void tlm_put_u32(tlm_msg_t *msg, uint32_t v) {
+    tlm_put_u16(msg, (uint16_t)v);
+    tlm_put_u16(msg, (uint16_t)(v >> 16));
+}
+
+void tlm_put_bytes(tlm_msg_t *msg, const uint8_t *data, size_t len) {
+    while (len--) tlm_put_u8(msg, *data++);
+}
+
+uint8_t tlm_get_u8(const tlm_msg_t *msg, size_t *pos) {
+    return *pos < msg->len ? msg->payload[(*pos)++] : 0;
+}
+
+uint16_t tlm_get_u16(const tlm_msg_t *msg, size_t *pos) {
+    uint16_t lo = tlm_get_u8(msg, pos);
+    return (uint16_t)(lo | (tlm_get_u8(msg, pos) << 8));
+}
+
+uint32_t tlm_get_u32(const tlm_msg_t *msg, size_t *pos) {
+    uint32_t lo = tlm_get_u16(msg, pos);
+    return lo | ((uint32_t)tlm_get_u16(msg, pos) << 16);
+}
+
+void tlm_pack_bands(tlm_msg_t *msg, uint32_t frame, const int16_t *levels, int count) {
+    tlm_put_u32(msg, frame);
+    for (int i = 0; i < count; i++)
+        tlm_put_u16(msg, (uint16_t)levels[i]);
+}
+
+int tlm_unpack_bands(const tlm_msg_t *msg, uint32_t *frame, int16_t *levels, int max) {
+    size_t pos = 0;
+    *frame = tlm_get_u32(msg, &pos);
+
+    int n = 0;
+    while (n < max && pos + 2 <= msg->len)
+        levels[n++] = (int16_t)tlm_get_u16(msg, &pos);
+    return n;
+}
+
+// Both structs are all uint32_t, in wire order
+void tlm_pack_stats(tlm_msg_t *msg, const tlm_stats_t *s) {
+    const uint32_t *w = (const uint32_t *)s;
+    for (size_t i = 0; i < sizeof(*s) / 4; i++) tlm_put_u32(msg, w[i]);
+}
+
+void tlm_unpack_stats(const tlm_msg_t *msg, tlm_stats_t *s) {
+    uint32_t *w = (uint32_t *)s;
+    size_t pos = 0;
+    for (size_t i = 0; i < sizeof(*s) / 4; i++) w[i] = tlm_get_u32(msg, &pos);
+}
+
+void tlm_pack_profile(tlm_msg_t *msg, uint8_t stage) {
+    tlm_put_u8(msg, stage);
+    if (stage >= PROF_STAGE_COUNT) {
+        tlm_put_u8(msg, PARAM_BAD_ID);
+        return;
+    }
+
+    prof_stat_t s;
+    prof_snapshot((prof_stage_t)stage, &s);
+
+    tlm_put_u8(msg, PARAM_OK);
+    tlm_put_u32(msg, prof_tick_hz());
+    tlm_put_u32(msg, s.count);
+    tlm_put_u32(msg, s.min);
+    tlm_put_u32(msg, s.max);
+    tlm_put_u32(msg, s.count ? (uint32_t)(s.sum / s.count) : 0);
+    tlm_put_u32(msg, s.deadline);
+    tlm_put_u32(msg, s.misses);
+    for (int b = 0; b < PROF_BUCKETS; b++) tlm_put_u32(msg, s.hist[b]);
+}
+
+int tlm_unpack_profile(const tlm_msg_t *msg, prof_stat_t *s, uint32_t *tick_hz) {
+    size_t pos = 0;
+    int stage = tlm_get_u8(msg, &pos);
+    if (tlm_get_u8(msg, &pos) != PARAM_OK) return -1;
+
+    *tick_hz = tlm_get_u32(msg, &pos);
+    s->count = tlm_get_u32(msg, &pos);
+    s->min = tlm_get_u32(msg, &pos);
+    s->max = tlm_get_u32(msg, &pos);
+    s->sum = tlm_get_u32(msg, &pos);
+    s->deadline = tlm_get_u32(msg, &pos);
+    s->misses = tlm_get_u32(msg, &pos);
+    for (int b = 0; b < PROF_BUCKETS; b++) s->hist[b] = tlm_get_u32(msg, &pos);
+    return stage;
+}
+
+/* ---------- Requests ---------- */
+
+bool tlm_handle_request(const tlm_msg_t *req, tlm_msg_t *reply) {
+    size_t pos = 0;
+    uint8_t id = tlm_get_u8(req, &pos);
+
+    if (req->type == TLM_PROF_GET || req->type == TLM_PROF_RESET) {
+        if (req->type == TLM_PROF_RESET) {
+            prof_reset();
+            id = 0;
+        }
+        tlm_msg_init(reply, TLM_PROFILE, req->seq);
+        tlm_pack_profile(reply, id);
+        return true;
+    }
+
+    if (req->type == TLM_SET_MANY) {
+        uint8_t count = id;
+        tlm_msg_init(reply, TLM_PARAMS, req->seq);
+        if (!count || count > TLM_SET_MANY_MAX || req->len != 1 + 5 * count) {
+            tlm_put_u8(reply, 0);
+            return true;
+        }
+        tlm_put_u8(reply, count);
+        params_write_begin();
+        for (int i = 0; i < count; i++) {
+            uint8_t pid = tlm_get_u8(req, &pos);
+            int32_t value = (int32_t)tlm_get_u32(req, &pos);
+            param_status_t status = pid < PARAM_COUNT ? param_set(pid, value, &value)
+                                                      : PARAM_BAD_ID;
+            tlm_put_u8(reply, pid);
+            tlm_put_u8(reply, (uint8_t)status);
+            tlm_put_u8(reply, status == PARAM_BAD_ID ? 0 : (uint8_t)param_defs[pid].type);
+            tlm_put_u32(reply, (uint32_t)value);
+        }
+        params_write_end();
+        return true;
+    }
+
+    // GET and INFO carry the id alone, SET the id and a value
+    size_t len = req->type == TLM_SET ? 5 : 1;
+    param_status_t status = req->len != len ? PARAM_BAD_REQUEST :
+                            id < PARAM_COUNT ? PARAM_OK : PARAM_BAD_ID;
+    int32_t value = 0;
+
+    switch (req->type) {
+        case TLM_GET:
+            if (status == PARAM_OK) value = param_get(id);
+            break;
+        case TLM_SET:
+            value = (int32_t)tlm_get_u32(req, &pos);
+            if (status == PARAM_OK) status = param_set(id, value, &value);
+            break;
+        case TLM_INFO:
+            tlm_msg_init(reply, TLM_PARAM_INFO, req->seq);
+            tlm_put_u8(reply, id);
+            tlm_put_u8(reply, (uint8_t)status);
+            if (status == PARAM_OK) {
+                const param_def_t *d = &param_defs[id];
+                tlm_put_u8(reply, (uint8_t)d->type);
+                tlm_put_u32(reply, (uint32_t)d->min);
+                tlm_put_u32(reply, (uint32_t)d->max);
+                tlm_put_u32(reply, (uint32_t)d->def);
+                for (int i = 0; d->name[i] && i < PARAM_NAME_MAX; i++)
+                    tlm_put_u8(reply, (uint8_t)d->name[i]);
+            }
+            return true;
+        default:
+            return false;
+    }
+
+    tlm_msg_init(reply, TLM_PARAM, req->seq);
+    tlm_put_u8(reply, id);
+    tlm_put_u8(reply, (uint8_t)status);
+    tlm_put_u8(reply, status > PARAM_CLAMPED ? 0 : (uint8_t)param_defs[id].type);
+    tlm_put_u32(reply, (uint32_t)value);
+    return true;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "prof.h"
+
+/*
+ * Binary telemetry / control protocol over the USB CDC link.
+ *
+ * Message:  type u8 | seq u8 | payload (0..TLM_MAX_PAYLOAD) | crc16 LE
+ * Wire:     COBS(message) 0x00
+ *
+ * CRC is CRC-16/CCITT-FALSE over type..payload. Multi-byte payload
+ * fields are little-endian. A receiver resynchronises on the next 0x00
+ * after any damaged frame. Hardware-independent: the device transport
+ * is debug_usb.c, the host side is host/tlm_cli.c.
+ */
+
+#define TLM_MAX_PAYLOAD  200
+#define TLM_MAX_MSG      (2 + TLM_MAX_PAYLOAD + 2)
+#define TLM_MAX_WIRE     (TLM_MAX_MSG + TLM_MAX_MSG / 254 + 2)   // COBS + delimiter
+
+typedef enum {
+    // device → host, unsolicited
+    TLM_BANDS      = 0x01,  // u32 frame, i16 levels[] (dBFS Q8)
+    TLM_STATS      = 0x02,  // tlm_stats_t
+    TLM_PROFILE    = 0x03,  // u8 stage, u8 status, u32 tick_hz, prof_stat_t (sum → mean)
+    TLM_CAPTURE    = 0x04,  // u32 block seq, u8 source, u8 chunk, u8 chunks, packed samples
+
+    // device → host, replies
+    TLM_PARAM      = 0x10,  // u8 id, u8 status, u8 type, i32 value
+    TLM_PARAM_INFO = 0x11,  // u8 id, u8 status, u8 type, i32 min, max, def, name
+    TLM_PARAMS     = 0x12,  // u8 count, count x (u8 id, u8 status, u8 type, i32 value)
+
+    // host → device
+    TLM_GET        = 0x20,  // u8 id
+    TLM_SET        = 0x21,  // u8 id, i32 value
+    TLM_INFO       = 0x22,  // u8 id
+    TLM_PROF_GET   = 0x23,  // u8 stage
+    TLM_PROF_RESET = 0x24,  // (no payload) replied to with TLM_PROFILE of stage 0
+    TLM_SET_MANY   = 0x25,  // u8 count, count x (u8 id, i32 value): one write
+} tlm_type_t;
+
+// Parameters in one TLM_SET_MANY, so that its TLM_PARAMS reply fits
+#define TLM_SET_MANY_MAX  ((TLM_MAX_PAYLOAD - 1) / 7)
+
+typedef struct {
+    uint8_t type;
+    uint8_t seq;
+    uint8_t len;
+    uint8_t payload[TLM_MAX_PAYLOAD];
+} tlm_msg_t;
+
+typedef struct {
+    uint32_t frame;         // band frames published by core 1
+    uint32_t adc_dropped;
+    uint32_t adc_late;
+    uint32_t disp_frames;   // display batches completed
+    uint32_t disp_errors;
+    uint32_t tx_dropped;    // telemetry frames dropped, TX ring full
+    uint32_t rx_bad;        // received frames failing COBS/CRC
+    uint32_t cap_dropped;   // capture blocks dropped, ring full
+    uint32_t audio_underruns;   // PWM blocks of silence, core 1 late
+    uint32_t audio_overruns;    // audio blocks dropped, output ring full
+    uint32_t audio_skipped;     // ADC blocks skipped to hold the latency
+    uint32_t win_dropped;       // analysis windows lost, core 1 too slow
+    uint32_t stft_hop;          // current analysis hop, samples
+} tlm_stats_t;
+
+uint16_t tlm_crc16(const uint8_t *data, size_t len);
+
+// Frame a message for the wire (COBS + trailing 0x00) into out, which
+// must hold TLM_MAX_WIRE bytes. Returns the wire length.
+size_t tlm_encode(const tlm_msg_t *msg, uint8_t *out);
+
+// ---- Receiver ----
+
+typedef struct {
+    uint8_t  buf[TLM_MAX_WIRE];
+    size_t   len;
+    bool     overflow;
+    uint32_t bad;           // frames dropped: COBS, length or CRC error
+} tlm_decoder_t;
+
+void tlm_decoder_init(tlm_decoder_t *d);
+
+// Feed one received byte. Returns true when it completes a valid
+// message, which is then in *msg.
+bool tlm_decode_byte(tlm_decoder_t *d, uint8_t byte, tlm_msg_t *msg);
+
+// ---- Payloads ----
+
+void tlm_msg_init(tlm_msg_t *msg, uint8_t type, uint8_t seq);
+void tlm_put_u8(tlm_msg_t *msg, uint8_t v);
+void tlm_put_u16(tlm_msg_t *msg, uint16_t v);
+void tlm_put_u32(tlm_msg_t *msg, uint32_t v);
+void tlm_put_bytes(tlm_msg_t *msg, const uint8_t *data, size_t len);
+
+// Read from payload offset *pos; missing bytes read as 0
+uint8_t  tlm_get_u8(const tlm_msg_t *msg, size_t *pos);
+uint16_t tlm_get_u16(const tlm_msg_t *msg, size_t *pos);
+uint32_t tlm_get_u32(const tlm_msg_t *msg, size_t *pos);
+
+void tlm_pack_bands(tlm_msg_t *msg, uint32_t frame, const int16_t *levels, int count);
+void tlm_pack_stats(tlm_msg_t *msg, const tlm_stats_t *s);
+void tlm_pack_profile(tlm_msg_t *msg, uint8_t stage);
+
+int  tlm_unpack_bands(const tlm_msg_t *msg, uint32_t *frame, int16_t *levels, int max);
+void tlm_unpack_stats(const tlm_msg_t *msg, tlm_stats_t *s);
+
+// Returns the stage (or -1 if the device reported a bad stage); mean
+// is returned in s->sum with s->count as is
+int  tlm_unpack_profile(const tlm_msg_t *msg, prof_stat_t *s, uint32_t *tick_hz);
+
+// Device side: answer a GET/SET/SET_MANY/INFO request from the params
+// table or a PROF_GET/PROF_RESET request. Returns false for anything
+// else. A GET, SET or INFO of the wrong length is answered with
+// PARAM_BAD_REQUEST. SET_MANY stores its parameters as one write
+// (params.h), bad ids left out; a malformed one is answered with a
+// count of 0.
+bool tlm_handle_request(const tlm_msg_t *req, tlm_msg_t *reply);
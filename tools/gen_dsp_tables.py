@@ -0,0 +1,283 @@
+#!/usr/bin/env python3
+"""Generate the fixed-point DSP tables for one analysis FFT size.
+
+Writes dsp_tables.h / dsp_tables.c into --out-dir. Run by CMake at
+build time (see dsp_core.cmake); the output is never checked in.
+
+Tables:
+  fft_bitrev_swaps     i < j swap pairs of the bit-reversal permutation
+  fft_twiddles         radix-4 stage twiddles, { W^k, W^2k, W^3k } per k
+  fft_split_twiddles   W^k for the real-FFT split pass
+  fft_stereo_swaps     bit reversal of the FFT_SIZE-point complex FFT
+  fft_stereo_twiddles  its radix-4 stage twiddles
+  dsp_window_hann      periodic Hann window, Q15
+  dsp_window_blackman  periodic Blackman window, Q15
+  dsp_band_map         bin -> display band (log spaced)
+  dsp_fb_bandpass      half-octave band-pass biquads of the filterbank, Q14
+  dsp_fb_lowpass       its 4th-order anti-alias low-pass (two biquads), Q14
+  dsp_log2_frac        log2(1 + i/32), Q15, for the fixed-point dB conversion
+  dsp_exp2_frac        2^(i/32), Q14, for the fixed-point dB -> gain conversion
+  dsp_softclip_lut     x / (1 + x) for x = 0..4 in 1/32 steps, Q15
+  dsp_sine_q30         quarter-wave sine, 256 steps, Q30 (effect EQ design)
+"""
+
+import argparse
+import math
+import os
+
+Q15_ONE = 32767
+
+
+def q15(x):
+    return max(-32768, min(Q15_ONE, int(round(x * Q15_ONE))))
+
+
+def twiddle(m, n):
+    """W_n^m = cos(2*pi*m/n) - j*sin(2*pi*m/n) in Q15."""
+    a = 2.0 * math.pi * m / n
+    return (q15(math.cos(a)), q15(-math.sin(a)))
+
+
+def bitrev_swaps(log2n):
+    n = 1 << log2n
+    pairs = []
+    for i in range(n):
+        j = int(format(i, "0%db" % log2n)[::-1], 2)
+        if i < j:
+            pairs.append((i, j))
+    return pairs
+
+
+def stage_twiddles(fft_size, cpx_log2):
+    """Radix-4 stages of a 2^cpx_log2-point complex kernel (FFT_SIZE/2
+    for the real FFT, FFT_SIZE for the stereo one).
+
+    Twiddles are expressed in units of the real transform size because
+    W_len = W_FFT_SIZE^(FFT_SIZE/len).
+    """
+    out = []
+    length = 8 if cpx_log2 & 1 else 4
+    while length <= (1 << cpx_log2):
+        q = length >> 2
+        step = fft_size // length
+        for k in range(1, q):
+            out.append(twiddle(k * step, fft_size))
+            out.append(twiddle(2 * k * step, fft_size))
+            out.append(twiddle(3 * k * step, fft_size))
+        length <<= 2
+    return out
+
+
+def band_edges(fft_size, num_bands):
+    """First bin of each band, geometrically spaced from bin 1 to N/2.
+
+    Bands are at least one bin wide, so the lowest bands of small FFTs
+    degrade to one bin each before the spacing becomes logarithmic.
+    """
+    half = fft_size // 2
+    edges = [1]
+    for b in range(1, num_bands):
+        geo = int(round(half ** (b / num_bands)))
+        edges.append(max(edges[-1] + 1, geo))
+    edges.append(half)
+    if edges[num_bands - 1] >= half:
+        raise ValueError("%d bins cannot hold %d bands" % (half - 1, num_bands))
+    return edges
+
+
+def band_map(fft_size, num_bands):
+    edges = band_edges(fft_size, num_bands)
+    out = [0] * (fft_size // 2)   # bin 0 (DC) is never used
+    for b in range(num_bands):
+        for i in range(edges[b], edges[b + 1]):
+            out[i] = b
+    return out
+
+
+def dbfs_offset_q8(fft_size):
+    """dB of the bin power of a full-scale Q15 sine, Q8.
+
+    A sine of amplitude 2^15 lands in one bin with magnitude 2^15 * N/2.
+    """
+    return int(round(256 * 20.0 * math.log10(32768.0 * fft_size / 2)))
+
+
+def window_loss_q8(w):
+    """dB (Q8) a window takes off the band power of a sine, from its
+    energy N / sum(w^2): bands add up every bin the main lobe spreads
+    over, so the energy, not the peak, is what gets lost.
+    """
+    energy = sum((v / 32768.0) ** 2 for v in w)
+    return int(round(256 * 10.0 * math.log10(len(w) / energy)))
+
+
+# Filterbank: every octave runs at half the rate of the one above, so
+# one pair of band-pass filters (centres as a share of the octave's own
+# rate) and one decimation low-pass serve all of them
+FB_CENTRES = (0.3, 0.3 / math.sqrt(2.0))
+FB_LOWPASS = 0.2
+FB_Q14 = 1 << 14
+
+
+def biquad_q14(b, a):
+    """[b0, b1, b2, a1, a2] / a0 in Q14.
+
+    Each product is at most 2^14 * 2^15; with the coefficient magnitudes
+    summing below 4 the int32 accumulator in dsp_fb.c cannot overflow.
+    """
+    c = [b[0] / a[0], b[1] / a[0], b[2] / a[0], a[1] / a[0], a[2] / a[0]]
+    q = [int(round(v * FB_Q14)) for v in c]
+    if sum(abs(v) for v in q) >= 4 * FB_Q14:
+        raise ValueError("biquad coefficients too large for Q14")
+    return q
+
+
+def fb_bandpass(f):
+    """Half-octave band-pass, 0 dB at the centre (RBJ cookbook)."""
+    w0 = 2.0 * math.pi * f
+    q = math.sqrt(2.0 ** 0.5) / (2.0 ** 0.5 - 1.0)
+    alpha = math.sin(w0) / (2.0 * q)
+    return biquad_q14((alpha, 0.0, -alpha),
+                      (1.0 + alpha, -2.0 * math.cos(w0), 1.0 - alpha))
+
+
+def fb_lowpass(f):
+    """4th-order Butterworth low-pass as two biquads."""
+    out = []
+    for q in (0.5411961, 1.3065630):
+        w0 = 2.0 * math.pi * f
+        alpha = math.sin(w0) / (2.0 * q)
+        c = 1.0 - math.cos(w0)
+        out.append(biquad_q14((c / 2.0, c, c / 2.0),
+                              (1.0 + alpha, -2.0 * math.cos(w0), 1.0 - alpha)))
+    return out
+
+
+def fmt_rows(items, per_row, fmt):
+    lines = []
+    for r in range(0, len(items), per_row):
+        lines.append("    " + " ".join(fmt(x) + "," for x in items[r:r + per_row]))
+    return "\n".join(lines)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--fft-size", type=int, required=True)
+    ap.add_argument("--bands", type=int, default=16)
+    ap.add_argument("--out-dir", required=True)
+    args = ap.parse_args()
+
+    n = args.fft_size
+    if n < 128 or n > 2048 or n & (n - 1):
+        ap.error("--fft-size must be a power of two in 128..2048")
+    log2n = n.bit_length() - 1
+    cpx_log2 = log2n - 1
+
+    swaps = bitrev_swaps(cpx_log2)
+    tw = stage_twiddles(n, cpx_log2)
+    split = [twiddle(k, n) for k in range(n // 4 + 1)]
+    st_swaps = bitrev_swaps(log2n)
+    st_tw = stage_twiddles(n, log2n)
+    hann = [q15(0.5 - 0.5 * math.cos(2.0 * math.pi * i / n)) for i in range(n)]
+    blackman = [q15(0.42 - 0.5 * math.cos(2.0 * math.pi * i / n)
+                    + 0.08 * math.cos(4.0 * math.pi * i / n)) for i in range(n)]
+    bands = band_map(n, args.bands)
+    log2_frac = [int(round(32768 * math.log2(1.0 + i / 32.0))) for i in range(33)]
+    exp2_frac = [int(round(16384 * 2.0 ** (i / 32.0))) for i in range(33)]
+    softclip = [q15((i / 32.0) / (1.0 + i / 32.0)) for i in range(129)]
+    sine = [int(round((1 << 30) * math.sin(0.5 * math.pi * i / 256))) for i in range(257)]
+    fb_bp = [fb_bandpass(f) for f in FB_CENTRES]
+    fb_lp = fb_lowpass(FB_LOWPASS)
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    tag = "generated by tools/gen_dsp_tables.py --fft-size %d --bands %d" % (n, args.bands)
+
+    with open(os.path.join(args.out_dir, "dsp_tables.h"), "w") as f:
+        f.write("""#pragma once
+// {tag}
+#include <stdint.h>
+#include "dsp_fft.h"
+
+#define DSP_TABLES_FFT_SIZE   {n}
+#define DSP_TABLES_NUM_BANDS  {bands}
+
+#define FFT_LOG2              {log2n}
+#define FFT_CPX_LOG2          {cpx_log2}
+#define FFT_NUM_SWAPS         {nswaps}
+#define FFT_NUM_TWIDDLES      {ntw}
+#define FFT_STEREO_NUM_SWAPS  {st_nswaps}
+#define FFT_STEREO_NUM_TWIDDLES {st_ntw}
+
+// dB (Q8) of the band power of a full-scale sine: subtract for dBFS
+#define DSP_DBFS_OFFSET_Q8    {dbfs}
+
+// dB (Q8) each window takes off the band power: add back for dBFS
+#define DSP_HANN_LOSS_Q8      {hann_loss}
+#define DSP_BLACKMAN_LOSS_Q8  {blackman_loss}
+
+// Filterbank band centres, per mille of the octave's sample rate
+#define DSP_FB_CENTRE_UPPER   {fb_upper}
+#define DSP_FB_CENTRE_LOWER   {fb_lower}
+
+#if DSP_TABLES_FFT_SIZE != FFT_SIZE || DSP_TABLES_NUM_BANDS != NUM_BANDS
+#error "dsp_tables.h was generated for a different configuration"
+#endif
+
+extern const uint16_t fft_bitrev_swaps[FFT_NUM_SWAPS][2];
+extern const cpx16_t  fft_twiddles[FFT_NUM_TWIDDLES];
+extern const cpx16_t  fft_split_twiddles[FFT_SIZE / 4 + 1];
+extern const uint16_t fft_stereo_swaps[FFT_STEREO_NUM_SWAPS][2];
+extern const cpx16_t  fft_stereo_twiddles[FFT_STEREO_NUM_TWIDDLES];
+extern const int16_t  dsp_window_hann[FFT_SIZE];
+extern const int16_t  dsp_window_blackman[FFT_SIZE];
+extern const uint8_t  dsp_band_map[FFT_SIZE / 2];
+extern const uint16_t dsp_log2_frac[33];
+extern const uint16_t dsp_exp2_frac[33];
+extern const int16_t  dsp_softclip_lut[129];
+extern const int32_t  dsp_sine_q30[257];
+extern const int16_t  dsp_fb_bandpass[2][5];
+extern const int16_t  dsp_fb_lowpass[2][5];
+""".format(tag=tag, n=n, bands=args.bands, log2n=log2n, cpx_log2=cpx_log2,
+           nswaps=len(swaps), ntw=max(len(tw), 1),
+           st_nswaps=len(st_swaps), st_ntw=max(len(st_tw), 1), dbfs=dbfs_offset_q8(n),
+           hann_loss=window_loss_q8(hann), blackman_loss=window_loss_q8(blackman),
+           fb_upper=int(round(1000 * FB_CENTRES[0])),
+           fb_lower=int(round(1000 * FB_CENTRES[1]))))
+
+    cpx = lambda c: "{ %6d, %6d }" % c
+    with open(os.path.join(args.out_dir, "dsp_tables.c"), "w") as f:
+        f.write("// %s\n#include \"dsp_tables.h\"\n\n" % tag)
+        f.write("const uint16_t fft_bitrev_swaps[FFT_NUM_SWAPS][2] = {\n%s\n};\n\n"
+                % fmt_rows(swaps, 4, lambda p: "{ %4d, %4d }" % p))
+        f.write("const cpx16_t fft_twiddles[FFT_NUM_TWIDDLES] = {\n%s\n};\n\n"
+                % (fmt_rows(tw, 3, cpx) if tw else "    { 0, 0 },"))
+        f.write("const cpx16_t fft_split_twiddles[FFT_SIZE / 4 + 1] = {\n%s\n};\n\n"
+                % fmt_rows(split, 4, cpx))
+        f.write("const uint16_t fft_stereo_swaps[FFT_STEREO_NUM_SWAPS][2] = {\n%s\n};\n\n"
+                % fmt_rows(st_swaps, 4, lambda p: "{ %4d, %4d }" % p))
+        f.write("const cpx16_t fft_stereo_twiddles[FFT_STEREO_NUM_TWIDDLES] = {\n%s\n};\n\n"
+                % (fmt_rows(st_tw, 3, cpx) if st_tw else "    { 0, 0 },"))
+        f.write("const int16_t dsp_window_hann[FFT_SIZE] = {\n%s\n};\n\n"
+                % fmt_rows(hann, 8, lambda v: "%6d" % v))
+        f.write("const int16_t dsp_window_blackman[FFT_SIZE] = {\n%s\n};\n\n"
+                % fmt_rows(blackman, 8, lambda v: "%6d" % v))
+        f.write("const uint8_t dsp_band_map[FFT_SIZE / 2] = {\n%s\n};\n\n"
+                % fmt_rows(bands, 16, lambda v: "%2d" % v))
+        f.write("const uint16_t dsp_log2_frac[33] = {\n%s\n};\n\n"
+                % fmt_rows(log2_frac, 8, lambda v: "%5d" % v))
+        f.write("const uint16_t dsp_exp2_frac[33] = {\n%s\n};\n\n"
+                % fmt_rows(exp2_frac, 8, lambda v: "%5d" % v))
+        f.write("const int16_t dsp_softclip_lut[129] = {\n%s\n};\n\n"
+                % fmt_rows(softclip, 8, lambda v: "%5d" % v))
+        f.write("const int32_t dsp_sine_q30[257] = {\n%s\n};\n\n"
+                % fmt_rows(sine, 6, lambda v: "%10d" % v))
+        coeffs = lambda c: "{ %s }" % ", ".join("%6d" % v for v in c)
+        f.write("// { b0, b1, b2, a1, a2 }, upper band first\n")
+        f.write("const int16_t dsp_fb_bandpass[2][5] = {\n%s\n};\n\n"
+                % fmt_rows(fb_bp, 1, coeffs))
+        f.write("const int16_t dsp_fb_lowpass[2][5] = {\n%s\n};\n"
+                % fmt_rows(fb_lp, 1, coeffs))
+
+
+if __name__ == "__main__":
+    main()